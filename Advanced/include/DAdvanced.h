@@ -16,5 +16,6 @@
 #include "DFastLine.h"
 #include "DGeodesicAttributes.h"
 #include "DAreaOpen.h"
+#include "DTiledImage.h"
 
 #endif //__DADVANCED_H__
@@ -0,0 +1,30 @@
+#ifndef __DTILED_IMAGE_H__
+#define __DTILED_IMAGE_H__
+
+#include "Core/include/DCore.h"
+
+namespace smil
+{
+  /**
+   * @ingroup    Advanced
+   * @addtogroup AdvTiledImage
+   * @brief      Out-of-core images
+   *
+   * @details A TiledImage stores a volume larger than the available memory as
+   * bricks kept in a swap file, with a cache of the most recently used ones.
+   *
+   * Operators whose result on a pixel only depends on a bounded neighbourhood
+   * (arithmetic, threshold, dilation and erosion, convolution...) are run brick
+   * after brick by tiledProcess(), each brick being grown by a halo of
+   * neighbour pixels. The result is the same as on the whole image.
+   *
+   * @{ */
+
+
+  /** @} */
+} // namespace smil
+
+#include "private/TiledImage/DTiledImage.hpp"
+#include "private/TiledImage/DTiledOperations.hpp"
+
+#endif
@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_TILED_IMAGE_HPP
+#define _D_TILED_IMAGE_HPP
+
+#include <cstdio>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Core/include/DCore.h"
+
+namespace smil
+{
+  /**
+   * @addtogroup AdvTiledImage
+   *
+   * @{
+   */
+
+  /**
+   * Out-of-core 3D image
+   *
+   * The image is split into bricks of @b brickSize pixels along each axis,
+   * stored in a swap file. Only the most recently used bricks are kept in
+   * memory, within a cache of @b cacheSize bytes; modified bricks are written
+   * back to the swap file when they leave the cache.
+   *
+   * Bricks which were never written read as zeros and take no room in the
+   * swap file.
+   *
+   * @note
+   * A TiledImage isn't thread-safe. Operators run on it brick after brick (see
+   * tiledProcess()), each brick being processed in parallel as a usual image.
+   */
+  template <class T> class TiledImage
+  {
+  public:
+    /**
+     * Constructor
+     *
+     * @param[in] width, height, depth : image size
+     * @param[in] brickSize : brick side, in pixels
+     * @param[in] cacheSize : memory used by the brick cache, in bytes
+     * @param[in] swapFile : name of the swap file (an anonymous temporary file
+     * if NULL). It is removed by the destructor.
+     */
+    TiledImage(size_t width, size_t height, size_t depth = 1,
+               size_t brickSize = 64, size_t cacheSize = size_t(1) << 30,
+               const char *swapFile = NULL)
+        : width(width), height(height), depth(depth), fp(NULL)
+    {
+      brickW = std::min(std::max(brickSize, size_t(1)), width);
+      brickH = std::min(std::max(brickSize, size_t(1)), height);
+      brickD = std::min(std::max(brickSize, size_t(1)), depth);
+      brickPixNbr = brickW * brickH * brickD;
+
+      brickNbrX = (width + brickW - 1) / brickW;
+      brickNbrY = (height + brickH - 1) / brickH;
+      brickNbrZ = (depth + brickD - 1) / brickD;
+      stored.resize(brickNbrX * brickNbrY * brickNbrZ, false);
+
+      setCacheSize(cacheSize);
+
+      if (swapFile) {
+        swapFileName = swapFile;
+        fp           = fopen(swapFile, "w+b");
+      } else
+        fp = tmpfile();
+      if (!fp)
+        ERR_MSG("Cannot create the swap file");
+    }
+
+    ~TiledImage()
+    {
+      if (!fp)
+        return;
+      fclose(fp);
+      if (!swapFileName.empty())
+        remove(swapFileName.c_str());
+    }
+
+    bool isAllocated() const
+    {
+      return fp != NULL;
+    }
+
+    size_t getWidth() const
+    {
+      return width;
+    }
+    size_t getHeight() const
+    {
+      return height;
+    }
+    size_t getDepth() const
+    {
+      return depth;
+    }
+    size_t getPixelCount() const
+    {
+      return width * height * depth;
+    }
+
+    //! Size of the bricks along x, y and z
+    void getBrickSize(size_t *s) const
+    {
+      s[0] = brickW;
+      s[1] = brickH;
+      s[2] = brickD;
+    }
+    size_t getBrickCount() const
+    {
+      return stored.size();
+    }
+
+    //! Set the memory used by the brick cache (at least one brick is kept)
+    void setCacheSize(size_t cacheSize)
+    {
+      maxCachedBricks = std::max(cacheSize / (brickPixNbr * sizeof(T)),
+                                 size_t(1));
+      while (cache.size() > maxCachedBricks)
+        evictBrick();
+    }
+
+    /**
+     * Copy the region of origin (x0, y0, z0) and of the size of @b imOut
+     * into @b imOut
+     */
+    RES_T readRegion(size_t x0, size_t y0, size_t z0, Image<T> &imOut)
+    {
+      ASSERT_ALLOCATED(&imOut);
+      ASSERT(isAllocated(), RES_ERR_IO);
+      ASSERT(x0 + imOut.getWidth() <= width &&
+                 y0 + imOut.getHeight() <= height &&
+                 z0 + imOut.getDepth() <= depth,
+             "Region out of the image", RES_ERR);
+
+      ImageFreezer freeze(imOut);
+      return transfer(imOut, 0, 0, 0, imOut.getWidth(), imOut.getHeight(),
+                      imOut.getDepth(), x0, y0, z0, false);
+    }
+
+    /**
+     * Copy the region of origin (ix0, iy0, iz0) and of size (w, h, d) of @b
+     * imIn at (x0, y0, z0)
+     */
+    RES_T writeRegion(const Image<T> &imIn, size_t ix0, size_t iy0,
+                      size_t iz0, size_t w, size_t h, size_t d, size_t x0,
+                      size_t y0, size_t z0)
+    {
+      ASSERT_ALLOCATED(&imIn);
+      ASSERT(isAllocated(), RES_ERR_IO);
+      ASSERT(ix0 + w <= imIn.getWidth() && iy0 + h <= imIn.getHeight() &&
+                 iz0 + d <= imIn.getDepth(),
+             "Region out of the input image", RES_ERR);
+      ASSERT(x0 + w <= width && y0 + h <= height && z0 + d <= depth,
+             "Region out of the image", RES_ERR);
+
+      return transfer(const_cast<Image<T> &>(imIn), ix0, iy0, iz0, w, h, d,
+                      x0, y0, z0, true);
+    }
+
+    //! Copy a whole image, of the same size
+    RES_T fromImage(const Image<T> &imIn)
+    {
+      ASSERT(imIn.getWidth() == width && imIn.getHeight() == height &&
+                 imIn.getDepth() == depth,
+             "Images must have the same size", RES_ERR);
+      return writeRegion(imIn, 0, 0, 0, width, height, depth, 0, 0, 0);
+    }
+
+    //! Copy the whole image into @b imOut (which is resized)
+    RES_T toImage(Image<T> &imOut)
+    {
+      ASSERT((imOut.setSize(width, height, depth) == RES_OK),
+             RES_ERR_BAD_ALLOCATION);
+      return readRegion(0, 0, 0, imOut);
+    }
+
+    RES_T fill(const T &value)
+    {
+      ASSERT(isAllocated(), RES_ERR_IO);
+      for (size_t i = 0; i < stored.size(); i++) {
+        T *data = getBrick(i, true);
+        ASSERT(data, RES_ERR_IO);
+        std::fill(data, data + brickPixNbr, value);
+      }
+      return RES_OK;
+    }
+
+    T getPixel(size_t x, size_t y, size_t z = 0)
+    {
+      if (x >= width || y >= height || z >= depth)
+        return T(0);
+      T *data = getBrick(brickIndex(x, y, z), false);
+      return data ? data[pixelOffset(x, y, z)] : T(0);
+    }
+
+    RES_T setPixel(size_t x, size_t y, size_t z, const T &value)
+    {
+      ASSERT(x < width && y < height && z < depth, RES_ERR);
+      T *data = getBrick(brickIndex(x, y, z), true);
+      ASSERT(data, RES_ERR_IO);
+      data[pixelOffset(x, y, z)] = value;
+      return RES_OK;
+    }
+
+    //! Write all the modified bricks to the swap file
+    RES_T flush()
+    {
+      typename map<size_t, CachedBrick>::iterator it;
+      for (it = cache.begin(); it != cache.end(); it++)
+        if (it->second.dirty) {
+          ASSERT((storeBrick(it->first, it->second) == RES_OK), RES_ERR_IO);
+        }
+      return RES_OK;
+    }
+
+  protected:
+    struct CachedBrick {
+      vector<T> data;
+      bool dirty;
+      list<size_t>::iterator lruPos;
+    };
+
+    size_t width, height, depth;
+    size_t brickW, brickH, brickD, brickPixNbr;
+    size_t brickNbrX, brickNbrY, brickNbrZ;
+
+    FILE *fp;
+    string swapFileName;
+    // Bricks having a copy in the swap file
+    vector<bool> stored;
+
+    map<size_t, CachedBrick> cache;
+    // Cached bricks, most recently used first
+    list<size_t> lru;
+    size_t maxCachedBricks;
+
+    size_t brickIndex(size_t x, size_t y, size_t z) const
+    {
+      return ((z / brickD) * brickNbrY + y / brickH) * brickNbrX + x / brickW;
+    }
+    size_t pixelOffset(size_t x, size_t y, size_t z) const
+    {
+      return ((z % brickD) * brickH + y % brickH) * brickW + x % brickW;
+    }
+
+    // Copy between a region of an image and the bricks
+    RES_T transfer(Image<T> &im, size_t ix0, size_t iy0, size_t iz0, size_t w,
+                   size_t h, size_t d, size_t x0, size_t y0, size_t z0,
+                   bool toBricks)
+    {
+      if (w == 0 || h == 0 || d == 0)
+        return RES_OK;
+
+      typename Image<T>::volType slices = im.getSlices();
+
+      // Bricks are visited one after the other, so that each is loaded once
+      for (size_t bz = z0 / brickD; bz <= (z0 + d - 1) / brickD; bz++)
+        for (size_t by = y0 / brickH; by <= (y0 + h - 1) / brickH; by++)
+          for (size_t bx = x0 / brickW; bx <= (x0 + w - 1) / brickW; bx++) {
+            size_t xs = std::max(x0, bx * brickW);
+            size_t xe = std::min(x0 + w, (bx + 1) * brickW);
+            size_t ys = std::max(y0, by * brickH);
+            size_t ye = std::min(y0 + h, (by + 1) * brickH);
+            size_t zs = std::max(z0, bz * brickD);
+            size_t ze = std::min(z0 + d, (bz + 1) * brickD);
+
+            T *data = getBrick((bz * brickNbrY + by) * brickNbrX + bx, toBricks);
+            ASSERT(data, RES_ERR_IO);
+
+            for (size_t z = zs; z < ze; z++)
+              for (size_t y = ys; y < ye; y++) {
+                T *brickLine = data + pixelOffset(xs, y, z);
+                T *imLine    = slices[z - z0 + iz0][y - y0 + iy0] + xs - x0 + ix0;
+                if (toBricks)
+                  std::copy(imLine, imLine + (xe - xs), brickLine);
+                else
+                  std::copy(brickLine, brickLine + (xe - xs), imLine);
+              }
+          }
+      return RES_OK;
+    }
+
+    // Pixels of a brick, loaded into the cache if needed
+    T *getBrick(size_t index, bool modify)
+    {
+      typename map<size_t, CachedBrick>::iterator it = cache.find(index);
+
+      if (it != cache.end()) {
+        lru.splice(lru.begin(), lru, it->second.lruPos);
+      } else {
+        while (cache.size() >= maxCachedBricks)
+          if (evictBrick() != RES_OK)
+            return NULL;
+
+        it = cache.insert(make_pair(index, CachedBrick())).first;
+        CachedBrick &brick = it->second;
+        brick.data.resize(brickPixNbr, T(0));
+        brick.dirty = false;
+        lru.push_front(index);
+        brick.lruPos = lru.begin();
+
+        if (stored[index] && (seekBrick(index) != 0 ||
+                              fread(brick.data.data(), sizeof(T), brickPixNbr,
+                                    fp) != brickPixNbr)) {
+          ERR_MSG("Error reading the swap file");
+          lru.pop_front();
+          cache.erase(it);
+          return NULL;
+        }
+      }
+
+      if (modify)
+        it->second.dirty = true;
+      return it->second.data.data();
+    }
+
+    RES_T storeBrick(size_t index, CachedBrick &brick)
+    {
+      if (seekBrick(index) != 0 ||
+          fwrite(brick.data.data(), sizeof(T), brickPixNbr, fp) !=
+              brickPixNbr) {
+        ERR_MSG("Error writing the swap file");
+        return RES_ERR_IO;
+      }
+      stored[index] = true;
+      brick.dirty   = false;
+      return RES_OK;
+    }
+
+    // Remove the least recently used brick from the cache
+    RES_T evictBrick()
+    {
+      size_t index = lru.back();
+      typename map<size_t, CachedBrick>::iterator it = cache.find(index);
+
+      if (it->second.dirty) {
+        ASSERT((storeBrick(index, it->second) == RES_OK), RES_ERR_IO);
+      }
+
+      lru.pop_back();
+      cache.erase(it);
+      return RES_OK;
+    }
+
+    int seekBrick(size_t index)
+    {
+      UINT64 offset = UINT64(index) * brickPixNbr * sizeof(T);
+#ifdef _WIN32
+      return _fseeki64(fp, __int64(offset), SEEK_SET);
+#else  // _WIN32
+      return fseeko(fp, off_t(offset), SEEK_SET);
+#endif // _WIN32
+    }
+
+  private:
+    TiledImage(const TiledImage<T> &);
+    TiledImage<T> &operator=(const TiledImage<T> &);
+  };
+
+  /** @cond */
+  // Extent of the brick of index (bx, by, bz), grown by halo pixels and
+  // clipped to the image. The y origin is kept even, as hexagonal structuring
+  // elements depend on the parity of the lines.
+  template <class T>
+  void tiledBrickExtent(const TiledImage<T> &im, size_t bx, size_t by,
+                        size_t bz, size_t halo, size_t *core, size_t *ext)
+  {
+    size_t imSize[3] = {im.getWidth(), im.getHeight(), im.getDepth()};
+    size_t bSize[3], b[3] = {bx, by, bz};
+    im.getBrickSize(bSize);
+
+    for (int i = 0; i < 3; i++) {
+      core[i]     = b[i] * bSize[i];
+      core[i + 3] = std::min(core[i] + bSize[i], imSize[i]);
+      ext[i]      = core[i] > halo ? core[i] - halo : 0;
+      ext[i + 3]  = std::min(core[i + 3] + halo, imSize[i]);
+    }
+    ext[1] -= ext[1] % 2;
+  }
+  /** @endcond */
+
+  /**
+   * Run an operator on a TiledImage, brick after brick
+   *
+   * Each brick, grown by @b halo pixels on each side, is read into an image
+   * and processed by @b func, called as <tt>func(imIn, imOut)</tt>. The inner
+   * part of the result is then written into @b imOut. As long as @b halo is
+   * larger than the reach of the operator, the result is the same as the one
+   * on the whole image.
+   *
+   * @param[in] imIn : input image
+   * @param[in] halo : number of neighbour pixels needed on each side
+   * @param[in] func : functor applied to each brick
+   * @param[out] imOut : output image (of the same size, but not imIn)
+   */
+  template <class T1, class T2, class F>
+  RES_T tiledProcess(TiledImage<T1> &imIn, size_t halo, F &func,
+                     TiledImage<T2> &imOut)
+  {
+    ASSERT((void *) &imIn != (void *) &imOut,
+           "Input and output images must be different", RES_ERR);
+    ASSERT(imIn.getWidth() == imOut.getWidth() &&
+               imIn.getHeight() == imOut.getHeight() &&
+               imIn.getDepth() == imOut.getDepth(),
+           "Images must have the same size", RES_ERR);
+
+    size_t bSize[3];
+    imOut.getBrickSize(bSize);
+    size_t nbx = (imOut.getWidth() + bSize[0] - 1) / bSize[0];
+    size_t nby = (imOut.getHeight() + bSize[1] - 1) / bSize[1];
+    size_t nbz = (imOut.getDepth() + bSize[2] - 1) / bSize[2];
+
+    // Created once: object registration is costly and not thread-safe
+    Image<T1> brickIn;
+    Image<T2> brickOut;
+    size_t core[6], ext[6];
+
+    for (size_t bz = 0; bz < nbz; bz++)
+      for (size_t by = 0; by < nby; by++)
+        for (size_t bx = 0; bx < nbx; bx++) {
+          tiledBrickExtent(imOut, bx, by, bz, halo, core, ext);
+          size_t w = ext[3] - ext[0], h = ext[4] - ext[1], d = ext[5] - ext[2];
+
+          ASSERT((brickIn.setSize(w, h, d) == RES_OK), RES_ERR_BAD_ALLOCATION);
+          ASSERT((brickOut.setSize(w, h, d) == RES_OK), RES_ERR_BAD_ALLOCATION);
+          ASSERT((imIn.readRegion(ext[0], ext[1], ext[2], brickIn) == RES_OK));
+          ASSERT((func(brickIn, brickOut) == RES_OK));
+          ASSERT((imOut.writeRegion(brickOut, core[0] - ext[0],
+                                    core[1] - ext[1], core[2] - ext[2],
+                                    core[3] - core[0], core[4] - core[1],
+                                    core[5] - core[2], core[0], core[1],
+                                    core[2]) == RES_OK));
+        }
+    return RES_OK;
+  }
+
+  /**
+   * Run an operator with two input images on TiledImages, brick after brick
+   *
+   * Same as tiledProcess(), @b func being called as
+   * <tt>func(imIn1, imIn2, imOut)</tt>.
+   */
+  template <class T1, class T2, class F>
+  RES_T tiledProcess(TiledImage<T1> &imIn1, TiledImage<T1> &imIn2,
+                     size_t halo, F &func, TiledImage<T2> &imOut)
+  {
+    ASSERT((void *) &imIn1 != (void *) &imOut &&
+               (void *) &imIn2 != (void *) &imOut,
+           "Input and output images must be different", RES_ERR);
+    ASSERT(imIn1.getWidth() == imOut.getWidth() &&
+               imIn1.getHeight() == imOut.getHeight() &&
+               imIn1.getDepth() == imOut.getDepth() &&
+               imIn2.getWidth() == imOut.getWidth() &&
+               imIn2.getHeight() == imOut.getHeight() &&
+               imIn2.getDepth() == imOut.getDepth(),
+           "Images must have the same size", RES_ERR);
+
+    size_t bSize[3];
+    imOut.getBrickSize(bSize);
+    size_t nbx = (imOut.getWidth() + bSize[0] - 1) / bSize[0];
+    size_t nby = (imOut.getHeight() + bSize[1] - 1) / bSize[1];
+    size_t nbz = (imOut.getDepth() + bSize[2] - 1) / bSize[2];
+
+    Image<T1> brickIn1, brickIn2;
+    Image<T2> brickOut;
+    size_t core[6], ext[6];
+
+    for (size_t bz = 0; bz < nbz; bz++)
+      for (size_t by = 0; by < nby; by++)
+        for (size_t bx = 0; bx < nbx; bx++) {
+          tiledBrickExtent(imOut, bx, by, bz, halo, core, ext);
+          size_t w = ext[3] - ext[0], h = ext[4] - ext[1], d = ext[5] - ext[2];
+
+          ASSERT((brickIn1.setSize(w, h, d) == RES_OK), RES_ERR_BAD_ALLOCATION);
+          ASSERT((brickIn2.setSize(w, h, d) == RES_OK), RES_ERR_BAD_ALLOCATION);
+          ASSERT((brickOut.setSize(w, h, d) == RES_OK), RES_ERR_BAD_ALLOCATION);
+          ASSERT((imIn1.readRegion(ext[0], ext[1], ext[2], brickIn1) == RES_OK));
+          ASSERT((imIn2.readRegion(ext[0], ext[1], ext[2], brickIn2) == RES_OK));
+          ASSERT((func(brickIn1, brickIn2, brickOut) == RES_OK));
+          ASSERT((imOut.writeRegion(brickOut, core[0] - ext[0],
+                                    core[1] - ext[1], core[2] - ext[2],
+                                    core[3] - core[0], core[4] - core[1],
+                                    core[5] - core[2], core[0], core[1],
+                                    core[2]) == RES_OK));
+        }
+    return RES_OK;
+  }
+
+  /** @} */
+} // namespace smil
+
+#endif // _D_TILED_IMAGE_HPP
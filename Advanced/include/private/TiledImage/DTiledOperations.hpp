@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_TILED_OPERATIONS_HPP
+#define _D_TILED_OPERATIONS_HPP
+
+#include <cstdlib>
+
+#include "Core/include/DCore.h"
+#include "Base/include/private/DImageArith.hpp"
+#include "Base/include/private/DImageConvolution.hpp"
+#include "Base/include/private/DImageHistogram.hpp"
+#include "Morpho/include/DStructuringElement.h"
+#include "Morpho/include/private/DMorphoBase.hpp"
+#include "Morpho/include/private/DMorphoFilter.hpp"
+#include "DTiledImage.hpp"
+
+namespace smil
+{
+  /**
+   * @addtogroup AdvTiledImage
+   *
+   * @{
+   */
+
+  /** @cond */
+  // Distance reached by an operation with the structuring element se
+  inline size_t tiledHalo(const StrElt &se)
+  {
+    int reach = 0;
+    for (size_t i = 0; i < se.points.size(); i++) {
+      const IntPoint &pt = se.points[i];
+      reach = std::max(reach, abs(pt.x));
+      reach = std::max(reach, std::max(abs(pt.y), abs(pt.z)));
+    }
+    // Hexagonal SEs are shifted on odd lines
+    if (se.odd)
+      reach++;
+    return size_t(reach) * se.getSize();
+  }
+
+  template <class T> struct TiledDilateFunc {
+    StrElt se;
+    RES_T operator()(const Image<T> &imIn, Image<T> &imOut)
+    {
+      return dilate(imIn, imOut, se);
+    }
+  };
+
+  template <class T> struct TiledErodeFunc {
+    StrElt se;
+    RES_T operator()(const Image<T> &imIn, Image<T> &imOut)
+    {
+      return erode(imIn, imOut, se);
+    }
+  };
+
+  template <class T> struct TiledOpenFunc {
+    StrElt se;
+    RES_T operator()(const Image<T> &imIn, Image<T> &imOut)
+    {
+      return open(imIn, imOut, se);
+    }
+  };
+
+  template <class T> struct TiledCloseFunc {
+    StrElt se;
+    RES_T operator()(const Image<T> &imIn, Image<T> &imOut)
+    {
+      return close(imIn, imOut, se);
+    }
+  };
+
+  template <class T> struct TiledGaussianFunc {
+    int radius;
+    RES_T operator()(Image<T> &imIn, Image<T> &imOut)
+    {
+      return gaussianFilter(imIn, radius, imOut);
+    }
+  };
+
+  template <class T, class T_out> struct TiledThresholdFunc {
+    T minVal, maxVal;
+    RES_T operator()(const Image<T> &imIn, Image<T_out> &imOut)
+    {
+      return threshold(imIn, minVal, maxVal, imOut);
+    }
+  };
+
+  template <class T> struct TiledAddFunc {
+    RES_T operator()(const Image<T> &imIn1, const Image<T> &imIn2,
+                     Image<T> &imOut)
+    {
+      return add(imIn1, imIn2, imOut);
+    }
+  };
+
+  template <class T> struct TiledSubFunc {
+    RES_T operator()(const Image<T> &imIn1, const Image<T> &imIn2,
+                     Image<T> &imOut)
+    {
+      return sub(imIn1, imIn2, imOut);
+    }
+  };
+
+  template <class T> struct TiledMulFunc {
+    RES_T operator()(const Image<T> &imIn1, const Image<T> &imIn2,
+                     Image<T> &imOut)
+    {
+      return mul(imIn1, imIn2, imOut);
+    }
+  };
+  /** @endcond */
+
+  /**
+   * tiledDilate() - Morphological dilation of a TiledImage
+   *
+   * @see dilate()
+   */
+  template <class T>
+  RES_T tiledDilate(TiledImage<T> &imIn, TiledImage<T> &imOut,
+                    const StrElt &se = DEFAULT_SE)
+  {
+    TiledDilateFunc<T> func;
+    func.se = se;
+    return tiledProcess(imIn, tiledHalo(se), func, imOut);
+  }
+
+  /**
+   * tiledErode() - Morphological erosion of a TiledImage
+   *
+   * @see erode()
+   */
+  template <class T>
+  RES_T tiledErode(TiledImage<T> &imIn, TiledImage<T> &imOut,
+                   const StrElt &se = DEFAULT_SE)
+  {
+    TiledErodeFunc<T> func;
+    func.se = se;
+    return tiledProcess(imIn, tiledHalo(se), func, imOut);
+  }
+
+  /**
+   * tiledOpen() - Morphological opening of a TiledImage
+   *
+   * @see open()
+   */
+  template <class T>
+  RES_T tiledOpen(TiledImage<T> &imIn, TiledImage<T> &imOut,
+                  const StrElt &se = DEFAULT_SE)
+  {
+    TiledOpenFunc<T> func;
+    func.se = se;
+    return tiledProcess(imIn, 2 * tiledHalo(se), func, imOut);
+  }
+
+  /**
+   * tiledClose() - Morphological closing of a TiledImage
+   *
+   * @see close()
+   */
+  template <class T>
+  RES_T tiledClose(TiledImage<T> &imIn, TiledImage<T> &imOut,
+                   const StrElt &se = DEFAULT_SE)
+  {
+    TiledCloseFunc<T> func;
+    func.se = se;
+    return tiledProcess(imIn, 2 * tiledHalo(se), func, imOut);
+  }
+
+  /**
+   * tiledGaussianFilter() - Gaussian filter of a TiledImage
+   *
+   * @see gaussianFilter()
+   */
+  template <class T>
+  RES_T tiledGaussianFilter(TiledImage<T> &imIn, int radius,
+                            TiledImage<T> &imOut)
+  {
+    ASSERT(radius >= 0, RES_ERR);
+    TiledGaussianFunc<T> func;
+    func.radius = radius;
+    return tiledProcess(imIn, size_t(radius), func, imOut);
+  }
+
+  /**
+   * tiledThreshold() - Threshold of a TiledImage
+   *
+   * @see threshold()
+   */
+  template <class T, class T_out>
+  RES_T tiledThreshold(TiledImage<T> &imIn, T minVal, T maxVal,
+                       TiledImage<T_out> &imOut)
+  {
+    TiledThresholdFunc<T, T_out> func;
+    func.minVal = minVal;
+    func.maxVal = maxVal;
+    return tiledProcess(imIn, 0, func, imOut);
+  }
+
+  /**
+   * tiledAdd() - Addition of two TiledImages (with saturation)
+   *
+   * @see add()
+   */
+  template <class T>
+  RES_T tiledAdd(TiledImage<T> &imIn1, TiledImage<T> &imIn2,
+                 TiledImage<T> &imOut)
+  {
+    TiledAddFunc<T> func;
+    return tiledProcess(imIn1, imIn2, 0, func, imOut);
+  }
+
+  /**
+   * tiledSub() - Subtraction of two TiledImages (with saturation)
+   *
+   * @see sub()
+   */
+  template <class T>
+  RES_T tiledSub(TiledImage<T> &imIn1, TiledImage<T> &imIn2,
+                 TiledImage<T> &imOut)
+  {
+    TiledSubFunc<T> func;
+    return tiledProcess(imIn1, imIn2, 0, func, imOut);
+  }
+
+  /**
+   * tiledMul() - Multiplication of two TiledImages (with saturation)
+   *
+   * @see mul()
+   */
+  template <class T>
+  RES_T tiledMul(TiledImage<T> &imIn1, TiledImage<T> &imIn2,
+                 TiledImage<T> &imOut)
+  {
+    TiledMulFunc<T> func;
+    return tiledProcess(imIn1, imIn2, 0, func, imOut);
+  }
+
+  /** @} */
+} // namespace smil
+
+#endif // _D_TILED_OPERATIONS_HPP
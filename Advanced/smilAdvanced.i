@@ -90,3 +90,21 @@ TEMPLATE_WRAP_FUNC_2T_CROSS(geodesicUltimatePathClosing);
 %include "private/AreaOpening/DAreaOpenUnionFind.hpp"
 TEMPLATE_WRAP_FUNC(areaOpening);
 //TEMPLATE_WRAP_FUNC(areaClosing);
+
+
+%include "DTiledImage.h"
+%include "private/TiledImage/DTiledImage.hpp"
+%include "private/TiledImage/DTiledOperations.hpp"
+namespace smil
+{
+  TEMPLATE_WRAP_CLASS(TiledImage, TiledImage);
+}
+TEMPLATE_WRAP_FUNC(tiledDilate);
+TEMPLATE_WRAP_FUNC(tiledErode);
+TEMPLATE_WRAP_FUNC(tiledOpen);
+TEMPLATE_WRAP_FUNC(tiledClose);
+TEMPLATE_WRAP_FUNC(tiledGaussianFilter);
+TEMPLATE_WRAP_FUNC_2T_CROSS(tiledThreshold);
+TEMPLATE_WRAP_FUNC(tiledAdd);
+TEMPLATE_WRAP_FUNC(tiledSub);
+TEMPLATE_WRAP_FUNC(tiledMul);
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2011-2015, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Core/include/DCore.h"
+#include "DTiledImage.h"
+
+using namespace smil;
+
+template <class T> void fillTestImage(Image<T> &im)
+{
+  for (size_t z = 0; z < im.getDepth(); z++)
+    for (size_t y = 0; y < im.getHeight(); y++)
+      for (size_t x = 0; x < im.getWidth(); x++)
+        im.setPixel(x, y, z, T((x * 7 + y * 13 + z * 29 + (x * y) % 17) % 256));
+}
+
+class Test_TiledImage_RW : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im1(50, 37, 23), im2;
+    fillTestImage(im1);
+
+    // A cache of 3 bricks, so that most of them go to the swap file
+    TiledImage<UINT8> tIm(50, 37, 23, 16, 3 * 16 * 16 * 16);
+    TEST_ASSERT(tIm.isAllocated());
+    TEST_ASSERT(tIm.getBrickCount() == 4 * 3 * 2);
+    TEST_ASSERT(tIm.fromImage(im1) == RES_OK);
+    TEST_ASSERT(tIm.toImage(im2) == RES_OK);
+    TEST_ASSERT(im1 == im2);
+
+    TEST_ASSERT(tIm.getPixel(49, 36, 22) == im1.getPixel(49, 36, 22));
+    TEST_ASSERT(tIm.setPixel(17, 5, 20, 255) == RES_OK);
+    TEST_ASSERT(tIm.getPixel(17, 5, 20) == 255);
+
+    // Region crossing several bricks
+    Image<UINT8> imRegion(20, 20, 5);
+    TEST_ASSERT(tIm.readRegion(10, 3, 18, imRegion) == RES_OK);
+    TEST_ASSERT(imRegion.getPixel(7, 2, 2) == 255);
+    TEST_ASSERT(imRegion.getPixel(19, 19, 4) == im1.getPixel(29, 22, 22));
+    TEST_ASSERT(tIm.readRegion(40, 3, 18, imRegion) != RES_OK);
+
+    // Unwritten bricks are zeros
+    TiledImage<UINT16> tIm2(40, 40, 1, 16);
+    TEST_ASSERT(tIm2.getPixel(39, 39) == 0);
+    TEST_ASSERT(tIm2.fill(1000) == RES_OK);
+    TEST_ASSERT(tIm2.getPixel(39, 39) == 1000);
+  }
+};
+
+class Test_TiledImage_Process : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im3D(45, 38, 21), im2D(101, 77);
+    Image<UINT8> imTruth, imRes;
+    fillTestImage(im3D);
+    fillTestImage(im2D);
+
+    TiledImage<UINT8> t3D(45, 38, 21, 16, 8 * 16 * 16 * 16);
+    TiledImage<UINT8> t3DOut(45, 38, 21, 16, 8 * 16 * 16 * 16);
+    TEST_ASSERT(t3D.fromImage(im3D) == RES_OK);
+
+    imTruth.setSize(45, 38, 21);
+    TEST_ASSERT(tiledDilate(t3D, t3DOut, CubeSE(2)) == RES_OK);
+    dilate(im3D, imTruth, CubeSE(2));
+    t3DOut.toImage(imRes);
+    TEST_ASSERT(imRes == imTruth);
+
+    TEST_ASSERT(tiledGaussianFilter(t3D, 3, t3DOut) == RES_OK);
+    gaussianFilter(im3D, 3, imTruth);
+    t3DOut.toImage(imRes);
+    TEST_ASSERT(imRes == imTruth);
+
+    TEST_ASSERT(tiledAdd(t3D, t3D, t3DOut) == RES_OK);
+    add(im3D, im3D, imTruth);
+    t3DOut.toImage(imRes);
+    TEST_ASSERT(imRes == imTruth);
+
+    // Hexagonal SE, and bricks whose halo starts on an odd line
+    TiledImage<UINT8> t2D(101, 77, 1, 21, 4 * 21 * 21);
+    TiledImage<UINT8> t2DOut(101, 77, 1, 21, 4 * 21 * 21);
+    TEST_ASSERT(t2D.fromImage(im2D) == RES_OK);
+
+    imTruth.setSize(101, 77);
+    TEST_ASSERT(tiledOpen(t2D, t2DOut, HexSE(2)) == RES_OK);
+    open(im2D, imTruth, HexSE(2));
+    t2DOut.toImage(imRes);
+    TEST_ASSERT(imRes == imTruth);
+
+    TiledImage<UINT16> t2DBin(101, 77, 1, 21);
+    Image<UINT16> imBin(101, 77), imBinTruth(imBin);
+    TEST_ASSERT(tiledThreshold(t2D, UINT8(50), UINT8(150), t2DBin) == RES_OK);
+    threshold(im2D, UINT8(50), UINT8(150), imBinTruth);
+    t2DBin.toImage(imBin);
+    TEST_ASSERT(imBin == imBinTruth);
+
+    TEST_ASSERT(tiledErode(t2D, t2D) != RES_OK);
+  }
+};
+
+int main()
+{
+  TestSuite ts;
+  ADD_TEST(ts, Test_TiledImage_RW);
+  ADD_TEST(ts, Test_TiledImage_Process);
+  return ts.run();
+}
@@ -46,6 +46,7 @@
 #include "private/DImageConvolution.hpp"
 #include "private/DImageDraw.hpp"
 #include "private/DImageHistogram.hpp"
+#include "private/DIntegralImage.hpp"
 #include "private/DImageMatrix.hpp"
 #include "private/DImageTransform.hpp"
 #include "private/DMeasures.hpp"
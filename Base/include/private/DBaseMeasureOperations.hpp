@@ -50,7 +50,13 @@ namespace smil
   // #        ####   #    #   ####     #         #####   #    #   ####   ######
   //
   /*
+   * Base of the measures: processSequence() is called on the sequences of
+   * pixels to measure, between initialize() and finalize().
    *
+   * A measure which can be computed on separate parts of an image returns a
+   * new copy of itself from clone(), and adds the result of such a copy to
+   * its own in combine(). processImage() then measures one part of the
+   * image per thread, and combines the parts in order before finalize().
    */
   template <class T, class _retType> struct MeasureFunctionBase {
     virtual ~MeasureFunctionBase()
@@ -60,6 +66,9 @@ namespace smil
     typedef _retType retType;
     retType retVal;
 
+    // Under this number of pixels, images are measured on a single thread
+    static const size_t MIN_PARALLEL_PIXELS = 1 << 16;
+
     virtual void initialize(const Image<T> & /*imIn*/)
     {
       retVal = retType();
@@ -73,34 +82,83 @@ namespace smil
     {
     }
 
-    virtual RES_T processImage(const Image<T> &imIn, bool onlyNonZero = false)
+    // Copy for the parallel reduction (none by default)
+    virtual MeasureFunctionBase *clone() const
     {
-      initialize(imIn);
-      ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION);
+      return NULL;
+    }
 
+    // Add the result of a copy, initialized and run on another part
+    virtual void combine(const MeasureFunctionBase & /*other*/)
+    {
+    }
+
+    // Process the part number @b part of @b partNbr of the image
+    virtual void processPart(const Image<T> &imIn, size_t part,
+                             size_t partNbr, bool onlyNonZero)
+    {
       lineType pixels = imIn.getPixels();
       size_t pixCount = imIn.getPixelCount();
+      size_t begin    = pixCount * part / partNbr;
+      size_t end      = pixCount * (part + 1) / partNbr;
 
       if (!onlyNonZero)
-        processSequence(pixels, pixCount);
+        processSequence(pixels + begin, end - begin);
       else {
         size_t curSize  = 0;
         size_t curStart = 0;
 
-        for (size_t i = 0; i < pixCount; i++) {
+        for (size_t i = begin; i < end; i++) {
           if (pixels[i] != T(0)) {
-            if (curSize == 0 && curStart == 0)
+            if (curSize == 0)
               curStart = i;
             curSize++;
           } else if (curSize > 0) {
             processSequence(pixels + curStart, curSize);
-            curStart = 0;
-            curSize  = 0;
+            curSize = 0;
           }
         }
         if (curSize > 0)
           processSequence(pixels + curStart, curSize);
       }
+    }
+
+    virtual RES_T processImage(const Image<T> &imIn, bool onlyNonZero = false)
+    {
+      initialize(imIn);
+      ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION);
+
+      size_t partNbr = 1;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+      if (imIn.getPixelCount() >= MIN_PARALLEL_PIXELS)
+        partNbr = min(size_t(nthreads), imIn.getLineCount());
+#endif // USE_OPEN_MP
+
+      MeasureFunctionBase *first = partNbr > 1 ? clone() : NULL;
+
+      if (first == NULL)
+        processPart(imIn, 0, 1, onlyNonZero);
+      else {
+        vector<MeasureFunctionBase *> parts(partNbr, first);
+        for (size_t p = 1; p < partNbr; p++)
+          parts[p] = clone();
+
+        int count = int(partNbr);
+        int i;
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (i = 0; i < count; i++) {
+          parts[i]->initialize(imIn);
+          parts[i]->processPart(imIn, i, partNbr, onlyNonZero);
+        }
+
+        for (size_t p = 0; p < partNbr; p++) {
+          combine(*parts[p]);
+          delete parts[p];
+        }
+      }
       finalize(imIn);
       return RES_OK;
     }
@@ -130,16 +188,21 @@ namespace smil
     }
 
     virtual retType processImage(const Image<T> &imIn, const Blob &blob)
+    {
+      return processSequences(imIn, blob.sequences.data(),
+                              blob.sequences.size());
+    }
+
+    virtual retType processSequences(const Image<T> &imIn,
+                                     const PixelSequence *seqs, size_t seqNbr)
     {
       initialize(imIn);
 
       ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, retVal);
 
-      lineType pixels                       = imIn.getPixels();
-      Blob::sequences_const_iterator it     = blob.sequences.begin();
-      Blob::sequences_const_iterator it_end = blob.sequences.end();
-      for (; it != it_end; it++)
-        processSequence(pixels + (*it).offset, (*it).size);
+      lineType pixels = imIn.getPixels();
+      for (size_t i = 0; i < seqNbr; i++)
+        processSequence(pixels + seqs[i].offset, seqs[i].size);
       finalize(imIn);
       return retVal;
     }
@@ -180,61 +243,59 @@ namespace smil
                                  size_t /*x*/, size_t /*y*/, size_t /*z*/)
     {
     }
-    virtual RES_T processImage(const Image<T> &imIn, bool onlyNonZero = false)
-    {
-      this->initialize(imIn);
-      ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION);
+    using MeasureFunctionBase<T, _retType>::processImage;
 
-      typename Image<T>::volType slices = imIn.getSlices();
-      typename Image<T>::sliceType lines;
+    // Parts of whole lines
+    virtual void processPart(const Image<T> &imIn, size_t part,
+                             size_t partNbr, bool onlyNonZero)
+    {
+      typename Image<T>::sliceType lines = imIn.getLines();
       typename Image<T>::lineType pixels;
       size_t dims[3];
       imIn.getSize(dims);
-
-      if (!onlyNonZero) {
-        for (size_t z = 0; z < dims[2]; z++) {
-          lines = slices[z];
-          for (size_t y = 0; y < dims[1]; y++)
-            processSequence(lines[y], dims[0], 0, y, z);
+      size_t lineCount = dims[1] * dims[2];
+      size_t begin     = lineCount * part / partNbr;
+      size_t end       = lineCount * (part + 1) / partNbr;
+
+      for (size_t l = begin; l < end; l++) {
+        size_t y = l % dims[1];
+        size_t z = l / dims[1];
+        pixels   = lines[l];
+
+        if (!onlyNonZero) {
+          processSequence(pixels, dims[0], 0, y, z);
+          continue;
         }
-      } else {
-        for (size_t z = 0; z < dims[2]; z++) {
-          lines = slices[z];
-          for (size_t y = 0; y < dims[1]; y++) {
-            pixels          = lines[y];
-            size_t curSize  = 0;
-            size_t curStart = 0;
-
-            for (size_t x = 0; x < dims[0]; x++) {
-              if (pixels[x] != 0) {
-                if (curSize++ == 0)
-                  curStart = x;
-              } else if (curSize > 0) {
-                processSequence(pixels + curStart, curSize, curStart, y, z);
-                curSize = 0;
-              }
-            }
-            if (curSize > 0)
-              processSequence(pixels + curStart, curSize, curStart, y, z);
+
+        size_t curSize  = 0;
+        size_t curStart = 0;
+
+        for (size_t x = 0; x < dims[0]; x++) {
+          if (pixels[x] != 0) {
+            if (curSize++ == 0)
+              curStart = x;
+          } else if (curSize > 0) {
+            processSequence(pixels + curStart, curSize, curStart, y, z);
+            curSize = 0;
           }
         }
+        if (curSize > 0)
+          processSequence(pixels + curStart, curSize, curStart, y, z);
       }
-      this->finalize(imIn);
-      return RES_OK;
     }
-    virtual retType processImage(const Image<T> &imIn, const Blob &blob)
+
+    virtual retType processSequences(const Image<T> &imIn,
+                                     const PixelSequence *seqs, size_t seqNbr)
     {
       this->initialize(imIn);
 
       ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, this->retVal);
 
-      lineType pixels                       = imIn.getPixels();
-      Blob::sequences_const_iterator it     = blob.sequences.begin();
-      Blob::sequences_const_iterator it_end = blob.sequences.end();
+      lineType pixels = imIn.getPixels();
       size_t x, y, z;
-      for (; it != it_end; it++) {
-        imIn.getCoordsFromOffset((*it).offset, x, y, z);
-        this->processSequence(pixels + (*it).offset, (*it).size, x, y, z);
+      for (size_t i = 0; i < seqNbr; i++) {
+        imIn.getCoordsFromOffset(seqs[i].offset, x, y, z);
+        this->processSequence(pixels + seqs[i].offset, seqs[i].size, x, y, z);
       }
       this->finalize(imIn);
       return this->retVal;
@@ -309,6 +370,59 @@ namespace smil
     return processBlobMeasure<T, labelT, funcT>(imIn, blobs);
   }
 
+#ifndef SWIG
+  /*
+   * Measure on each blob of a BlobTable, in parallel over the blobs.
+   *
+   * Returns a vector indexed by blob (entry 0, the background, is left
+   * to its default value).
+   */
+  template <class T, class funcT>
+  vector<typename funcT::retType>
+  processBlobTableMeasure(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    typedef typename funcT::retType retType;
+    size_t blobNbr = blobs.getBlobNbr();
+    vector<retType> res(blobNbr + 1);
+
+    ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, res);
+
+    const PixelSequence *seqs = blobs.sequences.data();
+    const size_t *offsets     = blobs.blobOffsets.data();
+    retType *results          = res.data();
+    int count                 = int(blobNbr);
+    int i;
+
+#ifdef USE_OPEN_MP
+    int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for schedule(dynamic, 64) num_threads(nthreads)
+#endif // USE_OPEN_MP
+    for (i = 1; i <= count; i++) {
+      funcT func;
+      results[i] = func.processSequences(imIn, seqs + offsets[i],
+                                         offsets[i + 1] - offsets[i]);
+    }
+    return res;
+  }
+
+  /*
+   * Map of the measures of the non empty blobs, blob @b i having the label
+   * @b i (wrapped as in BlobTable::toBlobs())
+   */
+  template <class labelT, class retType>
+  map<labelT, retType> blobsMap(const BlobTable &blobs,
+                                const vector<retType> &values)
+  {
+    map<labelT, retType> res;
+    size_t maxLabel = size_t(ImDtTypes<labelT>::max()) - 1;
+
+    for (size_t b = 1; b <= blobs.getBlobNbr() && b < values.size(); b++)
+      if (blobs.blobOffsets[b] != blobs.blobOffsets[b + 1])
+        res[labelT((b - 1) % maxLabel + 1)] = values[b];
+    return res;
+  }
+#endif // SWIG
+
   /** @}*/
 
 } // namespace smil
@@ -135,6 +135,146 @@ namespace smil
     return blobs;
   }
 
+  /**
+   * Blobs stored in a flat run table.
+   *
+   * The sequences of the blob @b i (from 1 to getBlobNbr()) are
+   * <c>sequences[blobOffsets[i]]</c> to
+   * <c>sequences[blobOffsets[i + 1] - 1]</c>, in raster order, and its
+   * area is <c>areas[i]</c>. Blob 0 (the background) is empty.
+   *
+   * Unlike a map of Blob, all sequences are in a single vector, which avoids
+   * one allocation per blob and keeps the traversals contiguous. Measures
+   * on a BlobTable (see processBlobTableMeasure()) give vectors indexed
+   * by blob, which blobsMap() converts back to maps.
+   */
+  struct BlobTable {
+    vector<PixelSequence> sequences;
+    vector<size_t> blobOffsets;
+    vector<size_t> areas;
+
+    size_t getBlobNbr() const
+    {
+      return blobOffsets.size() > 1 ? blobOffsets.size() - 2 : 0;
+    }
+
+    void clear()
+    {
+      sequences.clear();
+      blobOffsets.assign(2, 0);
+      areas.assign(1, 0);
+    }
+
+#ifndef SWIG
+    /**
+     * Fill the run table from a list of sequences and the blob of each one.
+     *
+     * Sequences are kept in their order within each blob.
+     */
+    void fill(const vector<PixelSequence> &seqs, const vector<size_t> &seqBlobs,
+              size_t blobNbr)
+    {
+      blobOffsets.assign(blobNbr + 2, 0);
+      areas.assign(blobNbr + 1, 0);
+
+      for (size_t i = 0; i < seqs.size(); i++) {
+        blobOffsets[seqBlobs[i] + 1]++;
+        areas[seqBlobs[i]] += seqs[i].size;
+      }
+      for (size_t b = 0; b <= blobNbr; b++)
+        blobOffsets[b + 1] += blobOffsets[b];
+
+      vector<size_t> pos(blobOffsets.begin(), blobOffsets.end() - 1);
+      sequences.resize(seqs.size());
+      for (size_t i = 0; i < seqs.size(); i++)
+        sequences[pos[seqBlobs[i]]++] = seqs[i];
+    }
+
+    /**
+     * Fill the run table from a map of blobs, blob @b i holding the label
+     * @b i
+     */
+    template <class T> void fromBlobs(const map<T, Blob> &blobs)
+    {
+      vector<PixelSequence> seqs;
+      vector<size_t> seqBlobs;
+      size_t blobNbr = 0;
+
+      typename map<T, Blob>::const_iterator it;
+      for (it = blobs.begin(); it != blobs.end(); it++) {
+        const vector<PixelSequence> &blobSeqs = it->second.sequences;
+        seqs.insert(seqs.end(), blobSeqs.begin(), blobSeqs.end());
+        seqBlobs.resize(seqs.size(), size_t(it->first));
+        blobNbr = max(blobNbr, size_t(it->first));
+      }
+      fill(seqs, seqBlobs, blobNbr);
+    }
+
+    /**
+     * Convert to a map of blobs, blob @b i having the label @b i (wrapped as
+     * done by label() when the label type is too small)
+     */
+    template <class T> map<T, Blob> toBlobs() const
+    {
+      map<T, Blob> blobs;
+      size_t maxLabel = size_t(ImDtTypes<T>::max()) - 1;
+
+      for (size_t b = 1; b <= getBlobNbr(); b++) {
+        if (blobOffsets[b] == blobOffsets[b + 1])
+          continue;
+        vector<PixelSequence> &seqs =
+            blobs[T((b - 1) % maxLabel + 1)].sequences;
+        seqs.insert(seqs.end(), sequences.begin() + blobOffsets[b],
+                    sequences.begin() + blobOffsets[b + 1]);
+      }
+      return blobs;
+    }
+#endif // SWIG
+  };
+
+  /**
+   * Create a run table of blobs from a labeled image
+   *
+   * Blob @b i holds the pixels of label @b i.
+   *
+   * @param[in] imIn : input @b labeled image
+   * @param[out] blobs : run table of the non zero labels
+   */
+  template <class T>
+  RES_T computeBlobTable(const Image<T> &imIn, BlobTable &blobs)
+  {
+    ASSERT_ALLOCATED(&imIn);
+
+    typename ImDtTypes<T>::sliceType lines = imIn.getLines();
+    size_t npix   = imIn.getWidth();
+    size_t nlines = imIn.getLineCount();
+
+    vector<PixelSequence> seqs;
+    vector<size_t> seqBlobs;
+    size_t blobNbr = 0;
+
+    for (size_t l = 0; l < nlines; l++) {
+      typename ImDtTypes<T>::lineType pixels = lines[l];
+      size_t i                               = 0;
+
+      while (i < npix) {
+        T curVal     = pixels[i];
+        size_t start = i;
+        while (i < npix && pixels[i] == curVal)
+          i++;
+        if (curVal == T(0))
+          continue;
+        seqs.push_back(PixelSequence(start + l * npix, i - start));
+        seqBlobs.push_back(size_t(curVal));
+        blobNbr = max(blobNbr, size_t(curVal));
+      }
+    }
+
+    blobs.fill(seqs, seqBlobs, blobNbr);
+
+    return RES_OK;
+  }
+
   /**
    * Represent Blobs in an image
    *
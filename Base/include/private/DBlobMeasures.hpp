@@ -35,6 +35,7 @@
 #include "DMeasures.hpp"
 
 #include <map>
+#include <algorithm>
 
 using namespace std;
 
@@ -343,6 +344,553 @@ namespace smil
     return processBlobMeasure<T, labelT, measEntropyFunc<T>>(imIn, blobs);
   }
 
+#ifndef SWIG
+  /*
+   * Measures on a BlobTable
+   *
+   * Same measures as above, but each one gives a vector indexed by blob,
+   * and the blobs are processed in parallel. Use blobsMap() to get the
+   * equivalent map.
+   */
+
+  /**
+   * blobsArea() - Areas of the blobs of a BlobTable
+   *
+   * @param[in] blobs : input BlobTable
+   * @return a vector with the @b area of each blob
+   */
+  inline vector<double> blobsArea(const BlobTable &blobs)
+  {
+    return vector<double>(blobs.areas.begin(), blobs.areas.end());
+  }
+
+  /**
+   * blobsVolume() - Sum of values of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<double> blobsVolume(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measVolFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsMinVal() - Minimum value of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<T> blobsMinVal(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measMinValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsMaxVal() - Maximum value of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<T> blobsMaxVal(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measMaxValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsRangeVal() - Min and max values of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<vector<T>> blobsRangeVal(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measMinMaxValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsMeanVal() - Mean value and std dev. of imIn in each blob of a
+   * BlobTable
+   */
+  template <class T>
+  vector<Vector_double> blobsMeanVal(const Image<T> &imIn,
+                                     const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measMeanValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsValueList() - List of values of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<vector<T>> blobsValueList(const Image<T> &imIn,
+                                   const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, valueListFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsModeVal() - Mode value of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<T> blobsModeVal(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measModeValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsMedianVal() - Median value of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<T> blobsMedianVal(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measMedianValFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsBarycenter() - Barycenter of each blob of a BlobTable
+   */
+  template <class T>
+  vector<Vector_double> blobsBarycenter(const Image<T> &imIn,
+                                        const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measBarycenterFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsBoundBox() - Bounding box of each blob of a BlobTable
+   */
+  template <class T>
+  vector<vector<size_t>> blobsBoundBox(const Image<T> &imIn,
+                                       const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measBoundBoxFunc<T>>(imIn, blobs);
+  }
+
+  /**
+   * blobsMoments() - Image moments of each blob of a BlobTable
+   *
+   * @see blobsMoments(const Image<T> &, map<labelT, Blob> &, bool)
+   */
+  template <class T>
+  vector<Vector_double> blobsMoments(const Image<T> &imIn,
+                                     const BlobTable &blobs,
+                                     bool central = false)
+  {
+    vector<Vector_double> bmoments =
+        processBlobTableMeasure<T, measMomentsFunc<T>>(imIn, blobs);
+    if (central) {
+      for (size_t i = 1; i < bmoments.size(); i++)
+        bmoments[i] = centerMoments(bmoments[i]);
+    }
+    return bmoments;
+  }
+
+  /**
+   * blobsEntropy() - Entropy of imIn in each blob of a BlobTable
+   */
+  template <class T>
+  vector<double> blobsEntropy(const Image<T> &imIn, const BlobTable &blobs)
+  {
+    return processBlobTableMeasure<T, measEntropyFunc<T>>(imIn, blobs);
+  }
+#endif // SWIG
+
+  /**
+   * Several measures on each blob of a BlobTable, in a single pass.
+   *
+   * The requested features are computed together while reading each blob
+   * once, in parallel over the blobs, and stored in columns indexed by blob
+   * (row 0, the background, is left to 0). Available features, with their
+   * columns:
+   * - @b area : "area"
+   * - @b volume : "volume"
+   * - @b minVal, @b maxVal : "minVal", "maxVal"
+   * - @b meanVal : "meanVal", "stdDev"
+   * - @b barycenter : "barycenterX", "barycenterY" (, "barycenterZ")
+   * - @b boundBox : "xMin", "yMin" (, "zMin"), "xMax", "yMax" (, "zMax")
+   * - @b moments : "m00", "m10", "m01", "m11", "m20", "m02" in 2D, or "m000",
+   *   "m100", "m010", "m001", "m110", "m101", "m011", "m200", "m020", "m002"
+   *   in 3D (not centered, see centerMoments())
+   * - @b entropy : "entropy"
+   *
+   * The values are the ones of the corresponding blobs*() functions.
+   *
+   * @b Example
+   * @code{.py}
+   * blobs = sp.BlobTable()
+   * sp.computeBlobTable(imLbl, blobs)
+   * fe = sp.BlobFeatureExtractor_UINT8(["area", "meanVal", "barycenter"])
+   * fe.compute(imIn, blobs)
+   * areas = fe.getColumn("area")
+   * @endcode
+   */
+  template <class T> class BlobFeatureExtractor
+  {
+  public:
+    BlobFeatureExtractor() : features(0), blobNbr(0)
+    {
+    }
+
+    BlobFeatureExtractor(const vector<string> &featureNames)
+        : features(0), blobNbr(0)
+    {
+      for (size_t i = 0; i < featureNames.size(); i++)
+        addFeature(featureNames[i]);
+    }
+
+    //! Add a feature to compute
+    RES_T addFeature(const string &name)
+    {
+      UINT f = featureFromName(name);
+      if (f == 0) {
+        ERR_MSG("* Unknown feature " + name);
+        return RES_ERR;
+      }
+      features |= f;
+      return RES_OK;
+    }
+
+    //! Remove all features
+    void clearFeatures()
+    {
+      features = 0;
+    }
+
+    //! Compute the features of each blob of @b blobs on the image @b imIn
+    RES_T compute(const Image<T> &imIn, const BlobTable &blobs)
+    {
+      ASSERT_ALLOCATED(&imIn);
+
+      blobNbr = blobs.getBlobNbr();
+      imIn.getSize(imSize);
+      im3d = imIn.getDimension() == 3;
+      initColumns();
+
+      typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+      const PixelSequence *seqs              = blobs.sequences.data();
+      const size_t *offsets                  = blobs.blobOffsets.data();
+      int count                              = int(blobNbr);
+      int b;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+      {
+        // Per thread accumulator
+        Accumulator acc;
+        if (features & FEAT_ENTROPY)
+          acc.initHisto();
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic, 64)
+#endif // USE_OPEN_MP
+        for (b = 1; b <= count; b++) {
+          acc.reset(imSize);
+          for (size_t i = offsets[b]; i < offsets[b + 1]; i++)
+            processSequence(acc, pixels, seqs[i]);
+          if (acc.pixNbr > 0)
+            storeBlob(acc, b);
+        }
+      }
+      return RES_OK;
+    }
+
+#ifndef SWIG
+    //! Compute the features of each label of @b imLbl on the image @b imIn
+    template <class labelT>
+    RES_T compute(const Image<T> &imIn, const Image<labelT> &imLbl)
+    {
+      BlobTable blobs;
+      ASSERT(computeBlobTable(imLbl, blobs) == RES_OK);
+      return compute(imIn, blobs);
+    }
+#endif // SWIG
+
+    //! Number of blobs of the last computation
+    size_t getBlobNbr() const
+    {
+      return blobNbr;
+    }
+
+    //! Names of the columns of the last computation
+    vector<string> getColumnNames() const
+    {
+      return columnNames;
+    }
+
+    //! Values of a column, indexed by blob
+    Vector_double getColumn(const string &name) const
+    {
+      for (size_t i = 0; i < columnNames.size(); i++)
+        if (columnNames[i] == name)
+          return columns[i];
+      ERR_MSG("* Unknown column " + name);
+      return Vector_double();
+    }
+
+  protected:
+    enum {
+      FEAT_AREA       = 1,
+      FEAT_VOLUME     = 2,
+      FEAT_MIN_VAL    = 4,
+      FEAT_MAX_VAL    = 8,
+      FEAT_MEAN_VAL   = 16,
+      FEAT_BARYCENTER = 32,
+      FEAT_BOUND_BOX  = 64,
+      FEAT_MOMENTS    = 128,
+      FEAT_ENTROPY    = 256
+    };
+
+    static UINT featureFromName(const string &name)
+    {
+      const char *names[] = {"area",     "volume",  "minVal",
+                             "maxVal",   "meanVal", "barycenter",
+                             "boundBox", "moments", "entropy"};
+      for (UINT i = 0; i < 9; i++)
+        if (name == names[i])
+          return 1 << i;
+      return 0;
+    }
+
+#ifndef SWIG
+    struct Accumulator {
+      size_t pixNbr;
+      double sum1, sum2;
+      T minV, maxV;
+      // Moments weighted by the pixel values
+      double m000, m100, m010, m001, m110, m101, m011, m200, m020, m002;
+      size_t bbox[6];
+
+      // Histogram for the entropy: dense for small types, values list
+      // otherwise
+      vector<UINT> histo;
+      vector<size_t> histoUsed;
+      vector<T> values;
+
+      void initHisto()
+      {
+        if (numeric_limits<T>::is_integer && sizeof(T) <= 2)
+          histo.assign(ImDtTypes<T>::cardinal(), 0);
+      }
+
+      void reset(const size_t *imSize)
+      {
+        pixNbr = 0;
+        sum1 = sum2 = 0.;
+        minV        = ImDtTypes<T>::max();
+        maxV        = ImDtTypes<T>::min();
+        m000 = m100 = m010 = m001 = m110 = m101 = m011 = m200 = m020 = m002 =
+            0.;
+        for (int i = 0; i < 3; i++) {
+          bbox[i]     = imSize[i];
+          bbox[i + 3] = 0;
+        }
+        histoUsed.clear();
+        values.clear();
+      }
+    };
+
+    void processSequence(Accumulator &acc,
+                         typename ImDtTypes<T>::lineType pixels,
+                         const PixelSequence &seq)
+    {
+      typename ImDtTypes<T>::lineType line = pixels + seq.offset;
+      size_t size                          = seq.size;
+      size_t x, y, z;
+      getCoords(seq.offset, x, y, z);
+
+      acc.pixNbr += size;
+
+      if (features & FEAT_BOUND_BOX) {
+        acc.bbox[0] = min(acc.bbox[0], x);
+        acc.bbox[1] = min(acc.bbox[1], y);
+        acc.bbox[2] = min(acc.bbox[2], z);
+        acc.bbox[3] = max(acc.bbox[3], x + size - 1);
+        acc.bbox[4] = max(acc.bbox[4], y);
+        acc.bbox[5] = max(acc.bbox[5], z);
+      }
+
+      if (features & (FEAT_VOLUME | FEAT_MEAN_VAL | FEAT_MIN_VAL |
+                      FEAT_MAX_VAL)) {
+        double s1 = 0., s2 = 0.;
+        T minV = acc.minV, maxV = acc.maxV;
+        for (size_t i = 0; i < size; i++) {
+          double v = double(line[i]);
+          s1 += v;
+          s2 += v * v;
+          if (line[i] < minV)
+            minV = line[i];
+          if (line[i] > maxV)
+            maxV = line[i];
+        }
+        acc.sum1 += s1;
+        acc.sum2 += s2;
+        acc.minV = minV;
+        acc.maxV = maxV;
+      }
+
+      // y and z are constant along the sequence: only the sums of v, v.x
+      // and v.x^2 are needed
+      if (features & (FEAT_BARYCENTER | FEAT_MOMENTS)) {
+        double s0 = 0., s1 = 0., s2 = 0.;
+        double xd = double(x);
+        for (size_t i = 0; i < size; i++, xd += 1.) {
+          double v = double(line[i]);
+          s0 += v;
+          s1 += v * xd;
+          s2 += v * xd * xd;
+        }
+        double yd = double(y), zd = double(z);
+        acc.m000 += s0;
+        acc.m100 += s1;
+        acc.m010 += s0 * yd;
+        acc.m001 += s0 * zd;
+        acc.m110 += s1 * yd;
+        acc.m101 += s1 * zd;
+        acc.m011 += s0 * yd * zd;
+        acc.m200 += s2;
+        acc.m020 += s0 * yd * yd;
+        acc.m002 += s0 * zd * zd;
+      }
+
+      if (features & FEAT_ENTROPY) {
+        if (!acc.histo.empty()) {
+          for (size_t i = 0; i < size; i++) {
+            size_t h = size_t(long(line[i]) - long(ImDtTypes<T>::min()));
+            if (acc.histo[h]++ == 0)
+              acc.histoUsed.push_back(h);
+          }
+        } else
+          acc.values.insert(acc.values.end(), line, line + size);
+      }
+    }
+
+    void storeBlob(Accumulator &acc, size_t b)
+    {
+      double pixNbr = double(acc.pixNbr);
+      vector<Vector_double>::iterator col = columns.begin();
+
+      if (features & FEAT_AREA)
+        (*col++)[b] = pixNbr;
+      if (features & FEAT_VOLUME)
+        (*col++)[b] = acc.sum1;
+      if (features & FEAT_MIN_VAL)
+        (*col++)[b] = double(acc.minV);
+      if (features & FEAT_MAX_VAL)
+        (*col++)[b] = double(acc.maxV);
+      if (features & FEAT_MEAN_VAL) {
+        double mean = acc.sum1 / pixNbr;
+        (*col++)[b] = mean;
+        (*col++)[b] = sqrt(acc.sum2 / pixNbr - mean * mean);
+      }
+      if (features & FEAT_BARYCENTER) {
+        (*col++)[b] = acc.m100 / acc.m000;
+        (*col++)[b] = acc.m010 / acc.m000;
+        if (im3d)
+          (*col++)[b] = acc.m001 / acc.m000;
+      }
+      if (features & FEAT_BOUND_BOX) {
+        bool bbox3d = imSize[2] > 1;
+        for (int i = 0; i < 6; i++)
+          if (bbox3d || i % 3 != 2)
+            (*col++)[b] = double(acc.bbox[i]);
+      }
+      if (features & FEAT_MOMENTS) {
+        (*col++)[b] = acc.m000;
+        (*col++)[b] = acc.m100;
+        (*col++)[b] = acc.m010;
+        if (im3d)
+          (*col++)[b] = acc.m001;
+        (*col++)[b] = acc.m110;
+        if (im3d) {
+          (*col++)[b] = acc.m101;
+          (*col++)[b] = acc.m011;
+        }
+        (*col++)[b] = acc.m200;
+        (*col++)[b] = acc.m020;
+        if (im3d)
+          (*col++)[b] = acc.m002;
+      }
+      if (features & FEAT_ENTROPY)
+        (*col++)[b] = entropy(acc);
+    }
+
+    // Same as measEntropyFunc
+    static double entropy(Accumulator &acc)
+    {
+      double sumP = 0., sumN = 0.;
+
+      if (!acc.histo.empty()) {
+        for (size_t i = 0; i < acc.histoUsed.size(); i++) {
+          UINT &nb = acc.histo[acc.histoUsed[i]];
+          sumN += nb;
+          sumP += nb * log2(nb);
+          nb = 0;
+        }
+      } else {
+        sort(acc.values.begin(), acc.values.end());
+        for (size_t i = 0; i < acc.values.size();) {
+          size_t j = i;
+          while (j < acc.values.size() && acc.values[j] == acc.values[i])
+            j++;
+          double nb = double(j - i);
+          sumN += nb;
+          sumP += nb * log2(nb);
+          i = j;
+        }
+      }
+      return sumN > 0 ? log2(sumN) - sumP / sumN : 0.;
+    }
+
+    // Same as Image::getCoordsFromOffset()
+    void getCoords(size_t off, size_t &x, size_t &y, size_t &z) const
+    {
+      z = off / (imSize[0] * imSize[1]);
+      y = (off % (imSize[0] * imSize[1])) / imSize[0];
+      x = off % imSize[0];
+    }
+
+    void initColumns()
+    {
+      const char *xyz[] = {"X", "Y", "Z"};
+      const char *bboxNames[] = {"xMin", "yMin", "zMin",
+                                 "xMax", "yMax", "zMax"};
+      const char *moments2D[] = {"m00", "m10", "m01", "m11", "m20", "m02"};
+      const char *moments3D[] = {"m000", "m100", "m010", "m001", "m110",
+                                 "m101", "m011", "m200", "m020", "m002"};
+
+      columnNames.clear();
+      if (features & FEAT_AREA)
+        columnNames.push_back("area");
+      if (features & FEAT_VOLUME)
+        columnNames.push_back("volume");
+      if (features & FEAT_MIN_VAL)
+        columnNames.push_back("minVal");
+      if (features & FEAT_MAX_VAL)
+        columnNames.push_back("maxVal");
+      if (features & FEAT_MEAN_VAL) {
+        columnNames.push_back("meanVal");
+        columnNames.push_back("stdDev");
+      }
+      if (features & FEAT_BARYCENTER)
+        for (int i = 0; i < (im3d ? 3 : 2); i++)
+          columnNames.push_back(string("barycenter") + xyz[i]);
+      if (features & FEAT_BOUND_BOX)
+        for (int i = 0; i < 6; i++)
+          if (imSize[2] > 1 || i % 3 != 2)
+            columnNames.push_back(bboxNames[i]);
+      if (features & FEAT_MOMENTS)
+        for (int i = 0; i < (im3d ? 10 : 6); i++)
+          columnNames.push_back(im3d ? moments3D[i] : moments2D[i]);
+      if (features & FEAT_ENTROPY)
+        columnNames.push_back("entropy");
+
+      columns.assign(columnNames.size(), Vector_double(blobNbr + 1, 0.));
+    }
+#endif // SWIG
+
+    UINT features;
+    size_t blobNbr;
+    size_t imSize[3];
+    bool im3d;
+    vector<string> columnNames;
+    vector<Vector_double> columns;
+  };
+
   /** @}*/
 
 } // namespace smil
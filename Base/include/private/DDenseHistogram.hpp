@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_DENSE_HISTOGRAM_HPP
+#define _D_DENSE_HISTOGRAM_HPP
+
+#include "Core/include/private/DImage.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace smil
+{
+  /**
+   * @addtogroup Histogram
+   * @{
+   */
+
+#ifndef SWIG
+  /**
+   * Dense image histogram
+   *
+   * Pixel values are counted in arrays indexed by value for integer types up
+   * to 16 bits, and for wider integer types whose range of values is not
+   * larger than @b MAX_DENSE_RANGE. Floating point images and wider ranges
+   * are counted in a sparse @b map.
+   *
+   * Consecutive pixels are counted in four interleaved counter arrays, so
+   * that runs of equal values don't wait for the store of the previous
+   * increment. compute() counts one part of the image per thread and merges
+   * the sub-histograms at the end.
+   *
+   * @note Available only in C++
+   */
+  template <class T> class DenseHistogram
+  {
+  public:
+    typedef typename Image<T>::lineType lineType;
+
+    // Largest range of values of wide integer types counted in dense arrays
+    static const size_t MAX_DENSE_RANGE = 1 << 20;
+    // Under this number of pixels, compute() runs on a single thread
+    static const size_t MIN_PARALLEL_PIXELS = 1 << 16;
+
+    DenseHistogram()
+        : dense(false), offset(0), card(0), pending(0),
+          rangeMin(ImDtTypes<T>::min()), rangeMax(ImDtTypes<T>::max())
+    {
+    }
+
+    /**
+     * Prepare the counters for the values in <b>[minVal, maxVal]</b>
+     *
+     * @param[in] minVal, maxVal : range of the values to count
+     */
+    void initialize(T minVal, T maxVal)
+    {
+      rangeMin = minVal;
+      rangeMax = maxVal;
+
+      bool isDense = false;
+      T newOffset  = 0;
+      size_t newCard = 0;
+
+      if (std::numeric_limits<T>::is_integer) {
+        if (sizeof(T) <= 2) {
+          newOffset = ImDtTypes<T>::min();
+          newCard   = ImDtTypes<T>::cardinal();
+          isDense   = true;
+        } else if (minVal <= maxVal) {
+          newOffset = minVal;
+          newCard   = size_t(maxVal) - size_t(minVal) + 1;
+          isDense   = newCard > 0 && newCard <= size_t(MAX_DENSE_RANGE);
+        }
+      }
+
+      if (isDense && dense && newOffset == offset && newCard == card) {
+        clear();
+        return;
+      }
+
+      dense   = isDense;
+      offset  = newOffset;
+      card    = isDense ? newCard : 0;
+      pending = 0;
+      lanes.assign(4 * card, 0);
+      counts.assign(card, 0);
+      sparse.clear();
+    }
+
+    /**
+     * Prepare the counters for the values of the image @b imIn
+     */
+    void initialize(const Image<T> &imIn)
+    {
+      if (!std::numeric_limits<T>::is_integer || sizeof(T) <= 2) {
+        initialize(ImDtTypes<T>::min(), ImDtTypes<T>::max());
+        return;
+      }
+
+      lineType pixels = imIn.getPixels();
+      size_t pixCount = imIn.getPixelCount();
+      T minVal = ImDtTypes<T>::max(), maxVal = ImDtTypes<T>::min();
+      for (size_t i = 0; i < pixCount; i++) {
+        if (pixels[i] < minVal)
+          minVal = pixels[i];
+        if (pixels[i] > maxVal)
+          maxVal = pixels[i];
+      }
+      initialize(minVal, maxVal);
+    }
+
+    /**
+     * Prepare the counters for the same range of values as @b other, without
+     * scanning an image again
+     */
+    void initialize(const DenseHistogram &other)
+    {
+      initialize(other.rangeMin, other.rangeMax);
+    }
+
+    /**
+     * Reset all counters to zero
+     */
+    void clear()
+    {
+      std::fill(lanes.begin(), lanes.end(), 0);
+      std::fill(counts.begin(), counts.end(), 0);
+      sparse.clear();
+      pending = 0;
+    }
+
+    bool isDense() const
+    {
+      return dense;
+    }
+
+    /**
+     * Count the values of a sequence of pixels
+     */
+    void addSequence(const T *pixels, size_t size)
+    {
+      if (!dense) {
+        for (size_t i = 0; i < size; i++)
+          sparse[pixels[i]]++;
+        return;
+      }
+
+      while (size > 0) {
+        size_t chunk = reserve(size);
+        UINT32 *l0   = lanes.data();
+        UINT32 *l1   = l0 + card;
+        UINT32 *l2   = l1 + card;
+        UINT32 *l3   = l2 + card;
+
+        size_t i = 0;
+        for (; i + 4 <= chunk; i += 4) {
+          l0[index(pixels[i])]++;
+          l1[index(pixels[i + 1])]++;
+          l2[index(pixels[i + 2])]++;
+          l3[index(pixels[i + 3])]++;
+        }
+        for (; i < chunk; i++)
+          l0[index(pixels[i])]++;
+
+        pixels += chunk;
+        size -= chunk;
+      }
+    }
+
+    /**
+     * Count the values of the pixels of a sequence where @b mask is not zero
+     */
+    void addSequence(const T *pixels, const T *mask, size_t size)
+    {
+      if (!dense) {
+        for (size_t i = 0; i < size; i++)
+          if (mask[i] != T(0))
+            sparse[pixels[i]]++;
+        return;
+      }
+
+      while (size > 0) {
+        size_t chunk = reserve(size);
+        UINT32 *l    = lanes.data();
+
+        for (size_t i = 0; i < chunk; i++)
+          if (mask[i] != T(0))
+            l[(i & 3) * card + index(pixels[i])]++;
+
+        pixels += chunk;
+        mask += chunk;
+        size -= chunk;
+      }
+    }
+
+    /**
+     * Add the counts of another histogram, initialized with the same range
+     */
+    void merge(const DenseHistogram &other)
+    {
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it;
+        for (it = other.sparse.begin(); it != other.sparse.end(); it++)
+          sparse[it->first] += it->second;
+        return;
+      }
+
+      for (size_t i = 0; i < card; i++)
+        counts[i] += other.getIndexCount(i);
+    }
+
+    /**
+     * Histogram of the image @b imIn
+     */
+    RES_T compute(const Image<T> &imIn)
+    {
+      ASSERT_ALLOCATED(&imIn);
+
+      initialize(imIn);
+      return computeParts(imIn, NULL);
+    }
+
+    /**
+     * Histogram of the image @b imIn in the region where @b imMask is not
+     * zero
+     */
+    RES_T compute(const Image<T> &imIn, const Image<T> &imMask)
+    {
+      ASSERT_ALLOCATED(&imIn, &imMask);
+      ASSERT_SAME_SIZE(&imIn, &imMask);
+
+      initialize(imIn);
+      return computeParts(imIn, &imMask);
+    }
+
+    /**
+     * Number of pixels counted with the value @b val
+     */
+    size_t getCount(T val) const
+    {
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it = sparse.find(val);
+        return it == sparse.end() ? 0 : it->second;
+      }
+      size_t i = index(val);
+      return i < card ? getIndexCount(i) : 0;
+    }
+
+    /**
+     * Total number of pixels counted
+     */
+    size_t getPixelCount() const
+    {
+      size_t nPix = 0;
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it;
+        for (it = sparse.begin(); it != sparse.end(); it++)
+          nPix += it->second;
+      } else
+        for (size_t i = 0; i < card; i++)
+          nPix += getIndexCount(i);
+      return nPix;
+    }
+
+    /**
+     * Smallest and largest values counted
+     *
+     * @return @b false if the histogram is empty
+     */
+    bool getRange(T &minVal, T &maxVal) const
+    {
+      if (!dense) {
+        if (sparse.empty())
+          return false;
+        minVal = sparse.begin()->first;
+        maxVal = sparse.rbegin()->first;
+        return true;
+      }
+
+      size_t first = 0, last = card;
+      while (first < card && getIndexCount(first) == 0)
+        first++;
+      if (first == card)
+        return false;
+      while (getIndexCount(last - 1) == 0)
+        last--;
+      minVal = value(first);
+      maxVal = value(last - 1);
+      return true;
+    }
+
+    /**
+     * Copy the counts into an array indexed by <b>value - min(T)</b>, with
+     * one entry per possible value of the type
+     */
+    void toArray(size_t *h) const
+    {
+      for (size_t i = 0; i < ImDtTypes<T>::cardinal(); i++)
+        h[i] = 0;
+
+      size_t typeMin = size_t(ImDtTypes<T>::min());
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it;
+        for (it = sparse.begin(); it != sparse.end(); it++)
+          h[size_t(it->first) - typeMin] = it->second;
+      } else {
+        size_t shift = size_t(offset) - typeMin;
+        for (size_t i = 0; i < card; i++)
+          h[shift + i] = getIndexCount(i);
+      }
+    }
+
+    /**
+     * Counts as a map with the pairs <b><value, count></b>
+     *
+     * Dense histograms contain every value in <b>[minVal, maxVal]</b>, even
+     * if its count is zero. Sparse ones contain only the values counted.
+     */
+    std::map<T, UINT> toMap(T minVal, T maxVal) const
+    {
+      std::map<T, UINT> h;
+
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it;
+        for (it = sparse.begin(); it != sparse.end(); it++)
+          h.insert(h.end(), std::pair<T, UINT>(it->first, UINT(it->second)));
+        return h;
+      }
+
+      if (minVal > maxVal)
+        return h;
+      size_t first = index(minVal), last = index(maxVal);
+      for (size_t i = first; i <= last && i < card; i++)
+        h.insert(h.end(), std::pair<T, UINT>(value(i), UINT(getIndexCount(i))));
+      return h;
+    }
+
+    /**
+     * Shannon entropy (in bits) of the values counted
+     */
+    double entropy() const
+    {
+      double sumP = 0.;
+      double sumN = 0.;
+
+      if (!dense) {
+        typename std::map<T, size_t>::const_iterator it;
+        for (it = sparse.begin(); it != sparse.end(); it++) {
+          sumN += it->second;
+          sumP += it->second * log2(it->second);
+        }
+      } else
+        for (size_t i = 0; i < card; i++) {
+          size_t nb = getIndexCount(i);
+          if (nb > 0) {
+            sumN += nb;
+            sumP += nb * log2(nb);
+          }
+        }
+
+      if (sumN > 0)
+        return log2(sumN) - sumP / sumN;
+      return 0.;
+    }
+
+  private:
+    size_t index(T val) const
+    {
+      return size_t(val) - size_t(offset);
+    }
+
+    T value(size_t i) const
+    {
+      return T(size_t(offset) + i);
+    }
+
+    size_t getIndexCount(size_t i) const
+    {
+      return counts[i] + lanes[i] + lanes[card + i] + lanes[2 * card + i] +
+             lanes[3 * card + i];
+    }
+
+    // Number of pixels which can be added to the 32 bits lanes before they
+    // must be flushed into the counts
+    size_t reserve(size_t size)
+    {
+      if (pending == UINT_MAX) {
+        for (size_t i = 0; i < card; i++)
+          counts[i] = getIndexCount(i);
+        std::fill(lanes.begin(), lanes.end(), 0);
+        pending = 0;
+      }
+      size_t chunk = std::min(size, size_t(UINT_MAX) - pending);
+      pending += chunk;
+      return chunk;
+    }
+
+    RES_T computeParts(const Image<T> &imIn, const Image<T> *imMask)
+    {
+      lineType pixels  = imIn.getPixels();
+      lineType maskPix = imMask ? imMask->getPixels() : NULL;
+      size_t pixCount  = imIn.getPixelCount();
+
+      int partNbr = 1;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+      if (pixCount >= MIN_PARALLEL_PIXELS)
+        partNbr = nthreads;
+#endif // USE_OPEN_MP
+
+      // One sub-histogram per thread, the first one being this one. The
+      // others allocate their counters in their own thread.
+      std::vector<DenseHistogram> parts(partNbr - 1);
+
+      int i;
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < partNbr; i++) {
+        DenseHistogram &h = i == 0 ? *this : parts[i - 1];
+        if (i > 0)
+          h.initialize(*this);
+        size_t begin      = pixCount * i / partNbr;
+        size_t end        = pixCount * (i + 1) / partNbr;
+        if (maskPix)
+          h.addSequence(pixels + begin, maskPix + begin, end - begin);
+        else
+          h.addSequence(pixels + begin, end - begin);
+      }
+
+      for (size_t p = 0; p < parts.size(); p++)
+        merge(parts[p]);
+
+      return RES_OK;
+    }
+
+    bool dense;
+    T offset;
+    size_t card;
+    size_t pending;
+    // Four interleaved arrays of counters, flushed into counts
+    std::vector<UINT32> lanes;
+    std::vector<size_t> counts;
+    std::map<T, size_t> sparse;
+    // Range given to initialize()
+    T rangeMin, rangeMax;
+  };
+#endif // SWIG
+
+  /** @} */
+} // namespace smil
+
+#endif // _D_DENSE_HISTOGRAM_HPP
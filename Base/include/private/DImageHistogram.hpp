@@ -33,6 +33,7 @@
 #include <climits>
 
 #include "DLineHistogram.hpp"
+#include "DDenseHistogram.hpp"
 #include "DImageArith.hpp"
 
 namespace smil
@@ -63,13 +64,10 @@ namespace smil
   ENABLE_IF(!IS_FLOAT(T), RES_T)
   histogram(const Image<T> &imIn, size_t *h)
   {
-    for (size_t i = 0; i < ImDtTypes<T>::cardinal(); i++)
-      h[i] = 0;
-
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      h[size_t(pixels[i] - ImDtTypes<T>::min())]++;
+    DenseHistogram<T> hist;
+    ASSERT(hist.compute(imIn) == RES_OK);
 
+    hist.toArray(h);
     return RES_OK;
   }
 
@@ -96,18 +94,41 @@ namespace smil
   {
     ASSERT(haveSameSize(&imIn, &imMask, NULL));
 
-    for (size_t i = 0; i < ImDtTypes<T>::cardinal(); i++)
-      h[i] = 0;
+    DenseHistogram<T> hist;
+    ASSERT(hist.compute(imIn, imMask) == RES_OK);
 
-    typename Image<T>::lineType pixels  = imIn.getPixels();
-    typename Image<T>::lineType maskPix = imMask.getPixels();
+    hist.toArray(h);
+    return RES_OK;
+  }
 
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      if (maskPix[i] != 0)
-        h[size_t(pixels[i] - ImDtTypes<T>::min())]++;
+  /** @cond */
+  // Add the values of the type outside [minVal, maxVal], with a null count
+  template <class T>
+  void addFullRange(std::map<T, UINT> &h, T minVal, T maxVal)
+  {
+    for (T i = ImDtTypes<T>::min(); i < minVal; i++)
+      h.insert(pair<T, UINT>(i, 0));
+    for (T i = maxVal; i <= ImDtTypes<T>::max() && i != ImDtTypes<T>::min();
+         i++)
+      h.insert(pair<T, UINT>(i, 0));
+  }
 
-    return RES_OK;
+  // Add the non-null counts of h to the bins value / binSize of hist
+  template <class T>
+  void binHistogram(const DenseHistogram<T> &h, T binSize,
+                    std::map<T, UINT> &hist)
+  {
+    T minVal, maxVal;
+    if (!h.getRange(minVal, maxVal))
+      return;
+
+    std::map<T, UINT> counts = h.toMap(minVal, maxVal);
+    typename std::map<T, UINT>::iterator it;
+    for (it = counts.begin(); it != counts.end(); it++)
+      if (it->second > 0)
+        hist[it->first / binSize] += it->second;
   }
+  /** @endcond */
 #endif // SWIG
 
   /**
@@ -117,36 +138,27 @@ namespace smil
    * @param[in] fullRange : result contains all possible values in the image
    * type range
    * @return the histogram as a map with the pairs <b><value, count></b>.
+   *
+   * @note Values of <b>[min, max]</b> absent from the image are listed with a
+   * null count, except for floating point images and for 32 bits images
+   * whose range is wider than DenseHistogram::MAX_DENSE_RANGE: only the
+   * values present in the image are listed then.
    */
   template <class T>
   std::map<T, UINT> histogram(const Image<T> &imIn, bool fullRange = false)
   {
-    vector<T> rVals = rangeVal(imIn);
-    size_t card     = rVals[1] - rVals[0] + 1;
-
-    size_t *buf = new size_t[card];
-    for (size_t i = 0; i < card; i++)
-      buf[i] = 0;
-
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      buf[size_t(pixels[i] - rVals[0])]++;
-
     map<T, UINT> h;
 
-    if (fullRange)
-      for (T i = ImDtTypes<T>::min(); i < rVals[0]; i++)
-        h.insert(pair<T, UINT>(i, 0));
+    DenseHistogram<T> hist;
+    ASSERT(hist.compute(imIn) == RES_OK, h);
 
-    for (size_t i = 0; i < card; i++)
-      h.insert(pair<T, UINT>(i + rVals[0], buf[i]));
+    T minVal, maxVal;
+    if (!hist.getRange(minVal, maxVal))
+      return h;
+    h = hist.toMap(minVal, maxVal);
 
     if (fullRange)
-      for (T i = rVals[1]; i <= ImDtTypes<T>::max() && i != ImDtTypes<T>::min();
-           i++)
-        h.insert(pair<T, UINT>(i, 0));
-
-    delete[] buf;
+      addFullRange(h, minVal, maxVal);
 
     return h;
   }
@@ -162,6 +174,8 @@ namespace smil
    * type range
    * @return the histogram as a map with the pairs <b><value, count></b>.
    *
+   * @note As with histogram(imIn), values absent from the masked region are
+   * not listed for images counted in a sparse histogram.
    */
   template <class T>
   std::map<T, UINT> histogram(const Image<T> &imIn, const Image<T> &imMask,
@@ -171,32 +185,15 @@ namespace smil
 
     ASSERT(haveSameSize(&imIn, &imMask, NULL), h);
 
-    vector<T> rVals = rangeVal(imIn);
-    size_t card     = rVals[1] - rVals[0] + 1;
-
-    size_t *buf = new size_t[card];
-    for (size_t i = 0; i < card; i++)
-      buf[i] = 0;
-
-    typename Image<T>::lineType pixels     = imIn.getPixels();
-    typename Image<T>::lineType maskPixels = imMask.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      if (maskPixels[i] != 0)
-        buf[size_t(pixels[i] - rVals[0])]++;
-
-    if (fullRange)
-      for (T i = ImDtTypes<T>::min(); i < rVals[0]; i++)
-        h.insert(pair<T, UINT>(i, 0));
+    DenseHistogram<T> hist;
+    ASSERT(hist.compute(imIn, imMask) == RES_OK, h);
 
-    for (size_t i = 0; i < card; i++)
-      h.insert(pair<T, UINT>(i + rVals[0], buf[i]));
+    // The values range over the whole image, not only the masked region
+    vector<T> rVals = rangeVal(imIn);
+    h               = hist.toMap(rVals[0], rVals[1]);
 
     if (fullRange)
-      for (T i = rVals[1]; i <= ImDtTypes<T>::max() && i != ImDtTypes<T>::min();
-           i++)
-        h.insert(pair<T, UINT>(i, 0));
-
-    delete[] buf;
+      addFullRange(h, rVals[0], rVals[1]);
 
     return h;
   }
@@ -216,9 +213,9 @@ namespace smil
 
     binSize = std::max(binSize, T(1));
 
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      hist[pixels[i] / binSize]++;
+    DenseHistogram<T> h;
+    ASSERT(h.compute(imIn) == RES_OK, hist);
+    binHistogram(h, binSize, hist);
 
     return hist;
   }
@@ -241,9 +238,9 @@ namespace smil
 
     binSize = std::max(binSize, T(1));
 
-    typename Image<T>::lineType pixels = imIn.getPixels();
-    for (size_t i = 0; i < imIn.getPixelCount(); i++)
-      hist[pixels[i] / binSize]++;
+    DenseHistogram<T> h;
+    ASSERT(h.compute(imIn, imMask) == RES_OK, hist);
+    binHistogram(h, binSize, hist);
 
     return hist;
   }
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_INTEGRAL_IMAGE_HPP
+#define _D_INTEGRAL_IMAGE_HPP
+
+#include <limits>
+#include <type_traits>
+
+#include "Core/include/private/DImage.hpp"
+#include "Core/include/private/DTraits.hpp"
+#include "Core/include/DErrors.h"
+
+namespace smil
+{
+  /**
+   * @ingroup Base
+   * @defgroup IntegralImage Integral images
+   *
+   * Summed area tables, giving the sum of the pixels of any box of an
+   * image with a constant number of operations (4 lookups in 2D, 8 in 3D).
+   * @{
+   */
+
+  /** @cond */
+  // Sums are exact for integer types (as long as they don't overflow 64 bits)
+  template <class T> struct IntegralSumType {
+    typedef typename std::conditional<
+        IS_FLOAT(T), double,
+        typename std::conditional<std::numeric_limits<T>::is_signed, int64_t,
+                                  UINT64>::type>::type type;
+  };
+  /** @endcond */
+
+  /**
+   * Integral image (summed area table)
+   *
+   * Each entry holds the sum of the input pixels of coordinates strictly
+   * lower than its own. The table is padded with a leading zero row and
+   * column (and slice for 3D images), so that box queries don't need any
+   * test.
+   *
+   * @b Example:
+   * @code{.cpp}
+   * IntegralImage<UINT8> integral(im);
+   * // sum of the pixels of the 11x11 box centered on (x, y)
+   * UINT64 s = integral.getSum(x - 5, y - 5, x + 5, y + 5);
+   * @endcode
+   */
+  template <class T> class IntegralImage
+  {
+  public:
+    typedef typename IntegralSumType<T>::type sumType;
+
+    IntegralImage() : width(0), height(0), depth(0)
+    {
+    }
+
+    /**
+     * Build the integral image of @b imIn (or of its squared values)
+     */
+    IntegralImage(const Image<T> &imIn, bool squares = false)
+        : width(0), height(0), depth(0)
+    {
+      compute(imIn, squares);
+    }
+
+    /**
+     * compute() - (Re)build the table from @b imIn
+     *
+     * @param[in] imIn : input image
+     * @param[in] squares : sum the squared pixel values instead (to compute
+     * local variances)
+     */
+    RES_T compute(const Image<T> &imIn, bool squares = false)
+    {
+      ASSERT_ALLOCATED(&imIn);
+
+      size_t s[3];
+      imIn.getSize(s);
+      width  = s[0];
+      height = s[1];
+      depth  = s[2];
+
+      stride      = width + 1;
+      sliceStride = stride * (height + 1);
+      data.assign(sliceStride * (depth > 1 ? depth + 1 : 1), sumType(0));
+
+      typename ImDtTypes<T>::lineType pixels = imIn.getPixels();
+      sumType *sums                          = data.data();
+
+      // Running sums along the lines
+      int lineNbr = height * depth;
+      int l;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (l = 0; l < lineNbr; l++) {
+        size_t y       = l % height;
+        size_t z       = l / height;
+        const T *in    = pixels + size_t(l) * width;
+        sumType *out   = sums + rowOffset(y + 1, z + 1) + 1;
+        sumType runSum = 0;
+        if (squares) {
+          for (size_t x = 0; x < width; x++) {
+            runSum += sumType(in[x]) * sumType(in[x]);
+            out[x] = runSum;
+          }
+        } else {
+          for (size_t x = 0; x < width; x++) {
+            runSum += sumType(in[x]);
+            out[x] = runSum;
+          }
+        }
+      }
+
+      // Accumulate the lines along y
+      int z;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (z = 0; z < int(depth); z++) {
+        for (size_t y = 2; y <= height; y++) {
+          sumType *cur        = sums + rowOffset(y, z + 1);
+          const sumType *prev = cur - stride;
+          for (size_t x = 1; x <= width; x++)
+            cur[x] += prev[x];
+        }
+      }
+
+      // And the slices along z
+      if (depth > 1) {
+        int y;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (y = 1; y <= int(height); y++) {
+          for (size_t z = 2; z <= depth; z++) {
+            sumType *cur        = sums + rowOffset(y, z);
+            const sumType *prev = cur - sliceStride;
+            for (size_t x = 1; x <= width; x++)
+              cur[x] += prev[x];
+          }
+        }
+      }
+
+      return RES_OK;
+    }
+
+    bool isEmpty() const
+    {
+      return data.empty();
+    }
+
+    void getSize(size_t s[3]) const
+    {
+      s[0] = width;
+      s[1] = height;
+      s[2] = depth;
+    }
+
+    /**
+     * getSum() - Sum of the pixels of the box [x0,x1]x[y0,y1]x[z0,z1]
+     *
+     * Bounds are inclusive. The box is clipped to the image.
+     */
+    sumType getSum(int x0, int y0, int z0, int x1, int y1, int z1) const
+    {
+      size_t xa, xb, ya, yb, za, zb;
+      if (!clip(x0, x1, width, xa, xb) || !clip(y0, y1, height, ya, yb) ||
+          !clip(z0, z1, depth, za, zb))
+        return sumType(0);
+      return boxSum(xa, xb, rowOffset(ya, za), rowOffset(yb, za),
+                    rowOffset(ya, zb), rowOffset(yb, zb));
+    }
+
+    /**
+     * getSum() - Sum of the pixels of the rectangle [x0,x1]x[y0,y1] (2D
+     * images)
+     */
+    sumType getSum(int x0, int y0, int x1, int y1) const
+    {
+      return getSum(x0, y0, 0, x1, y1, 0);
+    }
+
+    /**
+     * getCount() - Number of pixels of the box [x0,x1]x[y0,y1]x[z0,z1] lying
+     * inside the image
+     */
+    size_t getCount(int x0, int y0, int z0, int x1, int y1, int z1) const
+    {
+      size_t xa, xb, ya, yb, za, zb;
+      if (!clip(x0, x1, width, xa, xb) || !clip(y0, y1, height, ya, yb) ||
+          !clip(z0, z1, depth, za, zb))
+        return 0;
+      return (xb - xa) * (yb - ya) * (zb - za);
+    }
+
+    /**
+     * getMean() - Mean value of the pixels of the box [x0,x1]x[y0,y1]x[z0,z1]
+     * lying inside the image (0 if there is none)
+     */
+    double getMean(int x0, int y0, int z0, int x1, int y1, int z1) const
+    {
+      size_t n = getCount(x0, y0, z0, x1, y1, z1);
+      if (n == 0)
+        return 0.;
+      return double(getSum(x0, y0, z0, x1, y1, z1)) / double(n);
+    }
+
+    /**
+     * boxMean() - Mean of the box [x+dx0,x+dx1]x[y+dy0,y+dy1]x[z+dz0,z+dz1]
+     * around each pixel
+     *
+     * Boxes are clipped to the image, so that border pixels get the mean of
+     * their neighbors lying inside the image. The cost doesn't depend on the
+     * size of the box.
+     *
+     * @param[in] dx0, dx1, dy0, dy1, dz0, dz1 : bounds of the box (inclusive)
+     * @param[out] imOut : output image (same size as the input image)
+     */
+    template <class T_out>
+    RES_T boxMean(int dx0, int dx1, int dy0, int dy1, int dz0, int dz1,
+                  Image<T_out> &imOut) const
+    {
+      ASSERT(!data.empty(), "Integral image not computed", RES_ERR);
+      ASSERT_ALLOCATED(&imOut);
+
+      size_t s[3];
+      imOut.getSize(s);
+      ASSERT(s[0] == width && s[1] == height && s[2] == depth,
+             RES_ERR_BAD_SIZE);
+
+      ImageFreezer freeze(imOut);
+
+      typename ImDtTypes<T_out>::lineType pixelsOut = imOut.getPixels();
+
+      int lineNbr = height * depth;
+      int l;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (l = 0; l < lineNbr; l++) {
+        int y      = l % height;
+        int z      = l / height;
+        T_out *out = pixelsOut + size_t(l) * width;
+
+        size_t ya, yb, za, zb;
+        if (!clip(y + dy0, y + dy1, height, ya, yb) ||
+            !clip(z + dz0, z + dz1, depth, za, zb)) {
+          for (size_t x = 0; x < width; x++)
+            out[x] = T_out(0);
+          continue;
+        }
+        size_t o00 = rowOffset(ya, za), o10 = rowOffset(yb, za);
+        size_t o01 = rowOffset(ya, zb), o11 = rowOffset(yb, zb);
+        size_t lineCount = (yb - ya) * (zb - za);
+
+        for (int x = 0; x < int(width); x++) {
+          size_t xa = size_t(std::min(std::max(x + dx0, 0), int(width)));
+          size_t xb = size_t(std::min(std::max(x + dx1 + 1, 0), int(width)));
+          if (xb <= xa) {
+            out[x] = T_out(0);
+            continue;
+          }
+          out[x] = T_out(double(boxSum(xa, xb, o00, o10, o01, o11)) /
+                         double((xb - xa) * lineCount));
+        }
+      }
+
+      return RES_OK;
+    }
+
+  private:
+    size_t width, height, depth;
+    size_t stride, sliceStride;
+    vector<sumType> data;
+
+    // Offset of the padded row y of the padded slice z (z is ignored in 2D)
+    inline size_t rowOffset(size_t y, size_t z) const
+    {
+      return (depth > 1 ? z * sliceStride : 0) + y * stride;
+    }
+
+    // Half-open padded range [a,b) of the inclusive range [v0,v1] clipped to
+    // [0,size)
+    static inline bool clip(int v0, int v1, size_t size, size_t &a, size_t &b)
+    {
+      v0 = std::max(v0, 0);
+      v1 = std::min(v1 + 1, int(size));
+      if (v1 <= v0)
+        return false;
+      a = v0;
+      b = v1;
+      return true;
+    }
+
+    inline sumType boxSum(size_t xa, size_t xb, size_t o00, size_t o10,
+                          size_t o01, size_t o11) const
+    {
+      const sumType *d = data.data();
+      sumType s = d[o10 + xb] - d[o10 + xa] - d[o00 + xb] + d[o00 + xa];
+      if (depth > 1)
+        s = d[o11 + xb] - d[o11 + xa] - d[o01 + xb] + d[o01 + xa] - s;
+      return s;
+    }
+  };
+
+  /** @} */
+
+} // namespace smil
+
+#endif // _D_INTEGRAL_IMAGE_HPP
@@ -32,10 +32,13 @@
 
 #include "Core/include/private/DImage.hpp"
 #include "DBaseMeasureOperations.hpp"
+#include "DDenseHistogram.hpp"
 #include "DImageArith.hpp"
 #include "Base/include/DImageDraw.h"
 
+#include <algorithm>
 #include <cmath>
+#include <type_traits>
 #include <map>
 #include <set>
 #include <iostream>
@@ -53,14 +56,66 @@ namespace smil
    */
 
   /** @cond */
+  // Sums of the values, and of their squares, of a sequence. Integer types
+  // are summed by blocks in 64 bits integers, which is exact and lets the
+  // loops be vectorized.
+  template <class T> struct SequenceSums {
+    typedef typename std::conditional<std::numeric_limits<T>::is_signed,
+                                      int64_t, UINT64>::type intType;
+    typedef typename std::conditional<
+        std::numeric_limits<T>::is_integer && sizeof(T) <= 4, intType,
+        double>::type sumType;
+    typedef typename std::conditional<
+        std::numeric_limits<T>::is_integer && sizeof(T) <= 2, intType,
+        double>::type sum2Type;
+
+    // Small enough for the integer sums not to overflow
+    static const size_t BLOCK_SIZE = 1 << 16;
+
+    static double sum(const T *lineIn, size_t size)
+    {
+      double total = 0.;
+      for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+        size_t end = min(size, start + BLOCK_SIZE);
+        sumType s  = 0;
+        for (size_t i = start; i < end; i++)
+          s += sumType(lineIn[i]);
+        total += double(s);
+      }
+      return total;
+    }
+
+    static double sum2(const T *lineIn, size_t size)
+    {
+      double total = 0.;
+      for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+        size_t end = min(size, start + BLOCK_SIZE);
+        sum2Type s = 0;
+        for (size_t i = start; i < end; i++)
+          s += sum2Type(lineIn[i]) * sum2Type(lineIn[i]);
+        total += double(s);
+      }
+      return total;
+    }
+  };
+
   template <class T>
   struct measAreaFunc : public MeasureFunctionBase<T, double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, double> parentClass;
 
     virtual void processSequence(lineType /*lineIn*/, size_t size)
     {
       this->retVal += size;
     }
+    virtual parentClass *clone() const
+    {
+      return new measAreaFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      this->retVal += other.retVal;
+    }
   };
   /** @endcond */
 
@@ -96,11 +151,19 @@ namespace smil
   template <class T>
   struct measVolFunc : public MeasureFunctionBase<T, double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, double> parentClass;
 
     virtual void processSequence(lineType lineIn, size_t size)
     {
-      for (size_t i = 0; i < size; i++)
-        this->retVal += double(lineIn[i]);
+      this->retVal += SequenceSums<T>::sum(lineIn, size);
+    }
+    virtual parentClass *clone() const
+    {
+      return new measVolFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      this->retVal += other.retVal;
     }
   };
   /** @endcond */
@@ -165,6 +228,7 @@ namespace smil
   template <class T>
   struct measMeanValFunc : public MeasureFunctionBase<T, Vector_double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, Vector_double> parentClass;
     double sum1, sum2;
     double pixNbr;
 
@@ -175,13 +239,20 @@ namespace smil
     }
     virtual void processSequence(lineType lineIn, size_t size)
     {
-      double curV;
-      for (size_t i = 0; i < size; i++) {
-        pixNbr += 1;
-        curV = lineIn[i];
-        sum1 += curV;
-        sum2 += curV * curV;
-      }
+      pixNbr += size;
+      sum1 += SequenceSums<T>::sum(lineIn, size);
+      sum2 += SequenceSums<T>::sum2(lineIn, size);
+    }
+    virtual parentClass *clone() const
+    {
+      return new measMeanValFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measMeanValFunc &o = static_cast<const measMeanValFunc &>(other);
+      pixNbr += o.pixNbr;
+      sum1 += o.sum1;
+      sum2 += o.sum2;
     }
     virtual void finalize(const Image<T> & /*imIn*/)
     {
@@ -221,21 +292,33 @@ namespace smil
   /** @cond */
   template <class T> struct measMinValFunc : public MeasureFunctionBase<T, T> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, T> parentClass;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
       this->retVal = numeric_limits<T>::max();
     }
     virtual void processSequence(lineType lineIn, size_t size)
     {
+      T minV = this->retVal;
       for (size_t i = 0; i < size; i++)
-        if (lineIn[i] < this->retVal)
-          this->retVal = lineIn[i];
+        minV = lineIn[i] < minV ? lineIn[i] : minV;
+      this->retVal = minV;
+    }
+    virtual parentClass *clone() const
+    {
+      return new measMinValFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      if (other.retVal < this->retVal)
+        this->retVal = other.retVal;
     }
   };
 
   template <class T>
   struct measMinValPosFunc : public MeasureFunctionWithPos<T, T> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, T> parentClass;
     Point<UINT> pt;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
@@ -252,6 +335,19 @@ namespace smil
           pt.z         = z;
         }
     }
+    virtual parentClass *clone() const
+    {
+      return new measMinValPosFunc(*this);
+    }
+    // Parts are combined in order: keep the first position
+    virtual void combine(const parentClass &other)
+    {
+      const measMinValPosFunc &o = static_cast<const measMinValPosFunc &>(other);
+      if (o.retVal < this->retVal) {
+        this->retVal = o.retVal;
+        pt           = o.pt;
+      }
+    }
   };
   /** @endcond */
 
@@ -296,21 +392,33 @@ namespace smil
   /** @cond */
   template <class T> struct measMaxValFunc : public MeasureFunctionBase<T, T> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, T> parentClass;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
       this->retVal = numeric_limits<T>::min();
     }
     virtual void processSequence(lineType lineIn, size_t size)
     {
+      T maxV = this->retVal;
       for (size_t i = 0; i < size; i++)
-        if (lineIn[i] > this->retVal)
-          this->retVal = lineIn[i];
+        maxV = lineIn[i] > maxV ? lineIn[i] : maxV;
+      this->retVal = maxV;
+    }
+    virtual parentClass *clone() const
+    {
+      return new measMaxValFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      if (other.retVal > this->retVal)
+        this->retVal = other.retVal;
     }
   };
 
   template <class T>
   struct measMaxValPosFunc : public MeasureFunctionWithPos<T, T> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, T> parentClass;
     Point<UINT> pt;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
@@ -327,6 +435,19 @@ namespace smil
           pt.z         = z;
         }
     }
+    virtual parentClass *clone() const
+    {
+      return new measMaxValPosFunc(*this);
+    }
+    // Parts are combined in order: keep the first position
+    virtual void combine(const parentClass &other)
+    {
+      const measMaxValPosFunc &o = static_cast<const measMaxValPosFunc &>(other);
+      if (o.retVal > this->retVal) {
+        this->retVal = o.retVal;
+        pt           = o.pt;
+      }
+    }
   };
   /** @endcond */
 
@@ -372,6 +493,7 @@ namespace smil
   template <class T>
   struct measMinMaxValFunc : public MeasureFunctionBase<T, vector<T>> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, vector<T>> parentClass;
     T minVal, maxVal;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
@@ -381,19 +503,32 @@ namespace smil
     }
     virtual void processSequence(lineType lineIn, size_t size)
     {
+      T minV = minVal, maxV = maxVal;
       for (size_t i = 0; i < size; i++) {
         T val = lineIn[i];
-        if (val > maxVal)
-          maxVal = val;
-        if (val < minVal)
-          minVal = val;
+        maxV  = val > maxV ? val : maxV;
+        minV  = val < minV ? val : minV;
       }
+      minVal = minV;
+      maxVal = maxV;
     }
     virtual void finalize(const Image<T> & /*imIn*/)
     {
       this->retVal.push_back(minVal);
       this->retVal.push_back(maxVal);
     }
+    virtual parentClass *clone() const
+    {
+      return new measMinMaxValFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measMinMaxValFunc &o = static_cast<const measMinMaxValFunc &>(other);
+      if (o.minVal < minVal)
+        minVal = o.minVal;
+      if (o.maxVal > maxVal)
+        maxVal = o.maxVal;
+    }
   };
   /** @endcond */
 
@@ -423,6 +558,7 @@ namespace smil
   template <class T>
   struct valueListFunc : public MeasureFunctionBase<T, vector<T>> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, vector<T>> parentClass;
     set<T> valList;
 
     virtual void initialize(const Image<T> & /*imIn*/)
@@ -442,6 +578,15 @@ namespace smil
       std::copy(valList.begin(), valList.end(),
                 std::back_inserter(this->retVal));
     }
+    virtual parentClass *clone() const
+    {
+      return new valueListFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const valueListFunc &o = static_cast<const valueListFunc &>(other);
+      valList.insert(o.valList.begin(), o.valList.end());
+    }
   };
   /** @endcond */
 
@@ -472,6 +617,7 @@ namespace smil
   //   #    #   ####   #####   ######    ##    #    #  ######
   //
   /** @cond */
+  // Not computed in parallel: ties are resolved in the order of the pixels
   template <class T> struct measModeValFunc : public MeasureFunctionBase<T, T> {
     typedef typename Image<T>::lineType lineType;
 
@@ -539,6 +685,7 @@ namespace smil
   template <class T>
   struct measMedianValFunc : public MeasureFunctionBase<T, T> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, T> parentClass;
 
     map<int, int> nbList;
     size_t acc_elem, total_elems;
@@ -587,6 +734,19 @@ namespace smil
       // this->retVal.push_back(xSum/tSum);
     }
 
+    virtual parentClass *clone() const
+    {
+      return new measMedianValFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measMedianValFunc &o = static_cast<const measMedianValFunc &>(other);
+      std::map<int, int>::const_iterator it;
+      for (it = o.nbList.begin(); it != o.nbList.end(); it++)
+        nbList[it->first] += it->second;
+      total_elems += o.total_elems;
+    }
+
   }; // END measMedianValFunc
   /** @endcond */
 
@@ -658,6 +818,7 @@ namespace smil
   template <class T>
   struct measBarycenterFunc : public MeasureFunctionWithPos<T, Vector_double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, Vector_double> parentClass;
     double xSum, ySum, zSum, tSum;
     virtual void initialize(const Image<T> & /*imIn*/)
     {
@@ -667,13 +828,15 @@ namespace smil
     virtual void processSequence(lineType lineIn, size_t size, size_t x,
                                  size_t y, size_t z)
     {
-      for (size_t i = 0; i < size; i++, x++) {
-        T pixVal = lineIn[i];
-        xSum += double(pixVal) * x;
-        ySum += double(pixVal) * y;
-        zSum += double(pixVal) * z;
-        tSum += double(pixVal);
-      }
+      // y and z are constant along the sequence
+      double s0 = SequenceSums<T>::sum(lineIn, size);
+      double s1 = 0.;
+      for (size_t i = 0; i < size; i++)
+        s1 += double(lineIn[i]) * double(x + i);
+      xSum += s1;
+      ySum += s0 * y;
+      zSum += s0 * z;
+      tSum += s0;
     }
     virtual void finalize(const Image<T> &imIn)
     {
@@ -682,6 +845,19 @@ namespace smil
       if (imIn.getDimension() == 3)
         this->retVal.push_back(zSum / tSum);
     }
+    virtual parentClass *clone() const
+    {
+      return new measBarycenterFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measBarycenterFunc &o =
+          static_cast<const measBarycenterFunc &>(other);
+      xSum += o.xSum;
+      ySum += o.ySum;
+      zSum += o.zSum;
+      tSum += o.tSum;
+    }
   };
   /** @endcond */
 
@@ -708,6 +884,7 @@ namespace smil
   template <class T>
   struct measBoundBoxFunc : public MeasureFunctionWithPos<T, vector<size_t>> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, vector<size_t>> parentClass;
     double xMin, xMax, yMin, yMax, zMin, zMax;
     bool im3d;
     virtual void initialize(const Image<T> &imIn)
@@ -753,6 +930,20 @@ namespace smil
       if (im3d)
         this->retVal.push_back(UINT(zMax));
     }
+    virtual parentClass *clone() const
+    {
+      return new measBoundBoxFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measBoundBoxFunc &o = static_cast<const measBoundBoxFunc &>(other);
+      xMin = min(xMin, o.xMin);
+      yMin = min(yMin, o.yMin);
+      zMin = min(zMin, o.zMin);
+      xMax = max(xMax, o.xMax);
+      yMax = max(yMax, o.yMax);
+      zMax = max(zMax, o.zMax);
+    }
   };
   /** @endcond */
 
@@ -781,6 +972,7 @@ namespace smil
   template <class T>
   struct measMomentsFunc : public MeasureFunctionWithPos<T, Vector_double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, Vector_double> parentClass;
     double m000, m100, m010, m110, m200, m020, m001, m101, m011, m002;
     bool im3d;
     virtual void initialize(const Image<T> &imIn)
@@ -792,20 +984,27 @@ namespace smil
     virtual void processSequence(lineType lineIn, size_t size, size_t x,
                                  size_t y, size_t z)
     {
-      for (size_t i = 0; i < size; i++, x++) {
-        double pxVal = double(lineIn[i]);
-        m000 += pxVal;
-        m100 += pxVal * x;
-        m010 += pxVal * y;
-        m110 += pxVal * x * y;
-        m200 += pxVal * x * x;
-        m020 += pxVal * y * y;
-        if (im3d) {
-          m001 += pxVal * z;
-          m101 += pxVal * x * z;
-          m011 += pxVal * y * z;
-          m002 += pxVal * z * z;
-        }
+      // y and z are constant along the sequence: only the sums of v, v.x
+      // and v.x^2 are needed
+      double s0 = SequenceSums<T>::sum(lineIn, size);
+      double s1 = 0., s2 = 0.;
+      for (size_t i = 0; i < size; i++) {
+        double xv = double(lineIn[i]) * double(x + i);
+        s1 += xv;
+        s2 += xv * double(x + i);
+      }
+      double yd = double(y), zd = double(z);
+      m000 += s0;
+      m100 += s1;
+      m010 += s0 * yd;
+      m110 += s1 * yd;
+      m200 += s2;
+      m020 += s0 * yd * yd;
+      if (im3d) {
+        m001 += s0 * zd;
+        m101 += s1 * zd;
+        m011 += s0 * yd * zd;
+        m002 += s0 * zd * zd;
       }
     }
     virtual void finalize(const Image<T> & /*imIn*/)
@@ -825,6 +1024,24 @@ namespace smil
       if (im3d)
         this->retVal.push_back(m002);
     }
+    virtual parentClass *clone() const
+    {
+      return new measMomentsFunc(*this);
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measMomentsFunc &o = static_cast<const measMomentsFunc &>(other);
+      m000 += o.m000;
+      m100 += o.m100;
+      m010 += o.m010;
+      m110 += o.m110;
+      m200 += o.m200;
+      m020 += o.m020;
+      m001 += o.m001;
+      m101 += o.m101;
+      m011 += o.m011;
+      m002 += o.m002;
+    }
   };
   /** @endcond */
 
@@ -1230,41 +1447,73 @@ namespace smil
   template <class T>
   struct measEntropyFunc : public MeasureFunctionBase<T, double> {
     typedef typename Image<T>::lineType lineType;
+    typedef MeasureFunctionBase<T, double> parentClass;
 
-    map<T, UINT> histo;
+    DenseHistogram<T> histo;
+    // Histogram whose range of values is reused by clones, so that the image
+    // is scanned only once
+    const DenseHistogram<T> *model;
 
-    virtual void initialize(const Image<T> & /*imIn*/)
+    measEntropyFunc() : model(NULL)
     {
-      histo.clear();
     }
 
-    virtual void processSequence(lineType lineIn, size_t size)
+    virtual void initialize(const Image<T> &imIn)
     {
-      for (size_t i = 0; i < size; i++) {
-        T val = lineIn[i];
+      if (model)
+        histo.initialize(*model);
+      else
+        histo.initialize(imIn);
+    }
 
-        UINT nb    = histo[val];
-        histo[val] = ++nb;
-      }
+    virtual void processSequence(lineType lineIn, size_t size)
+    {
+      histo.addSequence(lineIn, size);
     }
 
     virtual void finalize(const Image<T> & /*imIn*/)
     {
-      double entropy = 0.;
-      double sumP    = 0.;
-      double sumN    = 0.;
+      this->retVal = histo.entropy();
+    }
 
-      typename map<T, UINT>::iterator it;
-      for (it = histo.begin(); it != histo.end(); it++) {
-        if (it->second > 0) {
-          sumN += it->second;
-          sumP += it->second * log2(it->second);
-        }
+    // Blobs are usually much smaller than the range of values: their pixel
+    // values are sorted and counted by runs rather than in a histogram
+    virtual double processSequences(const Image<T> &imIn,
+                                    const PixelSequence *seqs, size_t seqNbr)
+    {
+      this->retVal = 0.;
+      ASSERT(CHECK_ALLOCATED(&imIn), RES_ERR_BAD_ALLOCATION, this->retVal);
+
+      lineType pixels = imIn.getPixels();
+      vector<T> values;
+      for (size_t i = 0; i < seqNbr; i++)
+        values.insert(values.end(), pixels + seqs[i].offset,
+                      pixels + seqs[i].offset + seqs[i].size);
+      std::sort(values.begin(), values.end());
+
+      double sumP = 0.;
+      double sumN = double(values.size());
+      for (size_t i = 0, j; i < values.size(); i = j) {
+        for (j = i + 1; j < values.size() && values[j] == values[i]; j++)
+          ;
+        sumP += (j - i) * log2(j - i);
       }
-      if (sumN > 0)
-        entropy = log2(sumN) - sumP / sumN;
 
-      this->retVal = entropy;
+      this->retVal = sumN > 0 ? log2(sumN) - sumP / sumN : 0.;
+      return this->retVal;
+    }
+
+    virtual parentClass *clone() const
+    {
+      // Clones start with empty counters over the range of this histogram
+      measEntropyFunc *f = new measEntropyFunc();
+      f->model           = &histo;
+      return f;
+    }
+    virtual void combine(const parentClass &other)
+    {
+      const measEntropyFunc &o = static_cast<const measEntropyFunc &>(other);
+      histo.merge(o.histo);
     }
   }; // END measEntropyFunc
 
@@ -1326,23 +1575,10 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imMask);
     ASSERT_SAME_SIZE(&imIn, &imMask);
 
-    double entropy = 0.;
-    double sumP    = 0.;
-    double sumN    = 0.;
-
-    map<T, UINT> hist = histogram(imIn, imMask, false);
-    typename map<T, UINT>::iterator it;
-    for (it = hist.begin(); it != hist.end(); it++) {
-      if (it->second > 0) {
-        sumP += it->second * log2(it->second);
-        sumN += it->second;
-      }
-    }
-
-    if (sumN > 0)
-      entropy = log2(sumN) - sumP / sumN;
+    DenseHistogram<T> hist;
+    hist.compute(imIn, imMask);
 
-    return entropy;
+    return hist.entropy();
   }
 
   //
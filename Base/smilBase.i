@@ -201,6 +201,7 @@ namespace std
 }
 
 TEMPLATE_WRAP_FUNC(computeBlobs);
+TEMPLATE_WRAP_FUNC(computeBlobTable);
 TEMPLATE_WRAP_FUNC_2T_CROSS(drawBlobs)
 
 %include "DMeasures.hpp"
@@ -260,6 +261,7 @@ TEMPLATE_WRAP_FUNC_2T_CROSS(blobsBarycenter);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsBoundBox);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsMoments);
 TEMPLATE_WRAP_FUNC_2T_CROSS(blobsEntropy);
+TEMPLATE_WRAP_CLASS(BlobFeatureExtractor, BlobFeatureExtractor);
 
 %include "DBlobOperations.hpp"
 TEMPLATE_WRAP_FUNC_2T_CROSS(areaThreshold);
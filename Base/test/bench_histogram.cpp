@@ -40,6 +40,13 @@ int main(void)
   randFill(im);
   BENCH_IMG(histogram, im);
   BENCH_IMG(histogramMap, im);
+  BENCH_IMG(measEntropy, im);
+  BENCH_IMG(otsuThresholdValues, im);
+
+  Image<UINT16> im16(1024, 1024);
+  randFill(im16);
+  BENCH_IMG(histogram, im16);
+  BENCH_IMG(measEntropy, im16);
 
   char *path = pathTestImage("barbara.png");
   Image<UINT8> imb(path);
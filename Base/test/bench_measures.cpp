@@ -30,6 +30,56 @@
 
 using namespace smil;
 
+// Labels of a grid of small squares
+Image<UINT32> gridLabels(size_t width, size_t height, size_t step)
+{
+  Image<UINT32> imLbl(width, height);
+  Image<UINT32>::lineType pixels = imLbl.getPixels();
+
+  for (size_t y = 0; y < height; y++)
+    for (size_t x = 0; x < width; x++)
+      pixels[x + y * width] = UINT32((y / step) * (width / step) + x / step + 1);
+  return imLbl;
+}
+
+void mapMeasures(const Image<UINT8> &imIn, const Image<UINT32> &imLbl)
+{
+  map<UINT32, Blob> blobs = computeBlobs(imLbl);
+  blobsArea(blobs);
+  blobsMeanVal(imIn, blobs);
+  blobsBarycenter(imIn, blobs);
+}
+
+void tableMeasures(const Image<UINT8> &imIn, const Image<UINT32> &imLbl)
+{
+  BlobTable blobs;
+  computeBlobTable(imLbl, blobs);
+  blobsArea(blobs);
+  blobsMeanVal(imIn, blobs);
+  blobsBarycenter(imIn, blobs);
+}
+
+// Area, barycenter, bounding box, moments, min/max/mean and entropy
+void separateFeatures(const Image<UINT8> &imIn, const BlobTable &blobs)
+{
+  blobsArea(blobs);
+  blobsBarycenter(imIn, blobs);
+  blobsBoundBox(imIn, blobs);
+  blobsMoments(imIn, blobs);
+  blobsMinVal(imIn, blobs);
+  blobsMaxVal(imIn, blobs);
+  blobsMeanVal(imIn, blobs);
+  blobsEntropy(imIn, blobs);
+}
+
+void fusedFeatures(const Image<UINT8> &imIn, const BlobTable &blobs)
+{
+  const char *names[] = {"area",   "barycenter", "boundBox", "moments",
+                         "minVal", "maxVal",     "meanVal",  "entropy"};
+  BlobFeatureExtractor<UINT8> fe(vector<string>(names, names + 8));
+  fe.compute(imIn, blobs);
+}
+
 int main(void)
 {
   UINT BENCH_NRUNS = 1E2;
@@ -43,4 +93,32 @@ int main(void)
   BENCH_IMG(area, im);
 
   BENCH_IMG(isBinary, im);
+
+  // Reductions with 1 to max threads
+  Image<UINT8> imBig(4096, 4096);
+  randFill(imBig);
+  UINT maxThreads = Core::getInstance()->getMaxNumberOfThreads();
+  BENCH_NRUNS     = 10;
+  for (UINT n = 1; n <= maxThreads; n *= 2) {
+    Core::getInstance()->setNumberOfThreads(n);
+    ostringstream str;
+    str << n << " threads";
+    BENCH_IMG_STR(vol, str.str(), imBig);
+    BENCH_IMG_STR(meanVal, str.str(), imBig);
+    BENCH_IMG_STR(rangeVal, str.str(), imBig);
+    BENCH_IMG_STR(measBarycenter, str.str(), imBig);
+    BENCH_IMG_STR(measMoments, str.str(), imBig);
+  }
+  Core::getInstance()->resetNumberOfThreads();
+
+  // 256x256 blobs
+  Image<UINT32> imLbl = gridLabels(1024, 1024, 4);
+  BENCH_NRUNS = 10;
+  BENCH_IMG(mapMeasures, im, imLbl);
+  BENCH_IMG(tableMeasures, im, imLbl);
+
+  BlobTable blobs;
+  computeBlobTable(imLbl, blobs);
+  BENCH_IMG(separateFeatures, im, blobs);
+  BENCH_IMG(fusedFeatures, im, blobs);
 }
@@ -0,0 +1,102 @@
+/*
+ * Smil
+ * Copyright (c) 2011-2015 Matthieu Faessel
+ *
+ * This file is part of Smil.
+ *
+ * Smil is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Smil is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Smil.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/include/DCore.h"
+#include "DImageArith.hpp"
+#include "DIntegralImage.hpp"
+
+using namespace smil;
+
+class Test_IntegralImage : public TestCase
+{
+  // Brute force sum of a box clipped to the image
+  template <class T>
+  double boxSum(const Image<T> &im, int x0, int y0, int z0, int x1, int y1,
+                int z1)
+  {
+    double s = 0;
+    for (int z = std::max(z0, 0); z <= std::min(z1, int(im.getDepth()) - 1);
+         z++)
+      for (int y = std::max(y0, 0);
+           y <= std::min(y1, int(im.getHeight()) - 1); y++)
+        for (int x = std::max(x0, 0);
+             x <= std::min(x1, int(im.getWidth()) - 1); x++)
+          s += im.getPixel(x, y, z);
+    return s;
+  }
+
+  virtual void run()
+  {
+    UINT8 vec1[20] = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10,
+                      11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+    Image<UINT8> im1(4, 5);
+    im1 << vec1;
+
+    IntegralImage<UINT8> integral(im1);
+    TEST_ASSERT(integral.getSum(0, 0, 3, 4) == 210);
+    TEST_ASSERT(integral.getSum(1, 1, 2, 2) == 6 + 7 + 10 + 11);
+    TEST_ASSERT(integral.getSum(-5, 3, 0, 10) == 13 + 17);
+    TEST_ASSERT(integral.getSum(4, 0, 6, 4) == 0);
+    TEST_ASSERT(integral.getCount(-1, -1, 0, 1, 1, 0) == 4);
+
+    IntegralImage<UINT8> squares(im1, true);
+    TEST_ASSERT(squares.getSum(0, 0, 1, 0) == 1 + 4);
+
+    Image<UINT16> im2(23, 17, 6);
+    randFill(im2);
+    IntegralImage<UINT16> integral3D(im2);
+
+    int boxes[][6] = {{0, 0, 0, 22, 16, 5},  {3, 2, 1, 7, 9, 4},
+                      {-2, -3, -1, 4, 2, 0}, {20, 15, 4, 30, 20, 9},
+                      {5, 5, 2, 5, 5, 2},    {10, -1, 3, 12, 18, 3}};
+    for (int b = 0; b < 6; b++) {
+      int *p = boxes[b];
+      TEST_ASSERT(double(integral3D.getSum(p[0], p[1], p[2], p[3], p[4],
+                                           p[5])) ==
+                  boxSum(im2, p[0], p[1], p[2], p[3], p[4], p[5]));
+    }
+
+    // Means of the 3x5 boxes around each pixel
+    Image<UINT16> im3(im2);
+    TEST_ASSERT(integral3D.boxMean(-1, 1, -2, 2, 0, 0, im3) == RES_OK);
+    bool same = true;
+    for (int z = 0; z < 6; z++)
+      for (int y = 0; y < 17; y++)
+        for (int x = 0; x < 23; x++) {
+          double n = (std::min(x + 1, 22) - std::max(x - 1, 0) + 1) *
+                     (std::min(y + 2, 16) - std::max(y - 2, 0) + 1);
+          double s = boxSum(im2, x - 1, y - 2, z, x + 1, y + 2, z);
+          if (im3.getPixel(x, y, z) != UINT16(s / n))
+            same = false;
+        }
+    TEST_ASSERT(same);
+  }
+};
+
+int main(void)
+{
+  TestSuite ts;
+
+  ADD_TEST(ts, Test_IntegralImage);
+
+  return ts.run();
+}
@@ -127,6 +127,158 @@ class Test_MeasureVolumes : public TestCase
   }
 };
 
+// Overlapping rectangles, cut into several blobs by the ones drawn over them
+void drawLabelRectangles(Image<UINT16> &imLbl)
+{
+  fill(imLbl, UINT16(0));
+  for (int i = 0; i < 40; i++)
+    drawRectangle(imLbl, (i * 13) % 60, (i * 7) % 44, 3 + i % 5, 2 + i % 4,
+                  UINT16(i * 3 + 1), 1);
+}
+
+class Test_BlobTable : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT16> imLbl(64, 48);
+    Image<UINT8> imIn(imLbl);
+
+    drawLabelRectangles(imLbl);
+    randFill(imIn);
+
+    map<UINT16, Blob> blobs = computeBlobs(imLbl);
+    BlobTable table;
+    TEST_ASSERT(computeBlobTable(imLbl, table) == RES_OK);
+    TEST_ASSERT(table.getBlobNbr() == 118);
+
+    typedef map<UINT16, double> doubleMap;
+    typedef map<UINT16, UINT8> valMap;
+    typedef map<UINT16, Vector_double> vectMap;
+    typedef map<UINT16, vector<size_t>> sizeVectMap;
+
+    TEST_ASSERT(blobsMap<UINT16>(table, blobsArea(table)) == blobsArea(blobs));
+    TEST_ASSERT(blobsMap<UINT16>(table, blobsVolume(imIn, table)) ==
+                blobsVolume(imIn, blobs));
+    valMap minVals = blobsMap<UINT16>(table, blobsMinVal(imIn, table));
+    TEST_ASSERT(minVals == blobsMinVal(imIn, blobs));
+    valMap medianVals = blobsMap<UINT16>(table, blobsMedianVal(imIn, table));
+    TEST_ASSERT(medianVals == blobsMedianVal(imIn, blobs));
+    vectMap meanVals = blobsMap<UINT16>(table, blobsMeanVal(imIn, table));
+    TEST_ASSERT(meanVals == blobsMeanVal(imIn, blobs));
+    vectMap barycenters = blobsMap<UINT16>(table, blobsBarycenter(imIn, table));
+    TEST_ASSERT(barycenters == blobsBarycenter(imIn, blobs));
+    sizeVectMap boxes = blobsMap<UINT16>(table, blobsBoundBox(imIn, table));
+    TEST_ASSERT(boxes == blobsBoundBox(imIn, blobs));
+    vectMap moments = blobsMap<UINT16>(table, blobsMoments(imIn, table, true));
+    TEST_ASSERT(moments == blobsMoments(imIn, blobs, true));
+    doubleMap entropies = blobsMap<UINT16>(table, blobsEntropy(imIn, table));
+    TEST_ASSERT(entropies == blobsEntropy(imIn, blobs));
+
+    // Adapters
+    map<UINT16, Blob> blobs2 = table.toBlobs<UINT16>();
+    TEST_ASSERT(blobsArea(blobs2) == blobsArea(blobs));
+    BlobTable table2;
+    table2.fromBlobs(blobs);
+    TEST_ASSERT(table2.sequences.size() == table.sequences.size());
+    TEST_ASSERT(table2.blobOffsets == table.blobOffsets);
+    TEST_ASSERT(table2.areas == table.areas);
+  }
+};
+
+class Test_BlobFeatureExtractor : public TestCase
+{
+  // Same values, up to the summation order
+  bool sameValues(const Vector_double &col, size_t b, double val)
+  {
+    return fabs(col[b] - val) <= 1e-9 * max(1., fabs(val));
+  }
+
+  template <class T> void testImage(const Image<T> &imIn, const Image<UINT16> &imLbl)
+  {
+    map<UINT16, Blob> blobs = computeBlobs(imLbl);
+    BlobTable table;
+    computeBlobTable(imLbl, table);
+
+    vector<string> names;
+    names.push_back("area");
+    names.push_back("volume");
+    names.push_back("minVal");
+    names.push_back("maxVal");
+    names.push_back("meanVal");
+    names.push_back("barycenter");
+    names.push_back("boundBox");
+    names.push_back("moments");
+    names.push_back("entropy");
+    BlobFeatureExtractor<T> fe(names);
+    TEST_ASSERT(fe.compute(imIn, table) == RES_OK);
+    TEST_ASSERT(fe.getBlobNbr() == table.getBlobNbr());
+
+    size_t nMoments = imIn.getDimension() == 3 ? 10 : 6;
+    TEST_ASSERT(fe.getColumnNames().size() == (nMoments == 10 ? 26 : 19));
+
+    map<UINT16, double> areas = blobsArea(blobs);
+    map<UINT16, double> vols = blobsVolume(imIn, blobs);
+    map<UINT16, T> minVals = blobsMinVal(imIn, blobs);
+    map<UINT16, T> maxVals = blobsMaxVal(imIn, blobs);
+    map<UINT16, Vector_double> meanVals = blobsMeanVal(imIn, blobs);
+    map<UINT16, Vector_double> barycenters = blobsBarycenter(imIn, blobs);
+    map<UINT16, vector<size_t>> boxes = blobsBoundBox(imIn, blobs);
+    map<UINT16, Vector_double> moments = blobsMoments(imIn, blobs);
+    map<UINT16, double> entropies = blobsEntropy(imIn, blobs);
+
+    vector<string> colNames = fe.getColumnNames();
+    for (map<UINT16, Blob>::iterator it = blobs.begin(); it != blobs.end();
+         it++) {
+      UINT16 b = it->first;
+      TEST_ASSERT(fe.getColumn("area")[b] == areas[b]);
+      TEST_ASSERT(fe.getColumn("volume")[b] == vols[b]);
+      TEST_ASSERT(fe.getColumn("minVal")[b] == double(minVals[b]));
+      TEST_ASSERT(fe.getColumn("maxVal")[b] == double(maxVals[b]));
+      TEST_ASSERT(sameValues(fe.getColumn("meanVal"), b, meanVals[b][0]));
+      TEST_ASSERT(sameValues(fe.getColumn("stdDev"), b, meanVals[b][1]));
+      TEST_ASSERT(sameValues(fe.getColumn("barycenterX"), b, barycenters[b][0]));
+      TEST_ASSERT(sameValues(fe.getColumn("barycenterY"), b, barycenters[b][1]));
+      // Bounding box, then moments, then entropy are the last columns
+      size_t bboxSize = boxes[b].size();
+      size_t first = colNames.size() - 1 - nMoments - bboxSize;
+      for (size_t i = 0; i < bboxSize; i++)
+        TEST_ASSERT(fe.getColumn(colNames[first + i])[b] == double(boxes[b][i]));
+      for (size_t i = 0; i < nMoments; i++)
+        TEST_ASSERT(sameValues(fe.getColumn(colNames[first + bboxSize + i]), b,
+                               moments[b][i]));
+      TEST_ASSERT(sameValues(fe.getColumn("entropy"), b, entropies[b]));
+    }
+  }
+
+  virtual void run()
+  {
+    Image<UINT16> imLbl(64, 48);
+    drawLabelRectangles(imLbl);
+
+    Image<UINT8> im8(imLbl);
+    randFill(im8);
+    testImage(im8, imLbl);
+    // Entropy without a dense histogram
+    Image<UINT32> im32(imLbl);
+    Image<UINT32>::lineType pixels = im32.getPixels();
+    for (size_t i = 0; i < im32.getPixelCount(); i++)
+      pixels[i] = UINT32((i * 2654435761UL) % 100000);
+    testImage(im32, imLbl);
+
+    Image<UINT16> imLbl3D(20, 16, 12);
+    fill(imLbl3D, UINT16(0));
+    for (int i = 0; i < 12; i++)
+      drawBox(imLbl3D, i % 15, (i * 5) % 12, i, 5, 4, 1 + i % 3, UINT16(i + 1), true);
+    Image<UINT8> im3D(imLbl3D);
+    randFill(im3D);
+    testImage(im3D, imLbl3D);
+
+    // Unknown feature
+    BlobFeatureExtractor<UINT8> fe;
+    TEST_ASSERT(fe.addFeature("perimeter") == RES_ERR);
+  }
+};
+
 int main()
 {
   TestSuite ts;
@@ -135,6 +287,8 @@ int main()
   ADD_TEST(ts, Test_Areas);
   ADD_TEST(ts, Test_Barycenters);
   ADD_TEST(ts, Test_MeasureVolumes);
+  ADD_TEST(ts, Test_BlobTable);
+  ADD_TEST(ts, Test_BlobFeatureExtractor);
 
   return ts.run();
 }
@@ -220,6 +220,205 @@ class Test_MinMax : public TestCase
   }
 };
 
+// Same reduction as processImage() on several threads
+template <class T, class funcT>
+typename funcT::retType measureByParts(funcT &func, const Image<T> &imIn,
+                                       size_t partNbr, bool onlyNonZero)
+{
+  func.initialize(imIn);
+  for (size_t p = 0; p < partNbr; p++) {
+    typename funcT::parentClass *part = func.clone();
+    part->initialize(imIn);
+    part->processPart(imIn, p, partNbr, onlyNonZero);
+    func.combine(*part);
+    delete part;
+  }
+  func.finalize(imIn);
+  return func.retVal;
+}
+
+template <class T, class funcT>
+bool sameByParts(const Image<T> &imIn, size_t partNbr, bool onlyNonZero)
+{
+  funcT func, partsFunc;
+  return func(imIn, onlyNonZero) ==
+         measureByParts(partsFunc, imIn, partNbr, onlyNonZero);
+}
+
+class Test_MeasureParts : public TestCase
+{
+  template <class T> void testImage(const Image<T> &im)
+  {
+    size_t partNbrs[] = {1, 2, 3, 7};
+    for (int i = 0; i < 4; i++) {
+      for (int nonZero = 0; nonZero < 2; nonZero++) {
+        size_t n = partNbrs[i];
+        bool nz  = nonZero != 0;
+        TEST_ASSERT((sameByParts<T, measAreaFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measVolFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMeanValFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMinValFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMaxValFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMinMaxValFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, valueListFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMedianValFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measBarycenterFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measBoundBoxFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measMomentsFunc<T>>(im, n, nz)));
+        TEST_ASSERT((sameByParts<T, measEntropyFunc<T>>(im, n, nz)));
+
+        // First position of the extrema
+        measMaxValPosFunc<T> func, partsFunc;
+        func(im, nz);
+        measureByParts(partsFunc, im, n, nz);
+        TEST_ASSERT(func.retVal == partsFunc.retVal && func.pt == partsFunc.pt);
+      }
+    }
+  }
+
+  virtual void run()
+  {
+    Image<UINT8> im8(37, 23, 3);
+    Image<UINT16> im16(im8);
+    UINT8 *pixels8   = im8.getPixels();
+    UINT16 *pixels16 = im16.getPixels();
+    for (size_t i = 0; i < im8.getPixelCount(); i++) {
+      pixels8[i]  = UINT8((i * 7919) % 13 < 4 ? 0 : (i * 31) % 200);
+      pixels16[i] = UINT16((i * 7919) % 13 < 4 ? 0 : (i * 2741) % 60000);
+    }
+    testImage(im8);
+    testImage(im16);
+  }
+};
+
+// Histogram counted pixel by pixel in a map
+template <class T>
+map<T, size_t> naiveHistogram(const Image<T> &im, const Image<T> *imMask)
+{
+  map<T, size_t> h;
+  typename Image<T>::lineType pixels = im.getPixels();
+  for (size_t i = 0; i < im.getPixelCount(); i++)
+    if (!imMask || imMask->getPixels()[i] != 0)
+      h[pixels[i]]++;
+  return h;
+}
+
+template <class T> double naiveEntropy(const map<T, size_t> &h)
+{
+  double sumP = 0., sumN = 0.;
+  typename map<T, size_t>::const_iterator it;
+  for (it = h.begin(); it != h.end(); it++) {
+    sumN += it->second;
+    sumP += it->second * log2(it->second);
+  }
+  return sumN > 0 ? log2(sumN) - sumP / sumN : 0.;
+}
+
+class Test_DenseHistogram : public TestCase
+{
+  template <class T>
+  bool sameHistogram(const Image<T> &im, const Image<T> *imMask, bool dense)
+  {
+    DenseHistogram<T> hist;
+    if (imMask)
+      hist.compute(im, *imMask);
+    else
+      hist.compute(im);
+    if (hist.isDense() != dense)
+      return false;
+
+    map<T, size_t> truth = naiveHistogram(im, imMask);
+    size_t nPix          = 0;
+    typename map<T, size_t>::iterator it;
+    for (it = truth.begin(); it != truth.end(); it++) {
+      if (hist.getCount(it->first) != it->second)
+        return false;
+      nPix += it->second;
+    }
+    if (hist.getPixelCount() != nPix)
+      return false;
+
+    T minVal, maxVal;
+    if (!hist.getRange(minVal, maxVal))
+      return truth.empty();
+    return minVal == truth.begin()->first && maxVal == truth.rbegin()->first;
+  }
+
+  template <class T> void testImage(const Image<T> &im, bool dense)
+  {
+    Image<T> imMask(im);
+    typename Image<T>::lineType maskPix = imMask.getPixels();
+    for (size_t i = 0; i < imMask.getPixelCount(); i++)
+      maskPix[i] = T((i * 13) % 7 < 3 ? 0 : 1);
+
+    TEST_ASSERT(sameHistogram(im, (const Image<T> *) NULL, dense));
+    TEST_ASSERT(sameHistogram(im, &imMask, dense));
+
+    // Map histogram (null counts are only listed by dense histograms)
+    map<T, UINT> h = histogram(im);
+    map<T, size_t> truth = naiveHistogram(im, (const Image<T> *) NULL);
+    vector<T> rVals = rangeVal(im);
+    TEST_ASSERT(h.begin()->first == rVals[0] && h.rbegin()->first == rVals[1]);
+    TEST_ASSERT(h.size() ==
+                (dense ? size_t(rVals[1] - rVals[0]) + 1 : truth.size()));
+    typename map<T, size_t>::iterator it;
+    for (it = truth.begin(); it != truth.end(); it++)
+      TEST_ASSERT(h[it->first] == it->second);
+
+    // Binned histogram
+    map<T, UINT> binned = histogramMap(im, T(4));
+    map<T, size_t> binTruth;
+    for (it = truth.begin(); it != truth.end(); it++)
+      binTruth[it->first / 4] += it->second;
+    TEST_ASSERT(binned.size() == binTruth.size());
+    for (it = binTruth.begin(); it != binTruth.end(); it++)
+      TEST_ASSERT(binned[it->first] == it->second);
+
+    // Entropy of the whole image, of a mask and of a blob
+    double entropy = measEntropy(im);
+    TEST_ASSERT(fabs(entropy - naiveEntropy(truth)) < 1e-9);
+    TEST_ASSERT(fabs(measEntropy(im, imMask) -
+                     naiveEntropy(naiveHistogram(im, &imMask))) < 1e-9);
+    Blob blob;
+    blob.sequences.push_back(PixelSequence(0, im.getPixelCount()));
+    measEntropyFunc<T> func;
+    TEST_ASSERT(fabs(func(im, blob) - entropy) < 1e-9);
+
+    // Clones count over the range of values of the first histogram
+    measEntropyFunc<T> partsFunc;
+    TEST_ASSERT(fabs(measureByParts(partsFunc, im, 3, false) - entropy) < 1e-9);
+  }
+
+  virtual void run()
+  {
+    Image<UINT8> im8(311, 257);
+    Image<UINT16> im16(im8);
+    Image<UINT32> im32(im8);
+    Image<UINT32> im32Wide(im8);
+    for (size_t i = 0; i < im8.getPixelCount(); i++) {
+      im8.getPixels()[i]      = UINT8((i * 31) % 200 + i % 3);
+      im16.getPixels()[i]     = UINT16((i * 2741) % 60000);
+      im32.getPixels()[i]     = UINT32(100000 + (i * 97) % 5000);
+      im32Wide.getPixels()[i] = UINT32((i * 2654435761UL) % 4000000000UL);
+    }
+    testImage(im8, true);
+    testImage(im16, true);
+    testImage(im32, true);
+    testImage(im32Wide, false);
+
+    // Array histogram over the whole type range
+    vector<size_t> h(ImDtTypes<UINT16>::cardinal());
+    histogram(im16, h.data());
+    map<UINT16, size_t> truth = naiveHistogram(im16, (const Image<UINT16> *) NULL);
+    size_t nPix               = 0;
+    for (size_t i = 0; i < h.size(); i++) {
+      TEST_ASSERT(h[i] == (truth.count(UINT16(i)) ? truth[UINT16(i)] : 0));
+      nPix += h[i];
+    }
+    TEST_ASSERT(nPix == im16.getPixelCount());
+  }
+};
+
 int main(void)
 {
   TestSuite ts;
@@ -232,6 +431,8 @@ int main(void)
   ADD_TEST(ts, Test_MeasCovariance);
   ADD_TEST(ts, Test_MeasMoments);
   ADD_TEST(ts, Test_MinMax);
+  ADD_TEST(ts, Test_MeasureParts);
+  ADD_TEST(ts, Test_DenseHistogram);
 
   return ts.run();
 }
@@ -47,6 +47,7 @@
 #include "DTest.h"
 #include "DBench.h"
 #include "DImage.h"
+#include "DImageArena.h"
 
 #include "private/DMemory.hpp"
 #include "private/DGraph.hpp"
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DIMAGE_ARENA_H
+#define _DIMAGE_ARENA_H
+
+#include <map>
+#include <typeinfo>
+#include <vector>
+
+#include "DCommon.h"
+
+namespace smil
+{
+  /**
+   * @addtogroup Core
+   * @{
+   */
+
+  /**
+   * Usage statistics of an ImageArena
+   */
+  struct ImageArenaStats {
+    //! Allocations served with recycled memory
+    size_t hits;
+    //! Allocations which went to the system allocator
+    size_t misses;
+    //! Released images which didn't fit in the arena
+    size_t dropped;
+    //! Bytes currently kept for reuse
+    size_t cachedBytes;
+  };
+
+  /**
+   * Scoped recycling allocator for images
+   *
+   * While an arena is alive, the images allocated and deallocated @b by its
+   * thread go through it: the pixel buffer and the line and slice tables of a
+   * deallocated image are kept, and given back as is to the next image of the
+   * same type and size, without calling the system allocator nor touching
+   * new pages. All the memory kept is freed with the arena.
+   *
+   * Arenas are opt-in, thread-local and may be nested (the innermost one is
+   * used). Images may outlive the arena which allocated them: their memory is
+   * then freed the usual way.
+   *
+   * @b Example:
+   * @code{.cpp}
+   * {
+   *   ImageArena arena;
+   *   for (size_t i = 0; i < frames.size(); i++)
+   *     gradient(frames[i], out[i]); // temporaries are recycled
+   * }
+   * @endcode
+   */
+  class ImageArena
+  {
+  public:
+    /**
+     * @param[in] maxBytes : maximum amount of memory kept for reuse (no
+     * limit if 0)
+     */
+    ImageArena(size_t maxBytes = 0);
+    ~ImageArena();
+
+    //! Innermost arena of the calling thread (NULL if none)
+    static ImageArena *getCurrent();
+
+    //! Free the memory kept for reuse
+    void clear();
+
+    ImageArenaStats getStats() const;
+
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const
+    {
+      return maxBytes;
+    }
+
+    /** @cond */
+    // Memory of an image: pixels, lines and slices tables, and the function
+    // freeing them
+    struct Block {
+      void *pixels;
+      void *lines;
+      void *slices;
+      size_t bytes;
+      void (*free)(const Block &block);
+    };
+
+    // Recycled memory for an image of the given type and size
+    bool acquire(const std::type_info &type, size_t width, size_t height,
+                 size_t depth, Block &block);
+    // Keep the memory of a deallocated image (false if it doesn't fit in
+    // the arena, and should be freed by the caller)
+    bool release(const std::type_info &type, size_t width, size_t height,
+                 size_t depth, const Block &block);
+    /** @endcond */
+
+  protected:
+    struct Key {
+      const std::type_info *type;
+      size_t width, height, depth;
+
+      bool operator<(const Key &rhs) const;
+    };
+
+    std::map<Key, std::vector<Block>> blocks;
+
+    size_t maxBytes;
+    size_t cachedBytes;
+    size_t hits, misses, dropped;
+
+    ImageArena *previous;
+
+  private:
+    ImageArena(const ImageArena &);
+    ImageArena &operator=(const ImageArena &);
+  };
+
+  /** @} */
+
+} // namespace smil
+
+#endif // _DIMAGE_ARENA_H
@@ -30,54 +30,107 @@
 #ifndef _DBUFFER_POOL_HPP
 #define _DBUFFER_POOL_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <limits>
-#include <stack>
+#include <mutex>
 
 #include "Core/include/private/DMemory.hpp"
 #include "Core/include/private/DTypes.hpp"
 #include "Core/include/DErrors.h"
 
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
 namespace smil
 {
+    /**
+     * Usage statistics of a BufferPool
+     */
+    struct BufferPoolStats
+    {
+        //! Requests served with a recycled buffer
+        size_t hits;
+        //! Requests which allocated a new buffer
+        size_t misses;
+        //! Requests which had to wait for another thread to release a buffer
+        size_t waits;
+        //! Number of buffers currently allocated
+        size_t buffers;
+        //! Maximum number of buffers allocated at the same time
+        size_t peakBuffers;
+    };
     
+    /**
+     * Pool of line buffers shared by the threads of OpenMP loops
+     *
+     * - each thread first reuses the last buffers it released, which it keeps
+     *   in the cache of its OpenMP thread number (claimed with an uncontended
+     *   atomic flag, and the buffers stay in the memory of its NUMA node).
+     *   Threads finding their cache claimed by another thread, such as
+     *   threads not started by OpenMP which all have the number 0, use the
+     *   shared list instead,
+     * - the other released buffers go to a lock-free shared list,
+     * - new buffers are allocated and first touched by the thread which
+     *   requests them,
+     * - once the maximum number of buffers is reached, getBuffer() sleeps
+     *   until another thread releases one. Per-thread caches are then
+     *   disabled, so that waiting threads see all the released buffers.
+     *
+     * clear(), initialize() and releaseAllBuffers() must be called outside of
+     * parallel regions, when no buffer is in use.
+     */
     template <class T>
     class BufferPool
     {
     public:
+      typedef typename ImDtTypes<T>::lineType bufferType;
+      
       BufferPool(size_t bufSize=0)
         : bufferSize(bufSize),
+          maxNumberOfBuffers(std::numeric_limits<size_t>::max()),
+          freeHead(NO_BUFFER),
           numberOfBuffers(0),
-          maxNumberOfBuffers(std::numeric_limits<size_t>::max())
-      {}
+          waiters(0)
+      {
+          for (size_t i=0;i<MAX_BLOCKS;i++)
+            blocks[i].store(NULL, std::memory_order_relaxed);
+          
+        #ifdef USE_OPEN_MP
+          threadCaches.resize(std::max(omp_get_num_procs(), omp_get_max_threads()));
+        #else // USE_OPEN_MP
+          threadCaches.resize(1);
+        #endif // USE_OPEN_MP
+          resetStats();
+      }
       ~BufferPool()
       {
-        for (typename vector<bufferType>::iterator it = buffers.begin();
-             it != buffers.end(); it++) {
-          ImDtTypes<T>::deleteLine(*it);
-        }
+          clear();
       }
 
-      typedef typename ImDtTypes<T>::lineType bufferType;
-      
       RES_T initialize(size_t bufSize, SMIL_UNUSED size_t nbr=0)
       {
-          if (buffers.size()!=0)
-            clear();
+          clear();
           this->bufferSize = bufSize;
           return RES_OK;
       }
+      //! Free all the buffers
       void clear()
       {
-          #ifdef USE_OPEN_MP
-            #pragma omp critical
-          #endif // USE_OPEN_MP
+          UINT32 nbr = numberOfBuffers.load();
+          for (UINT32 i=0;i<nbr;i++)
+            aligned_free(rawBuffer(node(i).buf));
+          for (size_t i=0;i<MAX_BLOCKS;i++)
           {
-              while (!availableBuffers.empty())
-              {
-                  ImDtTypes<T>::deleteLine(availableBuffers.top());
-                  availableBuffers.pop();
-              }
+              delete[] blocks[i].load();
+              blocks[i].store(NULL);
           }
+          for (size_t i=0;i<threadCaches.size();i++)
+            threadCaches[i].count = 0;
+          freeHead.store(NO_BUFFER);
+          numberOfBuffers.store(0);
       }
       void setMaxNumberOfBuffers(size_t nbr)
       {
@@ -89,29 +142,40 @@ namespace smil
       }
       bufferType getBuffer()
       {
-        bufferType buf;
-        
-        #ifdef USE_OPEN_MP
-          #pragma omp critical
-        #endif // USE_OPEN_MP
-        {
-            if (availableBuffers.empty())
-            {
-                if (!createBuffer())
-                  while (availableBuffers.empty()); // wait
-            }
-            
-            buf = availableBuffers.top();
-            availableBuffers.pop();
+          CacheGuard guard(localCache());
+          ThreadCache *cache = guard.cache;
+          UINT32 id;
+          
+          if (cache && cache->count>0)
+          {
+              cache->hits++;
+              return node(cache->bufs[--cache->count]).buf;
+          }
+          if (pop(id))
+          {
+              countStat(cache, &ThreadCache::hits, sharedHits);
+              return node(id).buf;
+          }
+          if (createBuffer(id))
+          {
+              countStat(cache, &ThreadCache::misses, sharedMisses);
+              return node(id).buf;
+          }
           
-        }
-        return buf;
+          // All the buffers are in use: wait for a release
+          countStat(cache, &ThreadCache::waits, sharedWaits);
+          std::unique_lock<std::mutex> lock(waitMutex);
+          waiters++;
+          while (!pop(id))
+            released.wait(lock);
+          waiters--;
+          return node(id).buf;
       }
       vector<bufferType> getBuffers(size_t nbr)
       {
         vector<bufferType> buffVect;
         
-        for (int i=0;i<nbr;i++)
+        for (size_t i=0;i<nbr;i++)
           buffVect.push_back(this->getBuffer());
 
         return buffVect;
@@ -119,42 +183,227 @@ namespace smil
       
       void releaseBuffer(bufferType &buf)
       {
-          availableBuffers.push(buf);
+          if (buf==NULL)
+            return;
+          
+          UINT32 id = *(UINT32*)rawBuffer(buf);
+          CacheGuard guard(localCache());
+          ThreadCache *cache = guard.cache;
+          
+          if (cache && cache->count<CACHE_SIZE &&
+              maxNumberOfBuffers==std::numeric_limits<size_t>::max())
+            cache->bufs[cache->count++] = id;
+          else
+          {
+              push(id);
+              if (waiters.load()>0)
+              {
+                  std::lock_guard<std::mutex> lock(waitMutex);
+                  released.notify_one();
+              }
+          }
           buf = NULL;
       }
       void releaseBuffers(vector<bufferType> &bufs)
       {
-          for (int i=0;i<bufs.size();i++)
-            availableBuffers.push(bufs[i]);
+          for (size_t i=0;i<bufs.size();i++)
+            releaseBuffer(bufs[i]);
           bufs.clear();
       }
+      //! Make all the buffers available again
       void releaseAllBuffers()
       {
-          while (!availableBuffers.empty())
-            availableBuffers.pop();
-          for (typename vector<bufferType>::iterator it=buffers.begin();it!=buffers.end();it++)
-            availableBuffers.push(*it);
+          UINT32 nbr = numberOfBuffers.load();
+          for (size_t i=0;i<threadCaches.size();i++)
+            threadCaches[i].count = 0;
+          for (UINT32 i=0;i<nbr;i++)
+            node(i).next.store(i+1<nbr ? i+1 : UINT32(NO_BUFFER));
+          freeHead.store(nbr>0 ? 0 : NO_BUFFER);
       }
+      
+      BufferPoolStats getStats() const
+      {
+          BufferPoolStats stats;
+          stats.hits = sharedHits.load();
+          stats.misses = sharedMisses.load();
+          stats.waits = sharedWaits.load();
+          for (size_t i=0;i<threadCaches.size();i++)
+          {
+              stats.hits += threadCaches[i].hits;
+              stats.misses += threadCaches[i].misses;
+              stats.waits += threadCaches[i].waits;
+          }
+          stats.buffers = numberOfBuffers.load();
+          stats.peakBuffers = peakBuffers.load();
+          return stats;
+      }
+      void resetStats()
+      {
+          for (size_t i=0;i<threadCaches.size();i++)
+            threadCaches[i].hits = threadCaches[i].misses = threadCaches[i].waits = 0;
+          sharedHits.store(0);
+          sharedMisses.store(0);
+          sharedWaits.store(0);
+          peakBuffers.store(numberOfBuffers.load());
+      }
+      
     protected:
-      bool createBuffer()
-      {
-          if (buffers.size()>=maxNumberOfBuffers)
-            return false;
-            
-          bufferType buf = ImDtTypes<T>::createLine(this->bufferSize);
-          buffers.push_back(buf);
-          availableBuffers.push(buf);
-        
+      static const UINT32 NO_BUFFER = 0xFFFFFFFF;
+      // Buffers are preceded by a header holding their index (a multiple of
+      // the SIMD alignment, and of the cache line size)
+      static const size_t HEADER_SIZE = 64;
+      static const size_t BLOCK_SIZE = 256;
+      static const size_t MAX_BLOCKS = 1024;
+      static const size_t CACHE_SIZE = 4;
+      
+      struct Node
+      {
+          bufferType buf;
+          std::atomic<UINT32> next;
+      };
+      
+      // Only accessed by the thread which claimed it (padded against false
+      // sharing)
+      struct ThreadCache
+      {
+          UINT32 bufs[CACHE_SIZE];
+          size_t count;
+          size_t hits, misses, waits;
+          std::atomic<bool> claimed;
+          char padding[64];
+          
+          ThreadCache() : count(0), hits(0), misses(0), waits(0), claimed(false) {}
+          // Only used to size the vector of caches
+          ThreadCache(const ThreadCache &)
+            : count(0), hits(0), misses(0), waits(0), claimed(false) {}
+      };
+      
+      // Releases the cache claimed by localCache()
+      struct CacheGuard
+      {
+          ThreadCache *cache;
+          
+          CacheGuard(ThreadCache *c) : cache(c) {}
+          ~CacheGuard()
+          {
+              if (cache)
+                cache->claimed.store(false, std::memory_order_release);
+          }
+      };
+      
+      // Cache of the calling thread, or NULL if another thread holds it.
+      // Thread numbers are only unique among the threads of one outermost
+      // parallel region: several parallel regions started by different
+      // threads, or threads not started by OpenMP, share the same numbers.
+      inline ThreadCache *localCache()
+      {
+          size_t tid = 0;
+        #ifdef USE_OPEN_MP
+          if (omp_get_level()>1)
+            return NULL;
+          tid = omp_get_thread_num();
+          if (tid>=threadCaches.size())
+            return NULL;
+        #endif // USE_OPEN_MP
+          ThreadCache *cache = &threadCaches[tid];
+          if (cache->claimed.exchange(true, std::memory_order_acquire))
+            return NULL;
+          return cache;
+      }
+      inline void countStat(ThreadCache *cache, size_t ThreadCache::*counter,
+                            std::atomic<size_t> &sharedCounter)
+      {
+          if (cache)
+            (cache->*counter)++;
+          else
+            sharedCounter.fetch_add(1, std::memory_order_relaxed);
+      }
+      
+      inline Node &node(UINT32 id) const
+      {
+          return blocks[id/BLOCK_SIZE].load(std::memory_order_acquire)[id%BLOCK_SIZE];
+      }
+      static inline void *rawBuffer(bufferType buf)
+      {
+          return (char*)buf - HEADER_SIZE;
+      }
+      
+      // Treiber stack. The head holds the index of the first free buffer and
+      // a counter, incremented at each operation against the ABA problem.
+      inline bool pop(UINT32 &id)
+      {
+          UINT64 head = freeHead.load(std::memory_order_acquire);
+          while (UINT32(head)!=NO_BUFFER)
+          {
+              UINT32 next = node(UINT32(head)).next.load(std::memory_order_relaxed);
+              UINT64 newHead = (((head>>32)+1)<<32) | next;
+              if (freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire))
+              {
+                  id = UINT32(head);
+                  return true;
+              }
+          }
+          return false;
+      }
+      inline void push(UINT32 id)
+      {
+          UINT64 head = freeHead.load(std::memory_order_relaxed);
+          UINT64 newHead;
+          do
+          {
+              node(id).next.store(UINT32(head), std::memory_order_relaxed);
+              newHead = (((head>>32)+1)<<32) | id;
+          } while (!freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+      }
+      
+      // Allocated by the calling thread, and first touched by it so that its
+      // pages are mapped on the thread's NUMA node
+      bool createBuffer(UINT32 &id)
+      {
+          size_t maxNbr = std::min(maxNumberOfBuffers, BLOCK_SIZE*MAX_BLOCKS);
+          UINT32 nbr = numberOfBuffers.load();
+          do
+          {
+              if (nbr>=maxNbr)
+                return false;
+          } while (!numberOfBuffers.compare_exchange_weak(nbr, nbr+1));
+          id = nbr;
+          
+          size_t peak = peakBuffers.load();
+          while (peak<=nbr && !peakBuffers.compare_exchange_weak(peak, nbr+1));
+          
+          if (blocks[id/BLOCK_SIZE].load()==NULL)
+          {
+              std::lock_guard<std::mutex> lock(allocMutex);
+              if (blocks[id/BLOCK_SIZE].load()==NULL)
+                blocks[id/BLOCK_SIZE].store(new Node[BLOCK_SIZE]);
+          }
+          
+          size_t bytes = (SIMD_VEC_SIZE*(bufferSize/SIMD_VEC_SIZE+1))*sizeof(T);
+          char *raw = (char*)aligned_malloc(HEADER_SIZE + bytes, SIMD_VEC_SIZE);
+          memset(raw + HEADER_SIZE, 0, bytes);
+          *(UINT32*)raw = id;
+          node(id).buf = (bufferType)(raw + HEADER_SIZE);
           return true;
       }
-      stack<bufferType> availableBuffers;
-      vector<bufferType> buffers;
+      
       size_t bufferSize;
-      size_t numberOfBuffers;
       size_t maxNumberOfBuffers;
+      
+      std::atomic<Node*> blocks[MAX_BLOCKS];
+      std::atomic<UINT64> freeHead;
+      std::atomic<UINT32> numberOfBuffers;
+      std::mutex allocMutex;
+      
+      std::mutex waitMutex;
+      std::condition_variable released;
+      std::atomic<int> waiters;
+      
+      vector<ThreadCache> threadCaches;
+      std::atomic<size_t> sharedHits, sharedMisses, sharedWaits;
+      std::atomic<size_t> peakBuffers;
     };
 
 } // namespace smil
 
 #endif // _DBUFFER_POOL_HPP
-
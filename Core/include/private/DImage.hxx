@@ -34,8 +34,10 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <typeinfo>
 
 #include "Core/include/DCoreEvents.h"
+#include "Core/include/DImageArena.h"
 #include "Base/include/private/DMeasures.hpp"
 #include "Base/include/private/DImageArith.hpp"
 #include "IO/include/private/DImageIO.hxx"
@@ -312,11 +314,32 @@ namespace smil
     return RES_OK;
   }
 
+  template <class T> void freeImageArenaBlock(const ImageArena::Block &block)
+  {
+    delete[](typename Image<T>::volType) block.slices;
+    delete[](typename Image<T>::sliceType) block.lines;
+    deleteAlignedBuffer<T>((typename Image<T>::lineType) block.pixels);
+  }
+
   template <class T> RES_T Image<T>::allocate()
   {
     if (this->allocated)
       return RES_ERR_BAD_ALLOCATION;
 
+    // Memory recycled by an arena already holds the tables for this size
+    ImageArena *arena = ImageArena::getCurrent();
+    ImageArena::Block block;
+    if (arena && arena->acquire(typeid(T), width, height, depth, block)) {
+      this->pixels = (lineType) block.pixels;
+      this->lines  = (sliceType) block.lines;
+      this->slices = (volType) block.slices;
+
+      this->allocated     = true;
+      this->allocatedSize = this->pixelCount * sizeof(T);
+
+      return RES_OK;
+    }
+
     this->pixels = createAlignedBuffer<T>(pixelCount);
     //     pixels = new pixelType[pixelCount];
 
@@ -361,6 +384,25 @@ namespace smil
     if (!this->allocated)
       return RES_OK;
 
+    ImageArena *arena = ImageArena::getCurrent();
+    if (arena && this->pixels && this->lines && this->slices) {
+      ImageArena::Block block = {
+          this->pixels, this->lines, this->slices,
+          pixelCount * sizeof(T) + lineCount * sizeof(lineType) +
+              sliceCount * sizeof(sliceType),
+          &freeImageArenaBlock<T>};
+      if (arena->release(typeid(T), width, height, depth, block)) {
+        this->slices = NULL;
+        this->lines  = NULL;
+        this->pixels = NULL;
+
+        this->allocated     = false;
+        this->allocatedSize = 0;
+
+        return RES_OK;
+      }
+    }
+
     if (this->slices)
       delete[] this->slices;
     if (this->lines)
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Core/include/DImageArena.h"
+
+using namespace smil;
+
+// Innermost arena of each thread
+static thread_local ImageArena *currentArena = NULL;
+
+bool ImageArena::Key::operator<(const Key &rhs) const
+{
+  if (*type != *rhs.type)
+    return type->before(*rhs.type);
+  if (width != rhs.width)
+    return width < rhs.width;
+  if (height != rhs.height)
+    return height < rhs.height;
+  return depth < rhs.depth;
+}
+
+ImageArena::ImageArena(size_t maxBytes)
+    : maxBytes(maxBytes), cachedBytes(0), hits(0), misses(0), dropped(0)
+{
+  previous     = currentArena;
+  currentArena = this;
+}
+
+ImageArena::~ImageArena()
+{
+  clear();
+  // Arenas are scoped, so this one is the innermost
+  currentArena = previous;
+}
+
+ImageArena *ImageArena::getCurrent()
+{
+  return currentArena;
+}
+
+void ImageArena::clear()
+{
+  for (std::map<Key, std::vector<Block>>::iterator it = blocks.begin();
+       it != blocks.end(); it++)
+    for (size_t i = 0; i < it->second.size(); i++)
+      it->second[i].free(it->second[i]);
+  blocks.clear();
+  cachedBytes = 0;
+}
+
+ImageArenaStats ImageArena::getStats() const
+{
+  ImageArenaStats stats;
+  stats.hits        = hits;
+  stats.misses      = misses;
+  stats.dropped     = dropped;
+  stats.cachedBytes = cachedBytes;
+  return stats;
+}
+
+void ImageArena::setMaxBytes(size_t maxBytes)
+{
+  this->maxBytes = maxBytes;
+}
+
+bool ImageArena::acquire(const std::type_info &type, size_t width,
+                         size_t height, size_t depth, Block &block)
+{
+  Key key = {&type, width, height, depth};
+  std::map<Key, std::vector<Block>>::iterator it = blocks.find(key);
+
+  if (it == blocks.end() || it->second.empty()) {
+    misses++;
+    return false;
+  }
+
+  block = it->second.back();
+  it->second.pop_back();
+  cachedBytes -= block.bytes;
+  hits++;
+  return true;
+}
+
+bool ImageArena::release(const std::type_info &type, size_t width,
+                         size_t height, size_t depth, const Block &block)
+{
+  if (maxBytes != 0 && cachedBytes + block.bytes > maxBytes) {
+    dropped++;
+    return false;
+  }
+
+  Key key = {&type, width, height, depth};
+  blocks[key].push_back(block);
+  cachedBytes += block.bytes;
+  return true;
+}
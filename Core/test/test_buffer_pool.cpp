@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2011-2015, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DCore.h"
+#include "DTest.h"
+#include "private/DBufferPool.hpp"
+
+#include <thread>
+
+using namespace smil;
+
+class Test_BufferPool : public TestCase
+{
+  virtual void run()
+  {
+    BufferPool<UINT8> pool(64);
+
+    UINT8 *buf1 = pool.getBuffer();
+    UINT8 *buf2 = pool.getBuffer();
+    TEST_ASSERT(buf1 != buf2);
+    TEST_ASSERT(buf1[0] == 0 && buf1[63] == 0);
+
+    UINT8 *released = buf1;
+    pool.releaseBuffer(buf1);
+    TEST_ASSERT(buf1 == NULL);
+    buf1 = pool.getBuffer();
+    TEST_ASSERT(buf1 == released);
+
+    pool.releaseBuffer(buf1);
+    pool.releaseBuffer(buf2);
+
+    BufferPoolStats stats = pool.getStats();
+    TEST_ASSERT(stats.misses == 2);
+    TEST_ASSERT(stats.hits == 1);
+    TEST_ASSERT(stats.buffers == 2);
+    TEST_ASSERT(stats.peakBuffers == 2);
+
+    pool.clear();
+    TEST_ASSERT(pool.getStats().buffers == 0);
+  }
+};
+
+class Test_BufferPoolParallel : public TestCase
+{
+  // Each thread writes its own value in the buffer and checks that nobody
+  // else did meanwhile
+  bool hammer(BufferPool<int> &pool, int nthreads, int maxBufs)
+  {
+    bool ok = true;
+    int i;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads) reduction(&& : ok)
+#endif // USE_OPEN_MP
+    for (i = 0; i < 20000; i++) {
+      vector<int *> bufs = pool.getBuffers(1 + i % maxBufs);
+      for (size_t b = 0; b < bufs.size(); b++)
+        for (int x = 0; x < 32; x++)
+          bufs[b][x] = i;
+      for (size_t b = 0; b < bufs.size(); b++)
+        for (int x = 0; x < 32; x++)
+          ok = ok && bufs[b][x] == i;
+      pool.releaseBuffers(bufs);
+    }
+    return ok;
+  }
+
+  virtual void run()
+  {
+    BufferPool<int> pool(32);
+    TEST_ASSERT(hammer(pool, 4, 2));
+    TEST_ASSERT(pool.getStats().hits + pool.getStats().misses == 30000);
+
+    // When the number of buffers is limited, threads wait for each other
+    BufferPool<int> limitedPool(32);
+    limitedPool.setMaxNumberOfBuffers(3);
+    TEST_ASSERT(hammer(limitedPool, 4, 1));
+    TEST_ASSERT(limitedPool.getStats().peakBuffers <= 3);
+  }
+};
+
+// Threads not started by OpenMP all have the thread number 0, and must not
+// share its cache
+class Test_BufferPoolThreads : public TestCase
+{
+  static void hammer(BufferPool<int> *pool, int value, bool *ok)
+  {
+    for (int i = 0; i < 20000; i++) {
+      int *buf = pool->getBuffer();
+      for (int x = 0; x < 32; x++)
+        buf[x] = value;
+      for (int x = 0; x < 32; x++)
+        *ok = *ok && buf[x] == value;
+      pool->releaseBuffer(buf);
+    }
+  }
+
+  virtual void run()
+  {
+    BufferPool<int> pool(32);
+    bool ok[4] = {true, true, true, true};
+    vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+      threads.push_back(std::thread(hammer, &pool, t, &ok[t]));
+    for (int t = 0; t < 4; t++)
+      threads[t].join();
+    TEST_ASSERT(ok[0] && ok[1] && ok[2] && ok[3]);
+    TEST_ASSERT(pool.getStats().hits + pool.getStats().misses == 80000);
+  }
+};
+
+int main()
+{
+  TestSuite ts;
+
+  ADD_TEST(ts, Test_BufferPool);
+  ADD_TEST(ts, Test_BufferPoolParallel);
+  ADD_TEST(ts, Test_BufferPoolThreads);
+
+  return ts.run();
+}
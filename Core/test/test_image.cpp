@@ -28,6 +28,7 @@
  */
 
 #include "DImage.h"
+#include "DImageArena.h"
 #include "DTest.h"
 
 #include <iostream>
@@ -51,11 +52,55 @@ class Test_Image : public TestCase
   }
 };
 
+class Test_ImageArena : public TestCase
+{
+  virtual void run()
+  {
+    ImageArena arena;
+    UINT8 *pixels;
+    {
+      Image<UINT8> im1(64, 32, 2);
+      pixels = im1.getPixels();
+    }
+    TEST_ASSERT(arena.getStats().cachedBytes > 64 * 32 * 2);
+
+    // Same type and size: the memory and its tables are recycled
+    Image<UINT8> im2(64, 32, 2);
+    TEST_ASSERT(im2.getPixels() == pixels);
+    TEST_ASSERT(im2.getSlices()[1][3] == pixels + 64 * 32 + 3 * 64);
+
+    Image<UINT16> im3(64, 32, 2);
+    Image<UINT8> im4(32, 64, 2);
+    TEST_ASSERT(arena.getStats().hits == 1);
+    TEST_ASSERT(arena.getStats().misses == 3);
+    TEST_ASSERT(arena.getStats().cachedBytes == 0);
+
+    {
+      ImageArena inner(1);
+      TEST_ASSERT(ImageArena::getCurrent() == &inner);
+      {
+        Image<UINT8> im5(10, 10);
+      }
+      TEST_ASSERT(inner.getStats().dropped == 1);
+    }
+    TEST_ASSERT(ImageArena::getCurrent() == &arena);
+
+    // Images may outlive their arena
+    Image<UINT8> *im6;
+    {
+      ImageArena tmpArena;
+      im6 = new Image<UINT8>(16, 16);
+    }
+    delete im6;
+  }
+};
+
 int main()
 {
   TestSuite ts;
 
   ADD_TEST(ts, Test_Image);
+  ADD_TEST(ts, Test_ImageArena);
 
 
   return ts.run();
@@ -99,6 +99,8 @@ namespace smil
       SCALAR_TYPE_INT16,
       SCALAR_TYPE_FLOAT,
       SCALAR_TYPE_DOUBLE,
+      SCALAR_TYPE_UINT32,
+      SCALAR_TYPE_INT32,
       SCALAR_TYPE_UNKNOWN
     };
 
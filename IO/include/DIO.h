@@ -39,6 +39,7 @@
 #include "private/DImageIO.hpp"
 #include "private/DImageIO.hxx"
 #include "private/DImageIO_RAW.hpp"
+#include "private/DImageIO_MMAP.hpp"
 
 using namespace std;
 
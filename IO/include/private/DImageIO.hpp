@@ -90,7 +90,7 @@ namespace smil
    *
    * @note
    * The following file types are recognized : @b BMP @b JPG @b PBM @b PNG @b
-   * TIFF @b VTK
+   * SMV @b TIFF @b VTK
    *
    *
    * @smilexample{example-read.py}
@@ -105,10 +105,14 @@ namespace smil
    *
    * @note
    * The output 3D image will have the width and height of the first (2D) image
-   * and the number of images for depth.
+   * and the number of images for depth. Slices of another size are cropped or
+   * padded with zeros.
+   * @note
+   * Slices are decoded in parallel, each thread reading its file directly into
+   * the output image.
    * @note
    * The following file types are recognized : @b BMP @b JPG @b PBM @b PNG @b
-   * TIFF @b VTK
+   * SMV @b TIFF @b VTK
    *
    */
   template <class T> RES_T read(const vector<string> fileList, Image<T> &image);
@@ -125,7 +129,7 @@ namespace smil
    * Write a 3D image as a stack of 2D image files
    *
    * The file list must contain the same number of filenames as the 3D image
-   * depth.
+   * depth. Slices are encoded in parallel.
    *
    * @param[in] image : image to write to file
    * @param[in] fileList : list of filenames.
@@ -43,6 +43,7 @@
 #include "DImageIO_BMP.hpp"
 #include "DImageIO_VTK.hpp"
 #include "DImageIO_PBM.hpp"
+#include "DImageIO_SMV.hpp"
 
 #ifdef USE_PNG
 #include "DImageIO_PNG.hpp"
@@ -54,6 +55,10 @@
 #include "DImageIO_TIFF.hpp"
 #endif
 
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
 namespace smil
 {
   /**
@@ -94,6 +99,9 @@ namespace smil
     else if (fileExt == "PBM")
       return new PBMImageFileHandler<T>();
 
+    else if (fileExt == "SMV")
+      return new SMVImageFileHandler<T>();
+
     else {
       cout << "No reader/writer available for " << fileExt << " files." << endl;
       return NULL;
@@ -144,9 +152,45 @@ namespace smil
       return RES_ERR;
   }
 
+  /** @cond */
+  /*
+   * Read a 2D image file into the slice z of a 3D image.
+   *
+   * Local files of the size of the slices are decoded in place, through the
+   * view sliceIm. The others (URLs, files of a different size) go through
+   * tmpIm and are cropped or padded with zeros.
+   */
+  template <class T>
+  RES_T readSlice(const char *filename, Image<T> &image, size_t z,
+                  SharedImage<T> &sliceIm, Image<T> &tmpIm)
+  {
+    size_t w = image.getWidth(), h = image.getHeight();
+    typename Image<T>::lineType slicePix = image.getPixels() + z * w * h;
+
+    if (string(filename).find("://") == string::npos) {
+      auto_ptr<ImageFileHandler<T>> fHandler(getHandlerForFile<T>(filename));
+      if (!fHandler.get())
+        return RES_ERR;
+
+      ImageFileInfo fInfo;
+      if (fHandler->getFileInfo(filename, fInfo) == RES_OK &&
+          fInfo.width == w && fInfo.height == h && fInfo.depth <= 1) {
+        ASSERT((sliceIm.attach(slicePix, w, h) == RES_OK));
+        return fHandler->read(filename, sliceIm);
+      }
+    }
+
+    ASSERT((read(filename, tmpIm) == RES_OK));
+    std::fill(slicePix, slicePix + w * h, T(0));
+    return copy(tmpIm, 0, 0, 0, image, 0, 0, z);
+  }
+  /** @endcond */
+
   /*
    * Read a stack of 2D images and convert then into a 3D image
    *
+   * Slices are decoded concurrently, one per thread, directly into the
+   * output image.
    */
   template <class T> RES_T read(const vector<string> fileList, Image<T> &image)
   {
@@ -154,28 +198,54 @@ namespace smil
     if (nFiles == 0)
       return RES_ERR;
 
-    vector<string>::const_iterator it = fileList.begin();
-
     Image<T> tmpIm;
-    ASSERT((read((*it++).c_str(), tmpIm) == RES_OK));
+    ASSERT((read(fileList[0].c_str(), tmpIm) == RES_OK));
 
     size_t w = tmpIm.getWidth(), h = tmpIm.getHeight();
     ImageFreezer freezer(image);
 
     ASSERT((image.setSize(w, h, nFiles) == RES_OK));
-    ASSERT((fill(image, T(0)) == RES_OK));
     ASSERT((copy(tmpIm, 0, 0, 0, image, 0, 0, 0) == RES_OK));
 
-    size_t z = 1;
-
-    while (it != fileList.end()) {
-      ASSERT((read((*it).c_str(), tmpIm) == RES_OK));
-      ASSERT((copy(tmpIm, 0, 0, 0, image, 0, 0, z) == RES_OK));
-      it++;
-      z++;
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+    // Downloads all go through the same temporary file
+    for (size_t i = 0; i < nFiles; i++)
+      if (fileList[i].find("://") != string::npos &&
+          fileList[i].find("file://") != 0)
+        nthreads = 1;
+#endif // USE_OPEN_MP
+
+    // Images are created before the parallel section, as object
+    // registration isn't thread-safe
+    SharedImage<T> *sliceIms = new SharedImage<T>[nthreads];
+    Image<T> *tmpIms         = new Image<T>[nthreads];
+
+    int nErrors = 0;
+    int z;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
+    reduction(+ : nErrors)
+#endif // USE_OPEN_MP
+    for (z = 1; z < int(nFiles); z++) {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      const char *filename = fileList[z].c_str();
+      if (readSlice(filename, image, z, sliceIms[tid], tmpIms[tid]) !=
+          RES_OK) {
+        ERR_MSG(string("Error reading file ") + filename);
+        nErrors++;
+      }
     }
 
-    return RES_OK;
+    delete[] sliceIms;
+    delete[] tmpIms;
+
+    return nErrors == 0 ? RES_OK : RES_ERR;
   }
 
   /*
@@ -207,14 +277,40 @@ namespace smil
     }
 
     size_t w = image.getWidth(), h = image.getHeight();
-    Image<T> tmpIm(w, h);
-
-    for (size_t z = 0; z < nFiles; z++) {
-      ASSERT((copy(image, 0, 0, z, tmpIm) == RES_OK));
-      ASSERT((write(tmpIm, fileList[z].c_str()) == RES_OK));
+    typename Image<T>::lineType pixels = image.getPixels();
+
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+#endif // USE_OPEN_MP
+
+    // One view of the current slice per thread, created before the parallel
+    // section as object registration isn't thread-safe
+    SharedImage<T> *sliceIms = new SharedImage<T>[nthreads];
+
+    int nErrors = 0;
+    int z;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
+    reduction(+ : nErrors)
+#endif // USE_OPEN_MP
+    for (z = 0; z < int(nFiles); z++) {
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      const char *filename = fileList[z].c_str();
+      if (sliceIms[tid].attach(pixels + z * w * h, w, h) != RES_OK ||
+          write(sliceIms[tid], filename) != RES_OK) {
+        ERR_MSG(string("Error writing file ") + filename);
+        nErrors++;
+      }
     }
 
-    return RES_OK;
+    delete[] sliceIms;
+
+    return nErrors == 0 ? RES_OK : RES_ERR;
   }
 
   /*
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_IMAGE_IO_MMAP_HPP
+#define _D_IMAGE_IO_MMAP_HPP
+
+#include <fstream>
+#include <string>
+#include <typeinfo>
+
+#include "Core/include/private/DImage.hpp"
+#include "Core/include/private/DSharedImage.hpp"
+#include "IO/include/DCommonIO.h"
+#include "IO/include/private/DImageIO_VTK.hpp"
+
+using namespace std;
+
+namespace smil
+{
+  /**
+   * @addtogroup IO
+   */
+  /**@{*/
+
+  /**
+   * Mapping of a whole file in memory
+   *
+   * The mapping is either read-only, or copy-on-write: pages are then
+   * private to the process once modified, and changes are never written back
+   * to the file.
+   */
+  class FileMapping
+  {
+  public:
+    FileMapping();
+    ~FileMapping();
+
+    RES_T open(const char *filename, bool copyOnWrite = false);
+    void close();
+
+    bool isOpen() const
+    {
+      return data != NULL;
+    }
+    char *getData() const
+    {
+      return data;
+    }
+    size_t getSize() const
+    {
+      return size;
+    }
+
+  private:
+    char *data;
+    size_t size;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mapHandle;
+#endif // _WIN32
+
+    FileMapping(const FileMapping &);
+    FileMapping &operator=(const FileMapping &);
+  };
+
+  /**
+   * Image whose pixels are a memory mapping of a file
+   *
+   * Opening is almost free whatever the size of the file: pixels are only
+   * paged in by the system when accessed, and paged out under memory
+   * pressure.
+   *
+   * @note
+   * A read-only image must not be modified (writing to it crashes the
+   * program). Use copy-on-write mappings to get a modifiable image.
+   *
+   * @see mmapImage()
+   */
+  template <class T> class MappedImage : public SharedImage<T>
+  {
+  public:
+    typedef SharedImage<T> parentClass;
+
+    MappedImage() : SharedImage<T>(), readOnly(true)
+    {
+      this->className = "MappedImage";
+    }
+
+    virtual ~MappedImage()
+    {
+      unmap();
+    }
+
+    /**
+     * Map the pixels of a file, starting at byte @b offset
+     */
+    RES_T map(const char *filename, size_t width, size_t height, size_t depth,
+              size_t offset = 0, bool copyOnWrite = false)
+    {
+      unmap();
+
+      ASSERT(offset % sizeof(T) == 0, "Pixel data isn't aligned in the file",
+             RES_ERR_IO);
+      ASSERT((mapping.open(filename, copyOnWrite) == RES_OK), RES_ERR_IO);
+
+      size_t dataSize = width * height * depth * sizeof(T);
+      if (offset + dataSize > mapping.getSize()) {
+        mapping.close();
+        ERR_MSG(string("File ") + filename + " is too small");
+        return RES_ERR_IO;
+      }
+
+      readOnly = !copyOnWrite;
+      return this->attach((T *) (mapping.getData() + offset), width, height,
+                          depth);
+    }
+
+    void unmap()
+    {
+      this->detach();
+      mapping.close();
+      readOnly = true;
+    }
+
+    bool isMapped() const
+    {
+      return mapping.isOpen();
+    }
+    bool isReadOnly() const
+    {
+      return readOnly;
+    }
+
+  protected:
+    FileMapping mapping;
+    bool readOnly;
+
+  private:
+    MappedImage(const MappedImage<T> &);
+    MappedImage<T> &operator=(const MappedImage<T> &);
+  };
+
+  /**
+   * Map a @b RAW file as the pixels of an image
+   *
+   * @param[in] filename : file name
+   * @param[in] width, height, depth : image dimensions
+   * @param[out] image : output image
+   * @param[in] copyOnWrite : if false, the image is read-only
+   * @param[in] offset : position of the first pixel in the file (bytes)
+   *
+   * @see readRAW()
+   */
+  template <class T>
+  RES_T mmapImage(const char *filename, size_t width, size_t height,
+                  size_t depth, MappedImage<T> &image, bool copyOnWrite = false,
+                  size_t offset = 0)
+  {
+    return image.map(filename, width, height, depth, offset, copyOnWrite);
+  }
+
+  /** @cond */
+  template <class T> bool isVTKScalarType(ImageFileInfo::ScalarType scalarType)
+  {
+    switch (scalarType) {
+    case ImageFileInfo::SCALAR_TYPE_UINT8:
+      return typeid(T) == typeid(UINT8);
+    case ImageFileInfo::SCALAR_TYPE_UINT16:
+      return typeid(T) == typeid(UINT16);
+    case ImageFileInfo::SCALAR_TYPE_INT8:
+      return typeid(T) == typeid(INT8);
+    case ImageFileInfo::SCALAR_TYPE_INT16:
+      return typeid(T) == typeid(INT16);
+    case ImageFileInfo::SCALAR_TYPE_FLOAT:
+      return typeid(T) == typeid(float);
+    case ImageFileInfo::SCALAR_TYPE_DOUBLE:
+      return typeid(T) == typeid(double);
+    case ImageFileInfo::SCALAR_TYPE_UINT32:
+      return typeid(T) == typeid(UINT32);
+    case ImageFileInfo::SCALAR_TYPE_INT32:
+      return typeid(T) == typeid(INT32);
+    default:
+      return false;
+    }
+  }
+  /** @endcond */
+
+  /**
+   * Map an image file as the pixels of an image
+   *
+   * Only @b VTK files in @b BINARY mode can be mapped, when their scalar type
+   * is the type of the image.
+   *
+   * @param[in] filename : file name
+   * @param[out] image : output image
+   * @param[in] copyOnWrite : if false, the image is read-only
+   *
+   * @note
+   * Lines are seen in file order: unlike read(), the image isn't flipped
+   * vertically.
+   * @note
+   * @b VTK binary files are big-endian: multi-byte types can only be mapped on
+   * big-endian hosts. Use read() otherwise.
+   */
+  template <class T>
+  RES_T mmapImage(const char *filename, MappedImage<T> &image,
+                  bool copyOnWrite = false)
+  {
+    string fileExt = getFileExtension(filename);
+    if (fileExt == "RAW") {
+      ERR_MSG("RAW files have no header: the image size must be given");
+      return RES_ERR;
+    }
+    ASSERT(fileExt == "VTK", "Only VTK and RAW files can be mapped",
+           RES_ERR_NOT_IMPLEMENTED);
+
+    VTKHeader hStruct;
+    std::ifstream fp(filename, ios_base::binary);
+    if (!fp) {
+      ERR_MSG(string("Cannot open file ") + filename);
+      return RES_ERR_IO;
+    }
+    ASSERT((readVTKHeader(fp, hStruct) == RES_OK),
+           "Error reading VTK file header", RES_ERR_IO);
+    fp.close();
+
+    ASSERT(hStruct.binaryFile, "Only BINARY VTK files can be mapped",
+           RES_ERR_IO);
+    if (!isVTKScalarType<T>(hStruct.scalarType)) {
+      ERR_MSG("Input file type is " + hStruct.scalarTypeStr);
+      return RES_ERR_IO;
+    }
+
+    UINT16 endianTest = 1;
+    ASSERT(sizeof(T) == 1 || *(UINT8 *) &endianTest == 0,
+           "Big-endian data can't be mapped on this host", RES_ERR_IO);
+
+    return image.map(filename, hStruct.width, hStruct.height, hStruct.depth,
+                     size_t(hStruct.startPos), copyOnWrite);
+  }
+
+  /**@}*/
+
+} // namespace smil
+
+#endif // _D_IMAGE_IO_MMAP_HPP
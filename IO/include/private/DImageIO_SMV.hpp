@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _D_IMAGE_IO_SMV_HPP
+#define _D_IMAGE_IO_SMV_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Core/include/private/DTypes.hpp"
+#include "Core/include/private/DImage.hpp"
+#include "IO/include/private/DImageIO.hpp"
+
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
+using namespace std;
+
+namespace smil
+{
+  /**
+   * @addtogroup IO
+   */
+  /**@{*/
+
+  /** @cond */
+  /*
+   * SMV files: Smil chunked volumes
+   *
+   * The image is split into chunks, compressed independently. The file holds
+   * a header, the index of the chunks (offset and size in the file, codec),
+   * then the chunks. All values are in the byte order of the host which
+   * wrote the file. A byte-order marker in the header is checked when
+   * reading: files written on a host of the other endianness are rejected.
+   */
+  enum SMVCodec { SMV_CODEC_RAW = 0, SMV_CODEC_RLE = 1 };
+
+  struct SMVHeader {
+    SMVHeader() : pixelType(0), width(0), height(0), depth(0)
+    {
+      chunkSize[0] = chunkSize[1] = chunkSize[2] = 0;
+    }
+
+    // Kind (0: unsigned, 1: signed, 2: floating point) * 16 + size in bytes
+    UINT32 pixelType;
+    UINT64 width, height, depth;
+    UINT32 chunkSize[3];
+
+    vector<UINT64> chunkOffsets;
+    vector<UINT64> chunkBytes;
+    vector<UINT32> chunkCodecs;
+
+    size_t getChunkNbr(int axis) const
+    {
+      size_t s[3] = {size_t(width), size_t(height), size_t(depth)};
+      return (s[axis] + chunkSize[axis] - 1) / chunkSize[axis];
+    }
+    size_t getChunkCount() const
+    {
+      return getChunkNbr(0) * getChunkNbr(1) * getChunkNbr(2);
+    }
+
+    // Bounding box (x0, y0, z0, x1, y1, z1) of a chunk
+    void getChunkBox(size_t index, size_t *box) const
+    {
+      size_t s[3] = {size_t(width), size_t(height), size_t(depth)};
+      size_t c[3];
+      c[0] = index % getChunkNbr(0);
+      c[1] = (index / getChunkNbr(0)) % getChunkNbr(1);
+      c[2] = index / (getChunkNbr(0) * getChunkNbr(1));
+      for (int i = 0; i < 3; i++) {
+        box[i]     = c[i] * chunkSize[i];
+        box[i + 3] = std::min(box[i] + chunkSize[i], s[i]);
+      }
+    }
+  };
+
+  RES_T readSMVHeader(FILE *fp, SMVHeader &hdr);
+  RES_T writeSMVHeader(FILE *fp, const SMVHeader &hdr);
+  RES_T getSMVFileInfo(const char *filename, ImageFileInfo &fInfo);
+  int smvSeek(FILE *fp, UINT64 offset);
+
+  template <class T> UINT32 smvPixelType()
+  {
+    UINT32 kind = !numeric_limits<T>::is_integer ? 2
+                  : numeric_limits<T>::is_signed ? 1
+                                                 : 0;
+    return kind * 16 + UINT32(sizeof(T));
+  }
+
+  // Values are compared by their bytes, so that encoding is lossless for
+  // floating point values equal but different (-0. and 0.)
+  template <class T> inline bool smvSameValue(const T &a, const T &b)
+  {
+    return memcmp(&a, &b, sizeof(T)) == 0;
+  }
+
+  /*
+   * Run-length encoding of pixel values
+   *
+   * Packets start with a 16 bit control word. If its high bit is set, it is
+   * followed by one value repeated (ctrl & 0x7FFF) + 1 times, otherwise by
+   * ctrl + 1 literal values.
+   */
+  template <class T>
+  void smvEncodeRLE(const T *in, size_t n, vector<char> &out)
+  {
+    const size_t maxPacket = 0x8000;
+    out.clear();
+
+    size_t i = 0;
+    while (i < n) {
+      size_t run = 1;
+      while (i + run < n && run < maxPacket &&
+             smvSameValue(in[i + run], in[i]))
+        run++;
+
+      UINT16 ctrl;
+      if (run >= 3) {
+        ctrl = UINT16(0x8000 | (run - 1));
+        out.insert(out.end(), (const char *) &ctrl,
+                   (const char *) &ctrl + sizeof(ctrl));
+        out.insert(out.end(), (const char *) (in + i),
+                   (const char *) (in + i + 1));
+        i += run;
+        continue;
+      }
+
+      // Literal values, up to the next run of 3 equal values
+      size_t j = i + 1;
+      while (j < n && j - i < maxPacket &&
+             !(j + 2 < n && smvSameValue(in[j], in[j + 1]) &&
+               smvSameValue(in[j], in[j + 2])))
+        j++;
+      ctrl = UINT16(j - i - 1);
+      out.insert(out.end(), (const char *) &ctrl,
+                 (const char *) &ctrl + sizeof(ctrl));
+      out.insert(out.end(), (const char *) (in + i), (const char *) (in + j));
+      i = j;
+    }
+  }
+
+  template <class T>
+  RES_T smvDecodeRLE(const char *in, size_t inSize, T *out, size_t n)
+  {
+    const char *inEnd = in + inSize;
+    size_t i          = 0;
+
+    while (i < n) {
+      UINT16 ctrl;
+      if (inEnd - in < int(sizeof(ctrl)))
+        return RES_ERR_IO;
+      memcpy(&ctrl, in, sizeof(ctrl));
+      in += sizeof(ctrl);
+
+      size_t count = (ctrl & 0x7FFF) + 1;
+      if (i + count > n)
+        return RES_ERR_IO;
+
+      if (ctrl & 0x8000) {
+        if (inEnd - in < int(sizeof(T)))
+          return RES_ERR_IO;
+        T val;
+        memcpy(&val, in, sizeof(T));
+        in += sizeof(T);
+        std::fill(out + i, out + i + count, val);
+      } else {
+        if (size_t(inEnd - in) < count * sizeof(T))
+          return RES_ERR_IO;
+        memcpy(out + i, in, count * sizeof(T));
+        in += count * sizeof(T);
+      }
+      i += count;
+    }
+    return in == inEnd ? RES_OK : RES_ERR_IO;
+  }
+
+  // Copy between a chunk buffer and the box (x0, y0, z0, x1, y1, z1) of an
+  // image, whose origin is at (ox, oy, oz)
+  template <class T>
+  void smvCopyChunk(T *chunk, const size_t *box, Image<T> &image,
+                    const size_t *origin, bool toImage)
+  {
+    typename Image<T>::volType slices = image.getSlices();
+    size_t w = box[3] - box[0];
+
+    for (size_t z = box[2]; z < box[5]; z++)
+      for (size_t y = box[1]; y < box[4]; y++) {
+        T *line = slices[z - origin[2]][y - origin[1]] + box[0] - origin[0];
+        if (toImage)
+          std::copy(chunk, chunk + w, line);
+        else
+          std::copy(line, line + w, chunk);
+        chunk += w;
+      }
+  }
+
+  /*
+   * Decode the chunks of chunkList intersecting the region of imOut, placed
+   * at origin in the volume. Chunks are read by batches, decoded in parallel.
+   */
+  template <class T>
+  RES_T smvReadChunks(FILE *fp, const SMVHeader &hdr,
+                      const vector<size_t> &chunkList, const size_t *origin,
+                      Image<T> &imOut)
+  {
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+#endif // USE_OPEN_MP
+
+    size_t region[6] = {origin[0],
+                        origin[1],
+                        origin[2],
+                        origin[0] + imOut.getWidth(),
+                        origin[1] + imOut.getHeight(),
+                        origin[2] + imOut.getDepth()};
+    size_t batchSize = 4 * size_t(nthreads);
+    vector<vector<char> > packed(batchSize);
+
+    for (size_t b0 = 0; b0 < chunkList.size(); b0 += batchSize) {
+      int batchNbr = int(std::min(batchSize, chunkList.size() - b0));
+
+      for (int i = 0; i < batchNbr; i++) {
+        size_t c = chunkList[b0 + i];
+        packed[i].resize(size_t(hdr.chunkBytes[c]));
+        if (smvSeek(fp, hdr.chunkOffsets[c]) != 0 ||
+            fread(packed[i].data(), 1, packed[i].size(), fp) !=
+                packed[i].size()) {
+          ERR_MSG("Error reading chunk data");
+          return RES_ERR_IO;
+        }
+      }
+
+      int nErrors = 0;
+      int i;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads) \
+    reduction(+ : nErrors)
+#endif // USE_OPEN_MP
+      for (i = 0; i < batchNbr; i++) {
+        size_t c = chunkList[b0 + i];
+        size_t box[6];
+        hdr.getChunkBox(c, box);
+        size_t pixNbr =
+            (box[3] - box[0]) * (box[4] - box[1]) * (box[5] - box[2]);
+
+        vector<T> chunk(pixNbr);
+        RES_T res = RES_OK;
+        if (hdr.chunkCodecs[c] == SMV_CODEC_RLE)
+          res = smvDecodeRLE(packed[i].data(), packed[i].size(), chunk.data(),
+                             pixNbr);
+        else if (hdr.chunkCodecs[c] == SMV_CODEC_RAW &&
+                 packed[i].size() == pixNbr * sizeof(T))
+          memcpy(chunk.data(), packed[i].data(), packed[i].size());
+        else
+          res = RES_ERR_IO;
+        if (res != RES_OK) {
+          nErrors++;
+          continue;
+        }
+
+        // Only the part of the chunk within the region is copied
+        size_t inter[6];
+        for (int k = 0; k < 3; k++) {
+          inter[k]     = std::max(box[k], region[k]);
+          inter[k + 3] = std::min(box[k + 3], region[k + 3]);
+        }
+        if (inter[0] == box[0] && inter[3] == box[3] && inter[1] == box[1] &&
+            inter[4] == box[4] && inter[2] == box[2] && inter[5] == box[5]) {
+          smvCopyChunk(chunk.data(), box, imOut, origin, true);
+          continue;
+        }
+        size_t w = box[3] - box[0], h = box[4] - box[1];
+        for (size_t z = inter[2]; z < inter[5]; z++)
+          for (size_t y = inter[1]; y < inter[4]; y++) {
+            T *src = chunk.data() +
+                     ((z - box[2]) * h + (y - box[1])) * w + inter[0] - box[0];
+            std::copy(src, src + inter[3] - inter[0],
+                      imOut.getSlices()[z - origin[2]][y - origin[1]] +
+                          inter[0] - origin[0]);
+          }
+      }
+
+      if (nErrors > 0) {
+        ERR_MSG("Corrupted chunk data");
+        return RES_ERR_IO;
+      }
+    }
+    return RES_OK;
+  }
+  /** @endcond */
+
+  /**
+   * Write an image in the @b SMV (Smil chunked volume) format
+   *
+   * The image is split into chunks of @b chunkSize pixels along each axis (and
+   * a single slice for 2D images), compressed in parallel.
+   *
+   * @param[in] image : image to write
+   * @param[in] filename : file name
+   * @param[in] chunkSize : chunk side, in pixels
+   * @param[in] compress : run-length encode the chunks (a chunk is stored as
+   * is when encoding doesn't reduce its size)
+   */
+  template <class T>
+  RES_T writeSMV(const Image<T> &image, const char *filename,
+                 size_t chunkSize = 64, bool compress = true)
+  {
+    ASSERT_ALLOCATED(&image);
+    ASSERT(chunkSize > 0, RES_ERR);
+
+    SMVHeader hdr;
+    hdr.pixelType = smvPixelType<T>();
+    hdr.width     = image.getWidth();
+    hdr.height    = image.getHeight();
+    hdr.depth     = image.getDepth();
+    hdr.chunkSize[0] = UINT32(std::min(chunkSize, image.getWidth()));
+    hdr.chunkSize[1] = UINT32(std::min(chunkSize, image.getHeight()));
+    hdr.chunkSize[2] = UINT32(std::min(chunkSize, image.getDepth()));
+
+    size_t chunkCount = hdr.getChunkCount();
+    hdr.chunkOffsets.resize(chunkCount, 0);
+    hdr.chunkBytes.resize(chunkCount, 0);
+    hdr.chunkCodecs.resize(chunkCount, SMV_CODEC_RAW);
+
+    FILE *fp = NULL;
+    SMIL_OPEN(fp, filename, "wb");
+    ASSERT(fp, "Error: couldn't open file", RES_ERR_IO);
+    FileCloser fileCloser(fp);
+
+    // The index is written again once the chunks are known
+    ASSERT((writeSMVHeader(fp, hdr) == RES_OK), RES_ERR_IO);
+    UINT64 offset = UINT64(ftell(fp));
+
+    int nthreads = 1;
+#ifdef USE_OPEN_MP
+    nthreads = Core::getInstance()->getNumberOfThreads();
+#endif // USE_OPEN_MP
+
+    size_t batchSize = 4 * size_t(nthreads);
+    vector<vector<char> > packed(batchSize);
+    size_t origin[3] = {0, 0, 0};
+
+    for (size_t b0 = 0; b0 < chunkCount; b0 += batchSize) {
+      int batchNbr = int(std::min(batchSize, chunkCount - b0));
+      int i;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < batchNbr; i++) {
+        size_t c = b0 + i;
+        size_t box[6];
+        hdr.getChunkBox(c, box);
+        size_t pixNbr =
+            (box[3] - box[0]) * (box[4] - box[1]) * (box[5] - box[2]);
+
+        vector<T> chunk(pixNbr);
+        smvCopyChunk(chunk.data(), box, const_cast<Image<T> &>(image), origin,
+                     false);
+
+        hdr.chunkCodecs[c] = SMV_CODEC_RAW;
+        if (compress) {
+          smvEncodeRLE(chunk.data(), pixNbr, packed[i]);
+          if (packed[i].size() < pixNbr * sizeof(T)) {
+            hdr.chunkCodecs[c] = SMV_CODEC_RLE;
+            continue;
+          }
+        }
+        packed[i].assign((const char *) chunk.data(),
+                         (const char *) (chunk.data() + pixNbr));
+      }
+
+      for (i = 0; i < batchNbr; i++) {
+        size_t c = b0 + i;
+        hdr.chunkOffsets[c] = offset;
+        hdr.chunkBytes[c]   = packed[i].size();
+        if (fwrite(packed[i].data(), 1, packed[i].size(), fp) !=
+            packed[i].size()) {
+          ERR_MSG("Error writing chunk data");
+          return RES_ERR_IO;
+        }
+        offset += packed[i].size();
+      }
+    }
+
+    ASSERT((smvSeek(fp, 0) == 0), RES_ERR_IO);
+    return writeSMVHeader(fp, hdr);
+  }
+
+  /**
+   * Read a region of an @b SMV file
+   *
+   * Only the chunks intersecting the region are read and decoded.
+   *
+   * @param[in] filename : file name
+   * @param[in] x0, y0, z0 : origin of the region
+   * @param[out] imOut : output image, whose size gives the size of the region
+   */
+  template <class T>
+  RES_T readSMVRegion(const char *filename, size_t x0, size_t y0, size_t z0,
+                      Image<T> &imOut)
+  {
+    ASSERT_ALLOCATED(&imOut);
+
+    FILE *fp = NULL;
+    SMIL_OPEN(fp, filename, "rb");
+    ASSERT(fp, "Error: couldn't open file", RES_ERR_IO);
+    FileCloser fileCloser(fp);
+
+    SMVHeader hdr;
+    ASSERT((readSMVHeader(fp, hdr) == RES_OK), RES_ERR_IO);
+    ASSERT(hdr.pixelType == smvPixelType<T>(),
+           "File pixel type doesn't match the image type", RES_ERR_IO);
+    ASSERT(x0 + imOut.getWidth() <= hdr.width &&
+               y0 + imOut.getHeight() <= hdr.height &&
+               z0 + imOut.getDepth() <= hdr.depth,
+           "Region out of the image", RES_ERR);
+
+    size_t origin[3] = {x0, y0, z0};
+    size_t end[3]    = {x0 + imOut.getWidth(), y0 + imOut.getHeight(),
+                     z0 + imOut.getDepth()};
+    vector<size_t> chunkList;
+    size_t box[6];
+    for (size_t c = 0; c < hdr.getChunkCount(); c++) {
+      hdr.getChunkBox(c, box);
+      if (box[0] < end[0] && box[3] > origin[0] && box[1] < end[1] &&
+          box[4] > origin[1] && box[2] < end[2] && box[5] > origin[2])
+        chunkList.push_back(c);
+    }
+
+    ImageFreezer freeze(imOut);
+    return smvReadChunks(fp, hdr, chunkList, origin, imOut);
+  }
+
+  template <class T = void>
+  class SMVImageFileHandler : public ImageFileHandler<T>
+  {
+  public:
+    SMVImageFileHandler() : ImageFileHandler<T>("SMV")
+    {
+    }
+
+    virtual RES_T getFileInfo(const char *filename, ImageFileInfo &fInfo)
+    {
+      return getSMVFileInfo(filename, fInfo);
+    }
+
+    virtual RES_T read(const char *filename, Image<T> &image)
+    {
+      ImageFileInfo fInfo;
+      ASSERT((getSMVFileInfo(filename, fInfo) == RES_OK), RES_ERR_IO);
+      ASSERT((image.setSize(fInfo.width, fInfo.height, fInfo.depth) ==
+              RES_OK),
+             RES_ERR_BAD_ALLOCATION);
+      return readSMVRegion(filename, 0, 0, 0, image);
+    }
+
+    virtual RES_T write(const Image<T> &image, const char *filename)
+    {
+      return writeSMV(image, filename);
+    }
+  };
+
+  template <>
+  inline RES_T SMVImageFileHandler<void>::read(const char *, Image<void> &)
+  {
+    return RES_ERR;
+  }
+
+  template <>
+  inline RES_T SMVImageFileHandler<void>::write(const Image<void> &,
+                                                const char *)
+  {
+    return RES_ERR;
+  }
+
+  template <>
+  inline RES_T SMVImageFileHandler<RGB>::read(const char *, Image<RGB> &)
+  {
+    return RES_ERR_NOT_IMPLEMENTED;
+  }
+
+  template <>
+  inline RES_T SMVImageFileHandler<RGB>::write(const Image<RGB> &,
+                                               const char *)
+  {
+    return RES_ERR_NOT_IMPLEMENTED;
+  }
+
+  /**@}*/
+
+} // namespace smil
+
+#endif // _D_IMAGE_IO_SMV_HPP
@@ -79,6 +79,37 @@ namespace smil
   IMAGEFILEHANDLER_TEMP_SPEC(TIFF, UINT16);
   IMAGEFILEHANDLER_TEMP_SPEC(TIFF, RGB);
 
+  /**
+   * Read a region of a TIFF file
+   *
+   * The size of the region is the size of @b imOut and its origin is
+   * (@b x0, @b y0, @b z0). The pages of a multi-page file are the slices of
+   * the volume. Only the tiles (or strips) touching the region are decoded,
+   * in parallel.
+   */
+  RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0,
+                       Image<UINT8> &imOut);
+  RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0,
+                       Image<UINT16> &imOut);
+  RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0,
+                       Image<RGB> &imOut);
+
+  /**
+   * Write an image to a TIFF file
+   *
+   * 3D images are written as multi-page files, one page per slice. Files
+   * whose pixel data doesn't fit in 4GB are written as BigTIFF.
+   *
+   * @param[in] tileSize : size of the square tiles (a multiple of 16). With
+   * the default value 0, the pages are organised in strips.
+   */
+  RES_T writeTIFF(const Image<UINT8> &image, const char *filename,
+                  size_t tileSize = 0);
+  RES_T writeTIFF(const Image<UINT16> &image, const char *filename,
+                  size_t tileSize = 0);
+  RES_T writeTIFF(const Image<RGB> &image, const char *filename,
+                  size_t tileSize = 0);
+
   /*@}*/
 
 } // namespace smil
@@ -50,6 +50,8 @@
 #include "Core/include/private/DTypes.hpp"
 #include "DIO.h"
 #include "DImageIO_RAW.hpp"
+#include "DImageIO_MMAP.hpp"
+#include "DImageIO_SMV.hpp"
 %}
  
 
@@ -60,6 +62,8 @@
 %include "DImageIO.hpp"
 
 %include "DImageIO_RAW.hpp"
+%include "DImageIO_MMAP.hpp"
+%include "DImageIO_SMV.hpp"
 
 
 // Import smilCore to have correct function signatures (arguments with Image_UINT8 instead of Image<unsigned char>)
@@ -77,3 +81,14 @@ TEMPLATE_WRAP_FUNC(writeRAW);
 
 TEMPLATE_WRAP_SUPPL_FUNC(readRAW);
 TEMPLATE_WRAP_SUPPL_FUNC(writeRAW);
+
+namespace smil
+{
+  TEMPLATE_WRAP_CLASS(MappedImage, MappedImage);
+  TEMPLATE_WRAP_SUPPL_CLASS(MappedImage, MappedImage);
+}
+TEMPLATE_WRAP_FUNC(mmapImage);
+TEMPLATE_WRAP_SUPPL_FUNC(mmapImage);
+
+TEMPLATE_WRAP_FUNC(writeSMV);
+TEMPLATE_WRAP_FUNC(readSMVRegion);
@@ -90,6 +90,12 @@ namespace smil
       case SCALAR_TYPE_DOUBLE:
         s = "DOUBLE";
         break;
+      case SCALAR_TYPE_UINT32:
+        s = "UINT32";
+        break;
+      case SCALAR_TYPE_INT32:
+        s = "INT32";
+        break;
       case SCALAR_TYPE_UNKNOWN:
         s = "UNKNOWN";
         break;
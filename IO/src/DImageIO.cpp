@@ -110,6 +110,14 @@ namespace smil
           return img;
         else
           ERR_MSG("Error reading unsigned 16 bit image");
+      } else if (fInfo.scalarType == ImageFileInfo::SCALAR_TYPE_UINT32) {
+        Image<UINT32> *                    img = new Image<UINT32>();
+        auto_ptr<ImageFileHandler<UINT32>> fHandler(
+            getHandlerForFile<UINT32>(filename));
+        if (fHandler->read(filename, *img) == RES_OK)
+          return img;
+        else
+          ERR_MSG("Error reading unsigned 32 bit image");
       } else if (fInfo.scalarType == ImageFileInfo::SCALAR_TYPE_INT16) {
         Image<INT16> *                    img = new Image<INT16>();
         auto_ptr<ImageFileHandler<INT16>> fHandler(
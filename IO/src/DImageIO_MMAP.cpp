@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "IO/include/private/DImageIO_MMAP.hpp"
+
+namespace smil
+{
+#ifdef _WIN32
+  FileMapping::FileMapping()
+      : data(NULL), size(0), fileHandle(NULL), mapHandle(NULL)
+  {
+  }
+#else  // _WIN32
+  FileMapping::FileMapping() : data(NULL), size(0)
+  {
+  }
+#endif // _WIN32
+
+  FileMapping::~FileMapping()
+  {
+    close();
+  }
+
+#ifdef _WIN32
+  RES_T FileMapping::open(const char *filename, bool copyOnWrite)
+  {
+    close();
+
+    HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+      ERR_MSG(string("Cannot open file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+      CloseHandle(hFile);
+      ERR_MSG(string("Cannot map empty file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    HANDLE hMap = CreateFileMappingA(
+        hFile, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+    if (hMap == NULL) {
+      CloseHandle(hFile);
+      ERR_MSG(string("Cannot map file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    void *ptr = MapViewOfFile(hMap, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ,
+                              0, 0, 0);
+    if (ptr == NULL) {
+      CloseHandle(hMap);
+      CloseHandle(hFile);
+      ERR_MSG(string("Cannot map file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    data       = (char *) ptr;
+    size       = size_t(fileSize.QuadPart);
+    fileHandle = hFile;
+    mapHandle  = hMap;
+
+    return RES_OK;
+  }
+
+  void FileMapping::close()
+  {
+    if (data)
+      UnmapViewOfFile(data);
+    if (mapHandle)
+      CloseHandle((HANDLE) mapHandle);
+    if (fileHandle)
+      CloseHandle((HANDLE) fileHandle);
+
+    data       = NULL;
+    size       = 0;
+    fileHandle = NULL;
+    mapHandle  = NULL;
+  }
+
+#else // _WIN32
+
+  RES_T FileMapping::open(const char *filename, bool copyOnWrite)
+  {
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+      ERR_MSG(string("Cannot open file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      ERR_MSG(string("Cannot map empty file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    int prot  = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *ptr = mmap(NULL, size_t(st.st_size), prot, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid once the file is closed
+    ::close(fd);
+
+    if (ptr == MAP_FAILED) {
+      ERR_MSG(string("Cannot map file ") + filename);
+      return RES_ERR_IO;
+    }
+
+    data = (char *) ptr;
+    size = size_t(st.st_size);
+
+    return RES_OK;
+  }
+
+  void FileMapping::close()
+  {
+    if (data)
+      munmap(data, size);
+
+    data = NULL;
+    size = 0;
+  }
+
+#endif // _WIN32
+
+} // namespace smil
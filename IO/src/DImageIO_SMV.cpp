@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2011-2016, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "IO/include/private/DImageIO_SMV.hpp"
+
+namespace smil
+{
+  static const char SMV_MAGIC[4]   = {'S', 'M', 'V', '1'};
+  static const UINT32 SMV_BYTE_ORDER = 0x01020304;
+
+  template <class V> static bool writeValue(FILE *fp, V val)
+  {
+    return fwrite(&val, sizeof(V), 1, fp) == 1;
+  }
+
+  template <class V> static bool readValue(FILE *fp, V &val)
+  {
+    return fread(&val, sizeof(V), 1, fp) == 1;
+  }
+
+  int smvSeek(FILE *fp, UINT64 offset)
+  {
+#ifdef _WIN32
+    return _fseeki64(fp, __int64(offset), SEEK_SET);
+#else  // _WIN32
+    return fseeko(fp, off_t(offset), SEEK_SET);
+#endif // _WIN32
+  }
+
+  RES_T writeSMVHeader(FILE *fp, const SMVHeader &hdr)
+  {
+    size_t chunkCount = hdr.getChunkCount();
+    bool ok           = fwrite(SMV_MAGIC, 1, 4, fp) == 4;
+
+    ok = ok && writeValue(fp, SMV_BYTE_ORDER);
+    ok = ok && writeValue(fp, hdr.pixelType);
+    ok = ok && writeValue(fp, hdr.width) && writeValue(fp, hdr.height) &&
+         writeValue(fp, hdr.depth);
+    for (int i = 0; i < 3; i++)
+      ok = ok && writeValue(fp, hdr.chunkSize[i]);
+    ok = ok && writeValue(fp, UINT64(chunkCount));
+
+    for (size_t c = 0; ok && c < chunkCount; c++)
+      ok = writeValue(fp, hdr.chunkOffsets[c]) &&
+           writeValue(fp, hdr.chunkBytes[c]) &&
+           writeValue(fp, hdr.chunkCodecs[c]);
+
+    if (!ok) {
+      ERR_MSG("Error writing SMV header");
+      return RES_ERR_IO;
+    }
+    return RES_OK;
+  }
+
+  RES_T readSMVHeader(FILE *fp, SMVHeader &hdr)
+  {
+    char magic[4];
+    UINT32 byteOrder;
+    UINT64 chunkCount;
+
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, SMV_MAGIC, 4) != 0) {
+      ERR_MSG("Not an SMV file");
+      return RES_ERR_IO;
+    }
+    if (!readValue(fp, byteOrder) || byteOrder != SMV_BYTE_ORDER) {
+      ERR_MSG("Unsupported SMV byte order");
+      return RES_ERR_IO;
+    }
+
+    bool ok = readValue(fp, hdr.pixelType) && readValue(fp, hdr.width) &&
+              readValue(fp, hdr.height) && readValue(fp, hdr.depth);
+    for (int i = 0; i < 3; i++)
+      ok = ok && readValue(fp, hdr.chunkSize[i]) && hdr.chunkSize[i] > 0;
+    ok = ok && readValue(fp, chunkCount) && hdr.width > 0 && hdr.height > 0 &&
+         hdr.depth > 0 && chunkCount == hdr.getChunkCount();
+    if (!ok) {
+      ERR_MSG("Corrupted SMV header");
+      return RES_ERR_IO;
+    }
+
+    hdr.chunkOffsets.resize(size_t(chunkCount));
+    hdr.chunkBytes.resize(size_t(chunkCount));
+    hdr.chunkCodecs.resize(size_t(chunkCount));
+    for (size_t c = 0; ok && c < chunkCount; c++)
+      ok = readValue(fp, hdr.chunkOffsets[c]) &&
+           readValue(fp, hdr.chunkBytes[c]) &&
+           readValue(fp, hdr.chunkCodecs[c]);
+    if (!ok) {
+      ERR_MSG("Corrupted SMV chunk index");
+      return RES_ERR_IO;
+    }
+    return RES_OK;
+  }
+
+  RES_T getSMVFileInfo(const char *filename, ImageFileInfo &fInfo)
+  {
+    FILE *fp = NULL;
+    SMIL_OPEN(fp, filename, "rb");
+    ASSERT(fp, "Error: couldn't open file", RES_ERR_IO);
+    FileCloser fileCloser(fp);
+
+    SMVHeader hdr;
+    ASSERT((readSMVHeader(fp, hdr) == RES_OK), RES_ERR_IO);
+
+    fInfo.filename  = filename;
+    fInfo.width     = size_t(hdr.width);
+    fInfo.height    = size_t(hdr.height);
+    fInfo.depth     = size_t(hdr.depth);
+    fInfo.channels  = 1;
+    fInfo.colorType = ImageFileInfo::COLOR_TYPE_GRAY;
+
+    switch (hdr.pixelType) {
+    case 0 * 16 + 1:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UINT8;
+      break;
+    case 0 * 16 + 2:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UINT16;
+      break;
+    case 1 * 16 + 1:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_INT8;
+      break;
+    case 1 * 16 + 2:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_INT16;
+      break;
+    case 0 * 16 + 4:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UINT32;
+      break;
+    case 1 * 16 + 4:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_INT32;
+      break;
+    case 2 * 16 + 4:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_FLOAT;
+      break;
+    case 2 * 16 + 8:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_DOUBLE;
+      break;
+    default:
+      fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UNKNOWN;
+    }
+    fInfo.valid = true;
+
+    return RES_OK;
+  }
+} // namespace smil
@@ -35,6 +35,10 @@
 
 #include <tiffio.h>
 
+#ifdef USE_OPEN_MP
+#include <omp.h>
+#endif // USE_OPEN_MP
+
 namespace smil
 {
     struct TIFFHeader
@@ -58,10 +62,94 @@ namespace smil
         return RES_OK;
     }
     
-  
-    RES_T getTIFFFileInfo(const char* filename, ImageFileInfo &fInfo)
+    /**
+     * Organisation of a page of a TIFF file
+     * 
+     * Strips are handled as tiles of the full image width.
+     */
+    struct TIFFPage
+    {
+        UINT32 width, height;
+        UINT16 nbits, nsamples, planar, sampleFormat;
+        bool tiled;
+        UINT32 blockWidth, blockHeight;
+        UINT64 offset;
+        
+        // Same size and pixel format (the tiles or strips may differ)
+        bool isSliceOf(const TIFFPage &page) const
+        {
+            return width==page.width && height==page.height && nbits==page.nbits && nsamples==page.nsamples 
+                && sampleFormat==page.sampleFormat && (nsamples==1 || planar==page.planar);
+        }
+    };
+    
+    /**
+     * Pages of a TIFF file forming a volume
+     * 
+     * The layout has the format of the first page. Only the pages with the
+     * size and the pixel format of the first one are kept (reduced resolution
+     * images and thumbnails are skipped), each one with its own tiles or strips.
+     */
+    struct TIFFLayout : public TIFFPage
+    {
+        vector<TIFFPage> pages;
+        
+        size_t getPageCount() const { return pages.size(); }
+    };
+    
+    static RES_T getTIFFPage(TIFF *tif, TIFFPage &page)
+    {
+        page.width = page.height = 0;
+        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &page.width);
+        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &page.height);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &page.nbits);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &page.nsamples);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &page.planar);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &page.sampleFormat);
+        
+        page.tiled = TIFFIsTiled(tif)!=0;
+        page.blockWidth = page.blockHeight = 0;
+        if (page.tiled)
+        {
+            TIFFGetField(tif, TIFFTAG_TILEWIDTH, &page.blockWidth);
+            TIFFGetField(tif, TIFFTAG_TILELENGTH, &page.blockHeight);
+        }
+        else
+        {
+            UINT32 rowsPerStrip = page.height;
+            TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+            page.blockWidth = page.width;
+            page.blockHeight = min(rowsPerStrip, page.height);
+        }
+        page.offset = TIFFCurrentDirOffset(tif);
+        
+        if (page.width==0 || page.height==0 || page.blockWidth==0 || page.blockHeight==0)
+          return RES_ERR_IO;
+        
+        return RES_OK;
+    }
+    
+    static RES_T getTIFFLayout(TIFF *tif, TIFFLayout &layout)
+    {
+        TIFFPage &first = layout;
+        
+        ASSERT((getTIFFPage(tif, first)==RES_OK), "Bad TIFF image size", RES_ERR_IO);
+        
+        layout.pages.clear();
+        layout.pages.push_back(first);
+        
+        while (TIFFReadDirectory(tif))
+        {
+            TIFFPage page;
+            if (getTIFFPage(tif, page)==RES_OK && page.isSliceOf(first))
+              layout.pages.push_back(page);
+        }
+        
+        return RES_OK;
+    }
+    
+    static RES_T getTIFFLayout(const char *filename, TIFFLayout &layout)
     {
-        /* open image file */
         TIFF *tif=TIFFOpen(filename, "r");
         
         if (!tif)
@@ -70,21 +158,24 @@ namespace smil
             return RES_ERR_IO;
         }
         
-        uint32 w, h;
-        uint16 nbits, nsamples;
-        
-        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
-        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
-        TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &nbits);
-        TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &nsamples);
-
+        RES_T res = getTIFFLayout(tif, layout);
         TIFFClose(tif);
         
-        fInfo.width = w;
-        fInfo.height = h;
-        fInfo.channels = nsamples;
+        return res;
+    }
+  
+    RES_T getTIFFFileInfo(const char* filename, ImageFileInfo &fInfo)
+    {
+        TIFFLayout layout;
         
-        switch(nbits)
+        ASSERT((getTIFFLayout(filename, layout)==RES_OK), RES_ERR_IO);
+        
+        fInfo.width = layout.width;
+        fInfo.height = layout.height;
+        fInfo.depth = layout.getPageCount();
+        fInfo.channels = layout.nsamples;
+        
+        switch(layout.nbits)
         {
           case 8:
             fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UINT8; break;
@@ -92,7 +183,7 @@ namespace smil
             fInfo.scalarType = ImageFileInfo::SCALAR_TYPE_UINT16; break;
         }
         
-        switch(nsamples)
+        switch(layout.nsamples)
         {
           case 1:
             fInfo.colorType = ImageFileInfo::COLOR_TYPE_GRAY; break;
@@ -106,56 +197,213 @@ namespace smil
         
         return RES_OK;
     }
-        
+    
+    // Copy between the interleaved TIFF buffers and the image lines
+    
     template <class T>
-    RES_T StandardTIFFRead(const char *filename, Image<T> &image)
+    struct TIFFPixelCodec
     {
-        /* open image file */
-        TIFF *tif=TIFFOpen(filename, "r");
+        static const UINT16 nbits = 8*sizeof(T);
+        static const UINT16 nsamples = 1;
         
-        if (!tif)
+        static void unpack(const UINT8 *buf, typename ImDtTypes<T>::lineType line, size_t x, size_t size)
         {
-            cout << "Cannot open file " << filename << endl;
-            return RES_ERR_IO;
+            memcpy(line + x, buf, size * sizeof(T));
         }
+        static void pack(const typename ImDtTypes<T>::lineType line, size_t x, size_t size, UINT8 *buf)
+        {
+            memcpy(buf, line + x, size * sizeof(T));
+        }
+    };
+    
+    template <>
+    struct TIFFPixelCodec<RGB>
+    {
+        static const UINT16 nbits = 8;
+        static const UINT16 nsamples = 3;
         
-        uint32 width, height;
-        uint16 nbits, nsamples;
+        static void unpack(const UINT8 *buf, ImDtTypes<RGB>::lineType line, size_t x, size_t size)
+        {
+            MultichannelArray<UINT8,3>::lineType *arrays = line.arrays;
+            for (size_t i=0;i<size;i++)
+              for (UINT n=0;n<3;n++)
+                arrays[n][x+i] = buf[3*i+n];
+        }
+        static void pack(const ImDtTypes<RGB>::lineType line, size_t x, size_t size, UINT8 *buf)
+        {
+            const MultichannelArray<UINT8,3>::lineType *arrays = line.arrays;
+            for (size_t i=0;i<size;i++)
+              for (UINT n=0;n<3;n++)
+                buf[3*i+n] = arrays[n][x+i];
+        }
+    };
+    
+    struct TIFFBlock
+    {
+        TIFFBlock(size_t _z, size_t _bx, size_t _by) : z(_z), bx(_bx), by(_by) {}
+        size_t z, bx, by;
+    };
+    
+    /**
+     * Decode the tiles (or strips) of the TIFF file intersecting the box
+     * starting at (x0,y0,z0) and of the size of imOut.
+     * 
+     * libtiff handles can't be shared between threads: each thread opens
+     * its own one and jumps directly to the page offsets found in the layout.
+     */
+    template <class T>
+    RES_T readTIFFBlocks(const char *filename, const TIFFLayout &layout, size_t x0, size_t y0, size_t z0, Image<T> &imOut)
+    {
+        typedef TIFFPixelCodec<T> codecType;
         
-        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
-        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
-        TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &nbits);
-        TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &nsamples);
+        size_t pixelSize = layout.nbits/8 * layout.nsamples;
+        size_t x1 = x0 + imOut.getWidth(), y1 = y0 + imOut.getHeight(), z1 = z0 + imOut.getDepth();
         
-        ASSERT(nbits==8*sizeof(T) && nsamples==1, "Bad image type", RES_ERR);
-        ASSERT((image.setSize(width, height)==RES_OK), RES_ERR_BAD_ALLOCATION);
+        // Tiles (or strips) of each page touching the region
+        vector<TIFFBlock> blocks;
+        for (size_t z=z0;z<z1;z++)
+        {
+            size_t bw = layout.pages[z].blockWidth, bh = layout.pages[z].blockHeight;
+            for (size_t by=y0/bh;by*bh<y1;by++)
+              for (size_t bx=x0/bw;bx*bw<x1;bx++)
+                blocks.push_back(TIFFBlock(z, bx, by));
+        }
+        size_t nBlocks = blocks.size();
+        
+        typename ImDtTypes<T>::volType slices = imOut.getSlices();
+        int nthreads = 1;
+#ifdef USE_OPEN_MP
+        nthreads = min<int>(Core::getInstance()->getNumberOfThreads(), nBlocks);
+#endif // USE_OPEN_MP
+        int errors = 0;
+        
+#ifdef USE_OPEN_MP
+#pragma omp parallel num_threads(nthreads)
+#endif // USE_OPEN_MP
+        {
+            TIFF *tif = TIFFOpen(filename, "r");
+            tmsize_t bufSize = 0;
+            UINT8 *buf = NULL;
+            size_t curPage = layout.getPageCount();
+            
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic)
+#endif // USE_OPEN_MP
+            for (long b=0;b<(long)nBlocks;b++)
+            {
+                size_t z = blocks[b].z, bx = blocks[b].bx, by = blocks[b].by;
+                const TIFFPage &page = layout.pages[z];
+                size_t bw = page.blockWidth, bh = page.blockHeight;
+                tmsize_t res = -1;
+                
+                // Tiles and strips may change from one page to the other
+                if (tif && z!=curPage)
+                {
+                    curPage = TIFFSetSubDirectory(tif, page.offset) ? z : layout.getPageCount();
+                    tmsize_t pageBufSize = page.tiled ? TIFFTileSize(tif) : TIFFStripSize(tif);
+                    if (curPage==z && pageBufSize>bufSize)
+                    {
+                        if (buf)
+                          _TIFFfree(buf);
+                        buf = (UINT8*) _TIFFmalloc(pageBufSize);
+                        bufSize = buf ? pageBufSize : 0;
+                    }
+                }
+                if (buf && z==curPage)
+                {
+                    if (page.tiled)
+                      res = TIFFReadEncodedTile(tif, TIFFComputeTile(tif, bx*bw, by*bh, 0, 0), buf, bufSize);
+                    else
+                      res = TIFFReadEncodedStrip(tif, TIFFComputeStrip(tif, by*bh, 0), buf, bufSize);
+                }
+                
+                // Intersection of the block with the region
+                size_t xs = max(bx*bw, x0), xe = min((bx+1)*bw, x1);
+                size_t ys = max(by*bh, y0), ye = min((by+1)*bh, y1);
+                
+                // The decoded data must cover all the rows to copy
+                if (res < tmsize_t((ye-by*bh)*bw*pixelSize))
+                {
+#ifdef USE_OPEN_MP
+#pragma omp atomic
+#endif // USE_OPEN_MP
+                    errors++;
+                    continue;
+                }
+                
+                for (size_t y=ys;y<ye;y++)
+                  codecType::unpack(buf + ((y-by*bh)*bw + xs-bx*bw)*pixelSize, slices[z-z0][y-y0], xs-x0, xe-xs);
+            }
+            
+            if (buf)
+              _TIFFfree(buf);
+            if (tif)
+              TIFFClose(tif);
+        }
         
-        typename ImDtTypes<T>::sliceType lines = image.getLines();
+        imOut.modified();
         
-        for (size_t j=0;j<height;j++)
-          TIFFReadScanline(tif, lines[j], j);
+        ASSERT(errors==0, "Error while decoding TIFF data", RES_ERR_IO);
         
-        image.modified();
+        return RES_OK;
+    }
+    
+    template <class T>
+    RES_T checkTIFFLayout(const TIFFLayout &layout)
+    {
+        typedef TIFFPixelCodec<T> codecType;
         
-        TIFFClose(tif);
+        ASSERT((layout.nbits==codecType::nbits && layout.nsamples==codecType::nsamples), "Bad image type", RES_ERR);
+        ASSERT(layout.nsamples==1 || layout.planar==PLANARCONFIG_CONTIG, "Separate color planes are not supported", RES_ERR);
         
         return RES_OK;
     }
     
-    RES_T TIFFImageFileHandler<UINT8>::read(const char *filename, Image<UINT8> &image)
+    template <class T>
+    RES_T TIFFRegionRead(const char *filename, size_t x0, size_t y0, size_t z0, Image<T> &imOut)
     {
-        return StandardTIFFRead(filename, image);
+        ASSERT_ALLOCATED(&imOut);
+        
+        TIFFLayout layout;
+        
+        ASSERT((getTIFFLayout(filename, layout)==RES_OK), RES_ERR_IO);
+        ASSERT((checkTIFFLayout<T>(layout)==RES_OK), RES_ERR);
+        ASSERT(x0+imOut.getWidth()<=layout.width && y0+imOut.getHeight()<=layout.height && z0+imOut.getDepth()<=layout.getPageCount(), 
+               "Region out of the image", RES_ERR);
+        
+        return readTIFFBlocks(filename, layout, x0, y0, z0, imOut);
     }
-
-    RES_T TIFFImageFileHandler<UINT16>::read(const char *filename, Image<UINT16> &image)
+    
+    template <class T>
+    RES_T StandardTIFFRead(const char *filename, Image<T> &image)
     {
-        return StandardTIFFRead(filename, image);
+        TIFFLayout layout;
+        
+        ASSERT((getTIFFLayout(filename, layout)==RES_OK), RES_ERR_IO);
+        ASSERT((checkTIFFLayout<T>(layout)==RES_OK), RES_ERR);
+        ASSERT((image.setSize(layout.width, layout.height, layout.getPageCount())==RES_OK), RES_ERR_BAD_ALLOCATION);
+        
+        return readTIFFBlocks(filename, layout, 0, 0, 0, image);
     }
-
-    RES_T TIFFImageFileHandler<RGB>::read(const char *filename, Image<RGB> &image)
+    
+    /**
+     * Write each slice as a page. The file is switched to BigTIFF when the
+     * pixel data doesn't fit in the 4GB addressable by classic TIFF.
+     */
+    template <class T>
+    RES_T StandardTIFFWrite(const Image<T> &image, const char *filename, size_t tileSize)
     {
+        typedef TIFFPixelCodec<T> codecType;
+        
+        ASSERT(tileSize%16==0, "TIFF tile size must be a multiple of 16", RES_ERR);
+        
+        size_t width = image.getWidth(), height = image.getHeight(), depth = image.getDepth();
+        UINT16 nsamples = codecType::nsamples, nbits = codecType::nbits;
+        size_t pixelSize = nbits/8 * nsamples;
+        UINT64 dataSize = UINT64(image.getPixelCount()) * pixelSize;
+        
         /* open image file */
-        TIFF *tif=TIFFOpen(filename, "r");
+        TIFF *tif=TIFFOpen(filename, dataSize>=(UINT64(1)<<32)-(UINT64(1)<<24) ? "w8" : "w");
         
         if (!tif)
         {
@@ -163,123 +411,123 @@ namespace smil
             return RES_ERR_IO;
         }
         
-        uint32 width, height;
-        uint16 nbits, nsamples;
-        
-        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
-        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
-        TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &nbits);
-        TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &nsamples);
-        
-        ASSERT(nbits==8 && nsamples==3, "Not a 24bit RGB image", RES_ERR);
-        ASSERT((image.setSize(width, height)==RES_OK), RES_ERR_BAD_ALLOCATION);
-        
-        Image<RGB>::sliceType lines = image.getLines();
-        MultichannelArray<UINT8,3>::lineType *arrays;
-        
-        UINT8* raster = (UINT8*) _TIFFmalloc(width * 3 *sizeof (UINT8));
+        // Strips of about 64kB
+        size_t bw = tileSize ? tileSize : width;
+        size_t bh = tileSize ? tileSize : max<size_t>(1, min<size_t>(height, 65536/(width*pixelSize)));
+        vector<UINT8> buf(bw*bh*pixelSize, 0);
+        typename ImDtTypes<T>::volType slices = image.getSlices();
+        bool ok = true;
         
-        for (size_t j=0;j<height;j++)
+        for (size_t z=0;z<depth && ok;z++)
         {
-            arrays = lines[j].arrays;
-            TIFFReadScanline(tif, raster, j);
-            for (size_t i=0;i<width;i++)
-              for (UINT n=0;n<3;n++)
-                arrays[n][i] = raster[3*i+n];
+            TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, UINT32(width));
+            TIFFSetField(tif, TIFFTAG_IMAGELENGTH, UINT32(height));
+            TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, nbits);
+            TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, nsamples);
+            
+            TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+            TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+            TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, nsamples==3 ? PHOTOMETRIC_RGB : PHOTOMETRIC_MINISWHITE);
+            
+            if (depth>1)
+            {
+                TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+                TIFFSetField(tif, TIFFTAG_PAGENUMBER, UINT16(z), UINT16(depth));
+            }
+            
+            if (tileSize)
+            {
+                TIFFSetField(tif, TIFFTAG_TILEWIDTH, UINT32(bw));
+                TIFFSetField(tif, TIFFTAG_TILELENGTH, UINT32(bh));
+            }
+            else
+              TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, UINT32(bh));
+            
+            for (size_t y0=0;y0<height && ok;y0+=bh)
+              for (size_t x0=0;x0<width && ok;x0+=bw)
+              {
+                  size_t w = min(bw, width-x0), h = min(bh, height-y0);
+                  
+                  // Padding of the border tiles
+                  if (tileSize && (w<bw || h<bh))
+                    memset(&buf[0], 0, buf.size());
+                  for (size_t y=0;y<h;y++)
+                    codecType::pack(slices[z][y0+y], x0, w, &buf[y*bw*pixelSize]);
+                  
+                  if (tileSize)
+                    ok = TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x0, y0, 0, 0), &buf[0], buf.size())>=0;
+                  else
+                    ok = TIFFWriteEncodedStrip(tif, TIFFComputeStrip(tif, y0, 0), &buf[0], h*bw*pixelSize)>=0;
+              }
+              
+            ok = ok && TIFFWriteDirectory(tif);
         }
         
-        _TIFFfree(raster);
         TIFFClose(tif);
         
-        image.modified();
+        ASSERT(ok, "Error while writing TIFF data", RES_ERR_IO);
         
         return RES_OK;
     }
+    
+    RES_T TIFFImageFileHandler<UINT8>::read(const char *filename, Image<UINT8> &image)
+    {
+        return StandardTIFFRead(filename, image);
+    }
 
-    template <class T>
-    RES_T StandardTIFFWrite(const Image<T> &image, const char *filename)
+    RES_T TIFFImageFileHandler<UINT16>::read(const char *filename, Image<UINT16> &image)
     {
-        /* open image file */
-        TIFF *tif=TIFFOpen(filename, "w");
-        
-        if (!tif)
-        {
-            cout << "Cannot open file " << filename << endl;
-            return RES_ERR_IO;
-        }
-        
-        uint32 width = image.getWidth(), height = image.getHeight();
-        uint16 nbits = 8*sizeof(T), nsamples = 1;
-        
-        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
-        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
-        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, nbits);
-        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, nsamples);
-        
-        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
-        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISWHITE);
-        
-        typename ImDtTypes<T>::sliceType lines = image.getLines();
-        
-        for (size_t j=0;j<height;j++)
-          TIFFWriteScanline(tif, lines[j], j);
-        
-        TIFFClose(tif);
-        
-        return RES_OK;
+        return StandardTIFFRead(filename, image);
     }
-    
+
+    RES_T TIFFImageFileHandler<RGB>::read(const char *filename, Image<RGB> &image)
+    {
+        return StandardTIFFRead(filename, image);
+    }
+
     RES_T TIFFImageFileHandler<UINT8>::write(const Image<UINT8> &image, const char *filename)
     {
-        return StandardTIFFWrite(image, filename);
+        return StandardTIFFWrite(image, filename, 0);
     }
     
     RES_T TIFFImageFileHandler<UINT16>::write(const Image<UINT16> &image, const char *filename)
     {
-        return StandardTIFFWrite(image, filename);
+        return StandardTIFFWrite(image, filename, 0);
     }
     
     RES_T TIFFImageFileHandler<RGB>::write(const Image<RGB> &image, const char *filename)
     {
-        /* open image file */
-        TIFF *tif=TIFFOpen(filename, "w");
-        
-        if (!tif)
-        {
-            cout << "Cannot open file " << filename << endl;
-            return RES_ERR_IO;
-        }
-        
-        uint32 width = image.getWidth(), height = image.getHeight();
-        
-        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
-        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
-        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
-        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 3);
-        
-        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
-        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-        
-        Image<RGB>::sliceType lines = image.getLines();
-        MultichannelArray<UINT8,3>::lineType *arrays;
-        
-        UINT8* raster = (UINT8*) _TIFFmalloc(width * 3 *sizeof (UINT8));
-        
-        for (size_t j=0;j<height;j++)
-        {
-            arrays = lines[j].arrays;
-            for (size_t i=0;i<width;i++)
-              for (UINT n=0;n<3;n++)
-                raster[3*i+n] = arrays[n][i];
-            TIFFWriteScanline(tif, raster, j);
-        }
-        
-        _TIFFfree(raster);
-        TIFFClose(tif);
-        
-        return RES_OK;
+        return StandardTIFFWrite(image, filename, 0);
+    }
+    
+    RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0, Image<UINT8> &imOut)
+    {
+        return TIFFRegionRead(filename, x0, y0, z0, imOut);
+    }
+    
+    RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0, Image<UINT16> &imOut)
+    {
+        return TIFFRegionRead(filename, x0, y0, z0, imOut);
+    }
+    
+    RES_T readTIFFRegion(const char *filename, size_t x0, size_t y0, size_t z0, Image<RGB> &imOut)
+    {
+        return TIFFRegionRead(filename, x0, y0, z0, imOut);
+    }
+    
+    RES_T writeTIFF(const Image<UINT8> &image, const char *filename, size_t tileSize)
+    {
+        return StandardTIFFWrite(image, filename, tileSize);
+    }
+    
+    RES_T writeTIFF(const Image<UINT16> &image, const char *filename, size_t tileSize)
+    {
+        return StandardTIFFWrite(image, filename, tileSize);
+    }
+    
+    RES_T writeTIFF(const Image<RGB> &image, const char *filename, size_t tileSize)
+    {
+        return StandardTIFFWrite(image, filename, tileSize);
     }
 
 } // namespace smil
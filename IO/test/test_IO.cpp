@@ -29,6 +29,9 @@
 
 #include "Core/include/DCore.h"
 #include "IO/include/private/DImageIO_RAW.hpp"
+#include "IO/include/private/DImageIO_MMAP.hpp"
+#include "IO/include/private/DImageIO_SMV.hpp"
+#include "Base/include/private/DImageTransform.hpp"
 
 #ifdef SMIL_WRAP_RGB
 #include "NSTypes/RGB/include/DRGB.h"
@@ -36,6 +39,10 @@
 
 #include "Smil-build.h"
 
+#ifdef USE_TIFF
+#include <tiffio.h>
+#endif // USE_TIFF
+
 using namespace smil;
 
 class Test_RW_RAW : public TestCase
@@ -122,6 +129,104 @@ class Test_RW_TIFF : public TestCase
     delete im3;
   }
 };
+
+class Test_RW_TIFF_Volume : public TestCase
+{
+  virtual void run()
+  {
+    const char *fName = "_smil_io_tmp.tiff";
+    Image<UINT16> im1(70, 50, 13);
+    UINT16 *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = UINT16((i * 2654435761U) >> 9);
+
+    // Strips, then 16x16 tiles (partial tiles on the borders)
+    for (size_t tileSize = 0; tileSize <= 16; tileSize += 16) {
+      TEST_ASSERT(writeTIFF(im1, fName, tileSize) == RES_OK);
+      Image<UINT16> im2;
+      TEST_ASSERT(read(fName, im2) == RES_OK);
+      TEST_ASSERT(im1 == im2);
+
+      ImageFileInfo fInfo;
+      TEST_ASSERT(getFileInfo(fName, fInfo) == RES_OK);
+      TEST_ASSERT(fInfo.width == 70 && fInfo.height == 50 && fInfo.depth == 13);
+
+      Image<UINT16> imRegion(21, 17, 5), imTruth(imRegion);
+      TEST_ASSERT(readTIFFRegion(fName, 40, 10, 4, imRegion) == RES_OK);
+      TEST_ASSERT(crop(im1, 40, 10, 4, 21, 17, 5, imTruth) == RES_OK);
+      TEST_ASSERT(imRegion == imTruth);
+      TEST_ASSERT(readTIFFRegion(fName, 60, 10, 4, imRegion) != RES_OK);
+    }
+
+    // Wrong pixel type
+    Image<UINT8> im3;
+    TEST_ASSERT(read(fName, im3) != RES_OK);
+  }
+};
+
+class Test_Read_TIFF_Mixed_Pages : public TestCase
+{
+  virtual void run()
+  {
+    const char *fName = "_smil_io_tmp.tiff";
+    size_t w = 70, h = 50;
+    Image<UINT8> im1(w, h, 3);
+    UINT8 *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = UINT8((i * 2654435761U) >> 11);
+
+    // Strips of 7 rows, 16x32 tiles, then a single strip
+    size_t tileWidth[]   = {0, 16, 0};
+    size_t blockHeight[] = {7, 32, 50};
+
+    TIFF *tif = TIFFOpen(fName, "w");
+    TEST_ASSERT(tif != NULL);
+    if (!tif)
+      return;
+    for (size_t z = 0; z < 3; z++) {
+      TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, UINT32(w));
+      TIFFSetField(tif, TIFFTAG_IMAGELENGTH, UINT32(h));
+      TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+      TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+      TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+      TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+      TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+
+      size_t bw = tileWidth[z] ? tileWidth[z] : w, bh = blockHeight[z];
+      if (tileWidth[z]) {
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, UINT32(bw));
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, UINT32(bh));
+      } else
+        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, UINT32(bh));
+
+      for (size_t y0 = 0; y0 < h; y0 += bh)
+        for (size_t x0 = 0; x0 < w; x0 += bw) {
+          vector<UINT8> buf(bw * bh, 0);
+          size_t rows = min(bh, h - y0);
+          for (size_t y = 0; y < rows; y++)
+            for (size_t x = x0; x < min(x0 + bw, w); x++)
+              buf[y * bw + x - x0] = im1.getPixel(x, y0 + y, z);
+          if (tileWidth[z])
+            TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x0, y0, 0, 0),
+                                 &buf[0], buf.size());
+          else
+            TIFFWriteEncodedStrip(tif, TIFFComputeStrip(tif, y0, 0), &buf[0],
+                                  rows * bw);
+        }
+      TIFFWriteDirectory(tif);
+    }
+    TIFFClose(tif);
+
+    Image<UINT8> im2;
+    TEST_ASSERT(read(fName, im2) == RES_OK);
+    TEST_ASSERT(im1 == im2);
+
+    Image<UINT8> imRegion(21, 17, 3), imTruth(imRegion);
+    TEST_ASSERT(readTIFFRegion(fName, 40, 30, 0, imRegion) == RES_OK);
+    TEST_ASSERT(crop(im1, 40, 30, 0, 21, 17, 3, imTruth) == RES_OK);
+    TEST_ASSERT(imRegion == imTruth);
+  }
+};
 #endif // USE_TIFF
 
 // TODO: Test JPEG format
@@ -162,11 +267,163 @@ class Test_RW_BMP : public TestCase
   }
 };
 
+class Test_MMap_RAW : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT16 T;
+    const char *fName = "_smil_io_tmp_mmap.raw";
+
+    Image<T> im1(5, 4, 3);
+    T *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = T(i * 1000);
+    TEST_ASSERT(writeRAW(im1, fName) == RES_OK);
+
+    MappedImage<T> im2;
+    TEST_ASSERT(mmapImage(fName, 5, 4, 3, im2) == RES_OK);
+    TEST_ASSERT(im2.isMapped() && im2.isReadOnly());
+    TEST_ASSERT(im1 == im2);
+
+    // Sub-volume starting at the second slice
+    TEST_ASSERT(mmapImage(fName, 5, 4, 2, im2, false, 20 * sizeof(T)) ==
+                RES_OK);
+    TEST_ASSERT(im2.getPixel(0, 0, 0) == im1.getPixel(0, 0, 1));
+
+    // Copy-on-write: changes don't reach the file
+    TEST_ASSERT(mmapImage(fName, 5, 4, 3, im2, true) == RES_OK);
+    fill(im2, T(7));
+    TEST_ASSERT(im2.getPixel(4, 3, 2) == 7);
+    Image<T> im3;
+    TEST_ASSERT(readRAW(fName, 5, 4, 3, im3) == RES_OK);
+    TEST_ASSERT(im1 == im3);
+
+    // The file is too small
+    TEST_ASSERT(mmapImage(fName, 5, 4, 4, im2) != RES_OK);
+    TEST_ASSERT(!im2.isMapped());
+
+    im2.unmap();
+    TEST_ASSERT(!im2.isAllocated());
+  }
+};
+
+class Test_RW_SMV : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT16 T;
+    const char *fName = "_smil_io_tmp.smv";
+
+    // Flat areas (run-length encoded) and noise (stored as is)
+    Image<T> im1(70, 50, 33);
+    T *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = i < 40000 ? T(i / 5000) : T((i * 2654435761U) >> 7);
+
+    TEST_ASSERT(writeSMV(im1, fName, 16) == RES_OK);
+    Image<T> im2;
+    TEST_ASSERT(read(fName, im2) == RES_OK);
+    TEST_ASSERT(im1 == im2);
+
+    ImageFileInfo fInfo;
+    TEST_ASSERT(getFileInfo(fName, fInfo) == RES_OK);
+    TEST_ASSERT(fInfo.width == 70 && fInfo.height == 50 && fInfo.depth == 33);
+    TEST_ASSERT(fInfo.scalarType == ImageFileInfo::SCALAR_TYPE_UINT16);
+
+    // Sub-block across several chunks
+    Image<T> imRegion(21, 17, 9), imTruth(imRegion);
+    TEST_ASSERT(readSMVRegion(fName, 40, 10, 12, imRegion) == RES_OK);
+    TEST_ASSERT(crop(im1, 40, 10, 12, 21, 17, 9, imTruth) == RES_OK);
+    TEST_ASSERT(imRegion == imTruth);
+    TEST_ASSERT(readSMVRegion(fName, 60, 10, 12, imRegion) != RES_OK);
+
+    // Wrong pixel type
+    Image<UINT8> im3;
+    TEST_ASSERT(read(fName, im3) != RES_OK);
+
+    // Default chunks, 2D image
+    Image<UINT8> im4(300, 200), im5;
+    fill(im4, UINT8(3));
+    TEST_ASSERT(write(im4, fName) == RES_OK);
+    TEST_ASSERT(read(fName, im5) == RES_OK);
+    TEST_ASSERT(im4 == im5);
+    BaseImage *im6 = createFromFile(fName);
+    TEST_ASSERT(im6 != NULL);
+    delete im6;
+
+    // 32 bit images can be opened without knowing their type
+    Image<UINT32> im7(40, 30, 5);
+    for (size_t i = 0; i < im7.getPixelCount(); i++)
+      im7.getPixels()[i] = UINT32(i < 3000 ? 70000 : i * 2654435761U);
+    TEST_ASSERT(writeSMV(im7, fName, 16) == RES_OK);
+    TEST_ASSERT(getFileInfo(fName, fInfo) == RES_OK);
+    TEST_ASSERT(fInfo.scalarType == ImageFileInfo::SCALAR_TYPE_UINT32);
+    BaseImage *im8 = createFromFile(fName);
+    TEST_ASSERT(im8 != NULL && im8->getTypeAsString() == string("UINT32"));
+    if (im8)
+      TEST_ASSERT(*static_cast<Image<UINT32> *>(im8) == im7);
+    delete im8;
+
+    // Floating point values are kept bit for bit (-0. isn't 0.)
+    Image<float> im9(64, 16), im10;
+    for (size_t i = 0; i < im9.getPixelCount(); i++)
+      im9.getPixels()[i] = (i / 7) % 2 ? -0.f : 0.f;
+    TEST_ASSERT(writeSMV(im9, fName) == RES_OK);
+    TEST_ASSERT(read(fName, im10) == RES_OK);
+    TEST_ASSERT(im10.getPixelCount() == im9.getPixelCount());
+    TEST_ASSERT(memcmp(im9.getPixels(), im10.getPixels(),
+                       im9.getPixelCount() * sizeof(float)) == 0);
+  }
+};
+
+class Test_RW_Stack : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT8 T;
+    size_t w = 37, h = 23, d = 9;
+
+    Image<T> im1(w, h, d);
+    T *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = T((i * 7) % 251);
+
+    vector<string> fileList;
+    for (size_t z = 0; z < d; z++) {
+      ostringstream os;
+      os << "_smil_io_tmp_stack" << z << ".bmp";
+      fileList.push_back(os.str());
+    }
+    TEST_ASSERT(write(im1, fileList) == RES_OK);
+
+    Image<T> im2;
+    TEST_ASSERT(read(fileList, im2) == RES_OK);
+    TEST_ASSERT(im1 == im2);
+
+    // A smaller slice is padded with zeros
+    Image<T> imSmall(w / 2, h / 2);
+    fill(imSmall, T(255));
+    TEST_ASSERT(write(imSmall, fileList[3].c_str()) == RES_OK);
+    TEST_ASSERT(read(fileList, im2) == RES_OK);
+    Image<T> im3(im1, true);
+    for (size_t y = 0; y < h; y++)
+      for (size_t x = 0; x < w; x++)
+        im3.setPixel(x, y, 3, (x < w / 2 && y < h / 2) ? T(255) : T(0));
+    TEST_ASSERT(im3 == im2);
+
+    // Missing files are reported
+    fileList.push_back("_smil_io_tmp_missing.bmp");
+    TEST_ASSERT(read(fileList, im2) != RES_OK);
+    TEST_ASSERT(write(im1, fileList) != RES_OK);
+  }
+};
+
 int main(void)
 {
   TestSuite ts;
 
   ADD_TEST(ts, Test_RW_RAW);
+  ADD_TEST(ts, Test_MMap_RAW);
 #ifdef USE_PNG
   ADD_TEST(ts, Test_RW_PNG);
 #ifdef USE_CURL
@@ -175,9 +432,13 @@ int main(void)
 #endif // USE_PNG
 #ifdef USE_TIFF
   ADD_TEST(ts, Test_RW_TIFF);
+  ADD_TEST(ts, Test_RW_TIFF_Volume);
+  ADD_TEST(ts, Test_Read_TIFF_Mixed_Pages);
 #endif // USE_TIFF
   ADD_TEST(ts, Test_RW_PGM);
   ADD_TEST(ts, Test_RW_BMP);
+  ADD_TEST(ts, Test_RW_SMV);
+  ADD_TEST(ts, Test_RW_Stack);
 
   return ts.run();
 }
@@ -63,11 +63,43 @@ class Test_VTK_RW : public TestCase
   }
 };
 
+class Test_VTK_MMap : public TestCase
+{
+  virtual void run()
+  {
+    typedef UINT8 T;
+    const char *fName = "_smil_io_tmp_mmap.vtk";
+
+    Image<T> im1(7, 5, 3);
+    T *pixels = im1.getPixels();
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      pixels[i] = T(i);
+    TEST_ASSERT( write(im1, fName)==RES_OK );
+
+    MappedImage<T> im2;
+    TEST_ASSERT( mmapImage(fName, im2)==RES_OK );
+    TEST_ASSERT( im2.getWidth()==7 && im2.getHeight()==5 && im2.getDepth()==3 );
+
+    // Lines are in file order
+    bool same = true;
+    for (size_t z = 0; z < 3; z++)
+      for (size_t y = 0; y < 5; y++)
+        for (size_t x = 0; x < 7; x++)
+          same = same && im2.getPixel(x, y, z)==im1.getPixel(x, 4 - y, z);
+    TEST_ASSERT(same);
+
+    // Wrong scalar type
+    MappedImage<UINT16> im3;
+    TEST_ASSERT( mmapImage(fName, im3)!=RES_OK );
+  }
+};
+
 int main(void)
 {
       TestSuite ts;
 
       ADD_TEST(ts, Test_VTK_RW);
+      ADD_TEST(ts, Test_VTK_MMap);
       
 //       createFromFile("/home/faessel/src/divers/2012-MSME/tmp.vtk");
       
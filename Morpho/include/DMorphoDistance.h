@@ -54,12 +54,46 @@ namespace smil
 
   /**
    * @brief distanceEuclidean() - Euclidean distance function.
+   *
+   * Exact @b squared Euclidean distance of each pixel to the nearest pixel of
+   * value zero in @b imIn. Values which don't fit in the output type are
+   * saturated, so output images of types @b UINT32 or @b float are preferred.
+   *
    * @param[in] imIn : Binary input image
    * @param[out] imOut : Output image
    */
   template <class T1, class T2>
   RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut);
 
+  /**
+   * @brief distanceEuclidean() - Euclidean distance function with anisotropic
+   * pixel spacing (e.g. CT volumes with thicker slices).
+   *
+   * @param[in] imIn : Binary input image
+   * @param[out] imOut : Output image (squared distances in the spacing unit)
+   * @param[in] sx, sy, sz : Pixel size along each axis
+   */
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut, double sx,
+                          double sy, double sz = 1.);
+
+  /**
+   * @brief featureTransform() - Euclidean distance function and feature
+   * transform.
+   *
+   * Same squared distance as distanceEuclidean(), computed in the same pass
+   * as the offset of the nearest pixel of value zero in @b imIn. Pixels of
+   * value zero are their own nearest pixel. If @b imIn has no pixel of value
+   * zero, offsets are set to the maximum value of their type.
+   *
+   * @param[in] imIn : Binary input image
+   * @param[out] imOut : Output image
+   * @param[out] imNearest : Offset of the nearest pixel of value zero
+   */
+  template <class T1, class T2, class T3>
+  RES_T featureTransform(const Image<T1> &imIn, Image<T2> &imOut,
+                         Image<T3> &imNearest);
+
   /** @cond */
   template <class T1, class T2>
   RES_T dist_euclidean(const Image<T1> &imIn, Image<T2> &imOut);
@@ -58,6 +58,8 @@ namespace smil
     SE_Rhombicuboctahedron
   };
 
+  class StrEltDecomposition;
+
   /**
    * Base structuring element
    */
@@ -269,6 +271,20 @@ namespace smil
      */
     StrElt noCenter() const;
 
+    /**
+     * decompose() - Decompose the SE, iterated @b size times, into a chain of
+     * line segments and elementary SEs
+     *
+     * Decompositions are available for the @TB{Horiz}, @TB{Vert}, @TB{Squ},
+     * @TB{Hex}, @TB{Cross}, @TB{Cube}, @TB{Cross3D} and
+     * @TB{Rhombicuboctahedron} types. The points of the SE are ignored, as
+     * when it is processed by morphological operators.
+     *
+     * @param[out] decomp : the decomposition
+     * @returns @b true if the SE type can be decomposed, @b false otherwise
+     */
+    bool decompose(StrEltDecomposition &decomp) const;
+
     /**
      * getType() - Get the type of the structuring element
      *
@@ -590,6 +606,80 @@ namespace smil
     }
   };
 
+  /**
+   * Line segment of a structuring element decomposition.
+   *
+   * The segment is made of the points <b>k.step</b>, with @b k in
+   * <b>[kMin, kMax]</b>.
+   *
+   * On an hexagonal grid, a step with a vertical component follows the grid:
+   * @b step.x only gives the side of the move (1: right, -1: left) and the
+   * actual horizontal shift depends on the parity of the line.
+   */
+  class StrEltSegment
+  {
+  public:
+    StrEltSegment(const IntPoint &_step = IntPoint(1, 0, 0), int _kMin = 0,
+                  int _kMax = 0)
+        : step(_step), kMin(_kMin), kMax(_kMax)
+    {
+    }
+
+    /**
+     * isAxisAligned() - Check if the segment is a (non periodic) segment
+     * along one of the image axes
+     */
+    bool isAxisAligned() const;
+
+    /**
+     * isSymmetric() - Check if the segment is centered on the origin
+     */
+    bool isSymmetric() const
+    {
+      return kMin == -kMax;
+    }
+
+    IntPoint step;
+    int kMin;
+    int kMax;
+  };
+
+  /**
+   * Decomposition of a sized structuring element.
+   *
+   * The SE iterated @b size times is the Minkowski sum of the @b segments and
+   * of the @b elementarySEs (each one being applied once). Segments are
+   * processed at a constant or logarithmic cost w.r.t. their length: a
+   * dilation by a @TB{HexSE(40)} boils down to 3 segments of size 20 (5 line
+   * passes each) instead of 40 hexagonal dilations.
+   *
+   * @see StrElt::decompose()
+   */
+  class StrEltDecomposition
+  {
+  public:
+    StrEltDecomposition() : odd(false)
+    {
+    }
+
+    /**
+     * hasObliqueSegments() - Check if one of the segments is not aligned with
+     * the image axes
+     */
+    bool hasObliqueSegments() const;
+
+    /**
+     * getExtent() - Get the maximal distance, along each axis, between the
+     * origin and a point of the decomposed SE
+     */
+    IntPoint getExtent() const;
+
+    //! Grid of the segments (hexagonal if true)
+    bool odd;
+    vector<StrEltSegment> segments;
+    vector<StrElt> elementarySEs;
+  };
+
   // Shortcuts
   /** @cond */
   /* Only available inside C++ programs */
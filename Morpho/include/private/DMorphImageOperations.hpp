@@ -31,6 +31,7 @@
 #define _MORPH_IMAGE_OPERATIONS_HPP
 
 #include "Core/include/DCore.h"
+#include "Base/include/private/DLineArith.hpp"
 #include "Morpho/include/DStructuringElement.h"
 #include "Morpho/include/DMorphoInstance.h"
 
@@ -127,8 +128,143 @@ namespace smil
     };
 
 
+    /**
+     * Neighbourhood operator engine.
+     * 
+     * Non-virtual (CRTP) counterpart of MorphImageFunctionBase: the derived 
+     * class @b derivedT provides
+     * @code
+     * inline void processPixel(size_t pointOffset, const vector<int> &dOffsets);
+     * @endcode
+     * where @b dOffsets are the offsets (relative to @b pointOffset) of the SE
+     * points inside the image. It may also override processRun() to process
+     * at once a run of consecutive pixels whose neighbourhoods are entirely
+     * inside the image (for example with vectorizable loops).
+     * 
+     * The border-clipped offset tables are computed once for each class of
+     * lines (lines with the same neighbour lines inside the image) and the 
+     * lines are processed in parallel: processPixel and processRun must be 
+     * thread safe.
+     */
+#ifndef SWIG
+    template <class T_in, class T_out, class derivedT>
+    class MorphNeighborhoodFunction
+    {
+    public:
+        typedef Image<T_in> imageInType;
+        typedef typename ImDtTypes<T_in>::lineType lineInType;
+        typedef Image<T_out> imageOutType;
+        typedef typename ImDtTypes<T_out>::lineType lineOutType;
+        
+        MorphNeighborhoodFunction()
+          : pixelsIn(NULL),
+            pixelsOut(NULL)
+        {
+        }
+        
+        RES_T operator()(const imageInType &imIn, imageOutType &imOut, const StrElt &se=DEFAULT_SE) 
+        { 
+            return this->_exec(imIn, imOut, se); 
+        }
+        
+        RES_T _exec(const imageInType &imIn, imageOutType &imOut, const StrElt &se);
+        
+        // Run of len pixels whose SE points are all inside the image
+        inline void processRun(size_t pointOffset, size_t len, const vector<int> &dOffsets)
+        {
+            for (size_t i=0;i<len;i++)
+              static_cast<derivedT*>(this)->processPixel(pointOffset+i, dOffsets);
+        }
+        
+    protected:
+        // Offset tables shared by the lines with the same neighbour lines
+        struct LineClass
+        {
+            // Pixels [xBegin,xEnd) have all their neighbours inside the image
+            size_t xBegin, xEnd;
+            vector<int> offsets;
+            // Clipped offsets of the pixels [0,xBegin) and [xEnd,width)
+            vector< vector<int> > borderOffsets;
+        };
+        
+        void buildLineClasses(const StrElt &se);
+        void processLine(size_t lineIndex);
+        
+        size_t imSize[3];
+        lineInType pixelsIn;
+        lineOutType pixelsOut;
+        
+        vector<LineClass> lineClasses;
+        vector<int> lineClassIndex;
+    };
+#endif // SWIG
+
+
 
 
+    /**
+     * Scalar counterpart of the line function used by the van Herk/Gil-Werman
+     * kernels, which need a per-pixel operator along the image lines.
+     * 
+     * Only supLine and infLine are @b enabled: other line functions (arrows,
+     * ...) always go through the classical iterated implementation.
+     */
+    template <class T, class lineFunction_T>
+    struct vHGWOperator
+    {
+        static const bool enabled = false;
+        static inline T apply(const T &a, const T &/*b*/) { return a; }
+    };
+    
+    template <class T>
+    struct vHGWOperator<T, supLine<T> >
+    {
+        static const bool enabled = true;
+        static inline T apply(const T &a, const T &b) { return a > b ? a : b; }
+    };
+    
+    template <class T>
+    struct vHGWOperator<T, infLine<T> >
+    {
+        static const bool enabled = true;
+        static inline T apply(const T &a, const T &b) { return a < b ? a : b; }
+    };
+    
+    /**
+     * Minimal SE size from which MorphImageFunction switches to the van 
+     * Herk/Gil-Werman kernels for segment, square and cube SEs.
+     */
+    #define VHGW_MIN_SE_SIZE 2
+    
+    /**
+     * Minimal radius from which horizontal segments use the van Herk/Gil-Werman
+     * kernel. Below, logarithmic decompositions of vectorized line operations
+     * are faster.
+     */
+    #define VHGW_MIN_HORIZ_RADIUS 512
+    
+    /**
+     * Minimal CrossSE and HexSE sizes from which they are decomposed into 
+     * oblique segments. These decompositions work on a padded copy of the
+     * image and only pay off for larger sizes.
+     */
+    #define VHGW_MIN_CROSS_SE_SIZE 16
+    #define VHGW_MIN_HEX_SE_SIZE 24
+    
+    /**
+     * Cache size targeted by the blocked kernels (van Herk/Gil-Werman strips,
+     * tiles of generic SEs).
+     */
+    #define MORPH_CACHE_SIZE (256*1024)
+    
+    /**
+     * Maximal number of lines and slices of the tiles used to process generic
+     * SEs. The tile width is then chosen so that its source lines fit in
+     * MORPH_CACHE_SIZE.
+     */
+    #define GENERIC_TILE_HEIGHT 32
+    #define GENERIC_TILE_DEPTH 8
+
     template <class T_in, class lineFunction_T, class T_out=T_in, bool Enable=IS_SAME(T_in, T_out) >
     class MorphImageFunction : public MorphImageFunctionBase<T_in, T_out>
     {
@@ -259,6 +395,68 @@ namespace smil
         virtual RES_T _exec_single_cross_3d(const imageType &imIn, imageType &imOut);
         virtual RES_T _exec_single_depth_segment(const imageType &imIn, int zsize, imageType &imOut);                                 // Inplace safe
         virtual RES_T _exec_rhombicuboctahedron(const imageType &imIn, imageType &imOut, unsigned int size);                        // Inplace unsafe !!
+        
+        // van Herk/Gil-Werman kernels: cost independent of the SE size
+        static bool isVHGWCompatible(const StrElt &se);
+        virtual RES_T _exec_vhgw(const imageType &imIn, imageType &imOut, const StrElt &se);                                        // Inplace safe
+        virtual RES_T _exec_vhgw_horizontal_segment(const imageType &imIn, UINT radius, imageType &imOut);                        // Inplace safe
+        virtual RES_T _exec_vhgw_vertical_segment(const imageType &imIn, UINT radius, imageType &imOut);                          // Inplace safe
+        virtual RES_T _exec_vhgw_depth_segment(const imageType &imIn, UINT radius, imageType &imOut);                             // Inplace safe
+        
+        // SE decompositions (see StrElt::decompose)
+        virtual RES_T _exec_decomposition(const imageType &imIn, imageType &imOut, const StrEltDecomposition &decomp);            // Inplace safe
+        virtual RES_T _exec_segment(const imageType &imIn, const StrEltSegment &seg, bool odd, imageType &imOut);                 // Inplace safe (axis aligned segments only)
+        virtual RES_T _exec_single_segment_3points(const imageType &imIn, const IntPoint &step, int dist, bool odd, imageType &imOut); // Inplace unsafe !!
+        
+      protected:
+        void _exec_vhgw_lines(const lineType *srcLines, lineType *destLines, size_t lineNbr, UINT radius, size_t x0, size_t width, lineType *bufs);
+        size_t _vhgw_strip_width(UINT radius);
+        static vector<int> _log_segment_dists(int radius);
+        void _generic_tile_size(const imageType &imIn, const StrElt &se, int &tileW, int &tileH, int &tileD);
+        
+        // Pixels [x0,x0+len) of the line (y,z) translated by dx (see shiftLine).
+        // Points directly into the image when no border pixel is involved.
+        inline lineType _translated_strip(const volType srcSlices, int h, int d, int dx, int y, int z, int x0, int len, lineType buf)
+        {
+            if (z<0 || z>=d || y<0 || y>=h)
+              return this->borderBuf;
+            
+            int w = this->lineLen;
+            int start = x0 - dx;
+            lineType lineIn = srcSlices[z][y];
+            
+            if (start>=0 && start+len<=w)
+              return lineIn + start;
+            
+            int left = MIN(MAX(-start, 0), len);
+            int right = MIN(MAX(start+len-w, 0), len-left);
+            
+            fillLine<T_in>::fill(buf, left, this->borderValue);
+            copyLine<T_in>(lineIn + start + left, len-left-right, buf + left);
+            fillLine<T_in>::fill(buf + len-right, right, this->borderValue);
+            return buf;
+        }
+        
+        // Line e of the sequence padded with radius border lines on each side
+        inline lineType _vhgw_padded_line(const lineType *srcLines, size_t e, size_t lineNbr, UINT radius, size_t x0)
+        {
+            if (e<radius || e>=lineNbr+radius)
+              return this->borderBuf + x0;
+            return srcLines[e-radius] + x0;
+        }
+        
+        
+        // Horizontal move of dist segment steps starting from line (y,z)
+        static inline int _segment_shift(const IntPoint &step, bool odd, int y, int z, int dist)
+        {
+            if (!odd || step.y==0 || step.x==0)
+              return dist*step.x;
+            
+            // On hexagonal grids, a step to the right (resp. left) moves by one
+            // pixel when it starts from an odd (resp. even) line
+            int oddLines = dist/2 + (dist%2 && (y+z)%2);
+            return step.x>0 ? oddLines : -(dist-oddLines);
+        }
     };
     
 /** @} */
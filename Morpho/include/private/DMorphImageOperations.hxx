@@ -235,12 +235,7 @@ namespace smil
                 if (x>=0 && x<int(imSize[0]))
                 offsetList.push_back(relOffsetList[i]);
             }
-          #ifdef USE_OPEN_MP
-            #pragma omp critical
-          #endif // USE_OPEN_MP
-            {
-              processPixel(offset, offsetList);
-            }
+            processPixel(offset, offsetList);
             curPixel++;
             offset++;
         }
@@ -258,6 +253,138 @@ namespace smil
     }
     }
 
+    template <class T_in, class T_out, class derivedT>
+    RES_T MorphNeighborhoodFunction<T_in, T_out, derivedT>::_exec(const imageInType &imIn, imageOutType &imOut, const StrElt &se)
+    {
+        ASSERT_ALLOCATED(&imIn, &imOut)
+        ASSERT_SAME_SIZE(&imIn, &imOut)
+        
+        if ((void*)&imIn==(void*)&imOut)
+        {
+            Image<T_in> tmpIm(imIn, true); // clone
+            return _exec(tmpIm, imOut, se);
+        }
+        
+        ImageFreezer freeze(imOut);
+        
+        StrElt se2;
+        if (se.size>1)
+        se2 = se.homothety(se.size);
+        else se2 = se;
+        
+        imIn.getSize(imSize);
+        pixelsIn = imIn.getPixels();
+        pixelsOut = imOut.getPixels();
+        
+        buildLineClasses(se2);
+        
+        int lineNbr = imSize[1]*imSize[2];
+        int l;
+        
+    #ifdef USE_OPEN_MP
+        int nthreads = Core::getInstance()->getNumberOfThreads();
+        #pragma omp parallel for schedule(dynamic,16) num_threads(nthreads)
+    #endif // USE_OPEN_MP
+        for (l=0;l<lineNbr;l++)
+          processLine(l);
+        
+        return RES_OK;
+    }
+    
+    template <class T_in, class T_out, class derivedT>
+    void MorphNeighborhoodFunction<T_in, T_out, derivedT>::buildLineClasses(const StrElt &se)
+    {
+        int w = imSize[0];
+        int h = imSize[1];
+        int d = imSize[2];
+        
+        lineClasses.clear();
+        lineClassIndex.assign(h*d, 0);
+        
+        // Lines are identified by the (x, offset) pairs of their SE points
+        // inside the image
+        map<vector<int>, int> classKeys;
+        vector<int> key;
+        
+        for (int z=0;z<d;z++)
+          for (int y=0;y<h;y++)
+          {
+              bool oddLine = se.odd && y%2;
+              
+              key.clear();
+              for (vector<IntPoint>::const_iterator it=se.points.begin();it!=se.points.end();it++)
+              {
+                  int ny = y + it->y;
+                  int nz = z + it->z;
+                  if (ny<0 || ny>=h || nz<0 || nz>=d)
+                    continue;
+                  int x = it->x;
+                  if (oddLine && ((ny+1)%2)!=0)
+                    x += 1;
+                  key.push_back(x);
+                  key.push_back(x + it->y*w + it->z*w*h);
+              }
+              
+              map<vector<int>, int>::iterator found = classKeys.find(key);
+              if (found!=classKeys.end())
+              {
+                  lineClassIndex[y+z*h] = found->second;
+                  continue;
+              }
+              
+              int index = lineClasses.size();
+              classKeys[key] = index;
+              lineClassIndex[y+z*h] = index;
+              
+              lineClasses.push_back(LineClass());
+              LineClass &lc = lineClasses.back();
+              
+              int xmin = 0, xmax = 0;
+              for (size_t i=0;i<key.size();i+=2)
+              {
+                  xmin = MIN(xmin, key[i]);
+                  xmax = MAX(xmax, key[i]);
+                  lc.offsets.push_back(key[i+1]);
+              }
+              lc.xBegin = MIN(-xmin, w);
+              lc.xEnd = MAX(w-xmax, int(lc.xBegin));
+              
+              for (int x=0;x<w;x++)
+              {
+                  if (x==int(lc.xBegin))
+                    x = lc.xEnd;
+                  if (x>=w)
+                    break;
+                  
+                  vector<int> offsets;
+                  for (size_t i=0;i<key.size();i+=2)
+                    if (x+key[i]>=0 && x+key[i]<w)
+                      offsets.push_back(key[i+1]);
+                  lc.borderOffsets.push_back(offsets);
+              }
+          }
+    }
+    
+    template <class T_in, class T_out, class derivedT>
+    void MorphNeighborhoodFunction<T_in, T_out, derivedT>::processLine(size_t lineIndex)
+    {
+        const LineClass &lc = lineClasses[lineClassIndex[lineIndex]];
+        derivedT *derived = static_cast<derivedT*>(this);
+        
+        size_t offset = lineIndex*imSize[0];
+        typename vector< vector<int> >::const_iterator border = lc.borderOffsets.begin();
+        
+        for (size_t x=0;x<lc.xBegin;x++)
+          derived->processPixel(offset+x, *border++);
+        
+        if (lc.xEnd>lc.xBegin)
+          derived->processRun(offset+lc.xBegin, lc.xEnd-lc.xBegin, lc.offsets);
+        
+        for (size_t x=lc.xEnd;x<imSize[0];x++)
+          derived->processPixel(offset+x, *border++);
+    }
+    
+
 
     ///******************************************************************************
     ///******************************************************************************
@@ -356,6 +483,19 @@ namespace smil
         
         this->initialize(imIn, imOut, se);
         
+        // Large segments, squares, hexagons, ...: decomposed into segments
+        // processed at constant cost w.r.t. se.size
+        if (seSize>=VHGW_MIN_SE_SIZE && isVHGWCompatible(se))
+        {
+            ImageFreezer freezer(imOut);
+            
+            RES_T res = _exec_vhgw(imIn, imOut, se);
+            this->finalize(imIn, imOut, se);
+            
+            imOut.modified();
+            return res;
+        }
+        
         if (seType==SE_Rhombicuboctahedron) 
         {
             _exec_rhombicuboctahedron (imIn, imOut, se.size);
@@ -450,86 +590,138 @@ namespace smil
         if (sePtsNumber==0)
         return RES_OK;
         
-        int nSlices = imIn.getSliceCount();
-        int nLines = imIn.getHeight();
-
-        int nthreads = Core::getInstance()->getNumberOfThreads();
-        lineType *_bufs = this->createAlignedBuffers(2*nthreads, this->lineLen);
-        lineType tmpBuf = _bufs[0];
-        lineType tmpBuf2 = _bufs[nthreads];
-
+        int w, h, d;
+        imIn.getSize(&w, &h, &d);
+        
         const Image<T_in> *tmpIm;
         
         if (&imIn==&imOut)
           tmpIm = new Image<T_in>(imIn, true); // clone
         else tmpIm = &imIn;
         
-        //volType srcSlices = tmpIm->getSlices();
+        volType srcSlices = tmpIm->getSlices();
         volType destSlices = imOut.getSlices();
         
-        //lineInType *srcLines;
-        lineType *destLines, lineOut;
-        
         bool oddSe = se.odd; 
-        int oddLine = 0;
-
-        int l, p;
+        vector<IntPoint> pts = se.points;
+        
+        // The image is processed tile by tile. All the SE points are applied
+        // to a tile while its source lines (tile lines and halo) are in cache.
+        int tileW, tileH, tileD;
+        _generic_tile_size(imIn, se, tileW, tileH, tileD);
+        
+        int nTilesX = (w + tileW - 1) / tileW;
+        int nTilesY = (h + tileH - 1) / tileH;
+        int nTilesZ = (d + tileD - 1) / tileD;
+        int nTiles = nTilesX * nTilesY * nTilesZ;
+        
+        int nthreads = MIN(int(Core::getInstance()->getNumberOfThreads()), nTiles);
+        nthreads = MAX(nthreads, 1);
+        lineType *_bufs = this->createAlignedBuffers(2*nthreads, tileW);
+        lineType tmpBuf = _bufs[0];
+        lineType tmpBuf2 = _bufs[nthreads];
+        
+        int t;
     #ifdef USE_OPEN_MP
         int tid;
     #endif // USE_OPEN_MP
-        int x, y, z;
-        vector<IntPoint> pts = se.points;
-
-
-        for (int s=0;s<nSlices;s++)
-        {
-        destLines = destSlices[s];
 
     #ifdef USE_OPEN_MP
-        #pragma omp parallel private(tid,tmpBuf,tmpBuf2,x,y,z,lineOut,p) firstprivate(pts,oddLine) num_threads(nthreads)
+        #pragma omp parallel private(tid,tmpBuf,tmpBuf2) firstprivate(pts) num_threads(nthreads)
     #endif // USE_OPEN_MP
         {
           #ifdef USE_OPEN_MP
-        tid = omp_get_thread_num();
-        tmpBuf = _bufs[tid];
-        tmpBuf2 = _bufs[tid+nthreads];
-          #endif // _OPENMP
-          
-          
-          #ifdef USE_OPEN_MP
-        #pragma omp for
+            tid = omp_get_thread_num();
+            tmpBuf = _bufs[tid];
+            tmpBuf2 = _bufs[tid+nthreads];
           #endif // USE_OPEN_MP
-        for (l=0;l<nLines;l++)
-            {
-            if (oddSe)
-              oddLine = ((l+1)%2 && (s+1)%2);
-            z = s - pts[0].z;
-            y = l - pts[0].y;
-            x = pts[0].x + (oddLine && y%2);
-
-            this->_extract_translated_line(tmpIm, x, y, z, tmpBuf);
             
-            lineOut = destLines[l];
-            for (p=1;p<sePtsNumber;p++)
+          #ifdef USE_OPEN_MP
+            #pragma omp for schedule(dynamic)
+          #endif // USE_OPEN_MP
+            for (t=0;t<nTiles;t++)
             {
-                z = s - pts[p].z;
-                y = l - pts[p].y;
-                x = pts[p].x + (oddLine && y%2);
+                int x0 = (t % nTilesX) * tileW;
+                int y0 = ((t / nTilesX) % nTilesY) * tileH;
+                int z0 = (t / (nTilesX*nTilesY)) * tileD;
+                int len = MIN(tileW, w-x0);
+                int y1 = MIN(y0+tileH, h);
+                int z1 = MIN(z0+tileD, d);
                 
-                this->_extract_translated_line(tmpIm, x, y, z, tmpBuf2);
-                this->lineFunction._exec(tmpBuf, tmpBuf2, this->lineLen, tmpBuf);
-            }
-            
-            copyLine<T_in>(tmpBuf, this->lineLen, lineOut);
+                for (int z=z0;z<z1;z++)
+                  for (int y=y0;y<y1;y++)
+                  {
+                      int oddLine = oddSe && ((y+1)%2 && (z+1)%2);
+                      lineType lineOut = destSlices[z][y] + x0;
+                      lineType acc;
+                      int sy, sz;
+                      
+                      sz = z - pts[0].z;
+                      sy = y - pts[0].y;
+                      acc = _translated_strip(srcSlices, h, d, pts[0].x + (oddLine && sy%2), sy, sz, x0, len, tmpBuf);
+                      
+                      if (sePtsNumber==1)
+                        copyLine<T_in>(acc, len, lineOut);
+                      
+                      for (int p=1;p<sePtsNumber;p++)
+                      {
+                          sz = z - pts[p].z;
+                          sy = y - pts[p].y;
+                          lineType buf = _translated_strip(srcSlices, h, d, pts[p].x + (oddLine && sy%2), sy, sz, x0, len, tmpBuf2);
+                          
+                          // The last point writes directly into the output line
+                          lineType out = p<sePtsNumber-1 ? tmpBuf : lineOut;
+                          this->lineFunction._exec(acc, buf, len, out);
+                          acc = out;
+                      }
+                  }
             }
         }
-        }
     
         if (&imIn==&imOut)
           delete tmpIm;
         
         return RES_OK;
     }
+    
+    template <class T_in, class lineFunction_T>
+    void MorphImageFunction<T_in, lineFunction_T, T_in, true>::_generic_tile_size(const imageType &imIn, const StrElt &se, int &tileW, int &tileH, int &tileD)
+    {
+        int w = this->lineLen;
+        int h = imIn.getHeight();
+        int d = imIn.getDepth();
+        
+        int ymin = 0, ymax = 0, zmin = 0, zmax = 0;
+        for (vector<IntPoint>::const_iterator it=se.points.begin();it!=se.points.end();it++)
+        {
+            ymin = MIN(ymin, it->y);
+            ymax = MAX(ymax, it->y);
+            zmin = MIN(zmin, it->z);
+            zmax = MAX(zmax, it->z);
+        }
+        
+        tileH = MIN(h, GENERIC_TILE_HEIGHT);
+        tileD = MIN(d, GENERIC_TILE_DEPTH);
+        
+        // Shrink the tile until its source lines (with halo) fit in cache
+        // with a reasonable width
+        size_t simdLen = SIMD_VEC_SIZE / sizeof(T_in);
+        size_t width;
+        while (true)
+        {
+            size_t srcLineNbr = (tileH + ymax - ymin) * (tileD + zmax - zmin);
+            width = MORPH_CACHE_SIZE / (srcLineNbr * sizeof(T_in));
+            if (width>=MIN(size_t(w), 64*simdLen) || (tileH==1 && tileD==1))
+              break;
+            if (tileD>1)
+              tileD = (tileD+1) / 2;
+            else
+              tileH = (tileH+1) / 2;
+        }
+        
+        width = MAX(simdLen, (width / simdLen) * simdLen);
+        tileW = MIN(width, size_t(w));
+    }
 
 
     template <class T_in, class lineFunction_T>
@@ -1193,6 +1385,479 @@ namespace smil
         return RES_OK;
     }
 
+
+    ///******************************************************************************
+    ///  van Herk/Gil-Werman kernels
+    ///******************************************************************************
+    
+    template <class T_in, class lineFunction_T>
+    bool MorphImageFunction<T_in, lineFunction_T, T_in, true>::isVHGWCompatible(const StrElt &se)
+    {
+        if (!vHGWOperator<T_in, lineFunction_T>::enabled)
+          return false;
+        
+        switch(se.getType())
+        {
+          case SE_Horiz:
+          case SE_Vert:
+          case SE_Squ:
+          case SE_Cube:
+            return !se.odd;
+          case SE_Rhombicuboctahedron:
+            return true;
+          case SE_Hex:
+            return se.size>=VHGW_MIN_HEX_SE_SIZE;
+          case SE_Cross:
+            return se.size>=VHGW_MIN_CROSS_SE_SIZE;
+          default:
+            return false;
+        }
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_vhgw(const imageType &imIn, imageType &imOut, const StrElt &se)
+    {
+        StrEltDecomposition decomp;
+        
+        if (!se.decompose(decomp))
+          return RES_ERR_NOT_IMPLEMENTED;
+        
+        return _exec_decomposition(imIn, imOut, decomp);
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_decomposition(const imageType &imIn, imageType &imOut, const StrEltDecomposition &decomp)
+    {
+        // Oblique segments need the intermediate results outside of the
+        // image domain: work on a copy padded with the SE extent
+        IntPoint margin(0, 0, 0);
+        imageType *padIm = NULL;
+        
+        if (decomp.hasObliqueSegments())
+        {
+            margin = decomp.getExtent();
+            
+            // Keep the parity of the lines on hexagonal grids
+            if (decomp.odd)
+            {
+                margin.y += margin.y % 2;
+                margin.z += margin.z % 2;
+            }
+            
+            padIm = new imageType(imIn.getWidth()+2*margin.x, imIn.getHeight()+2*margin.y, imIn.getDepth()+2*margin.z);
+            fill(*padIm, this->borderValue);
+            copy(imIn, *padIm, margin.x, margin.y, margin.z);
+            
+            // Line buffers must fit the padded width
+            this->finalize(imIn, imOut, StrElt());
+            this->initialize(*padIm, *padIm, StrElt());
+        }
+        
+        imageType *target = padIm ? padIm : &imOut;
+        const imageType *src = padIm ? padIm : &imIn;
+        imageType *dest = target;
+        
+        // Passes which are not inplace safe alternate between two images
+        imageType *tmpIm = NULL;
+        imageType *altIm = NULL;
+        
+        RES_T res = RES_OK;
+        
+        for (vector<StrElt>::const_iterator it=decomp.elementarySEs.begin();it!=decomp.elementarySEs.end() && res==RES_OK;it++)
+        {
+            if (src==dest && !this->isInplaceSafe(*it))
+            {
+                if (!tmpIm)
+                  altIm = tmpIm = new imageType(*target);
+                swap(dest, altIm);
+            }
+            res = _exec_single(*src, *dest, *it);
+            src = dest;
+        }
+        
+        for (vector<StrEltSegment>::const_iterator it=decomp.segments.begin();it!=decomp.segments.end() && res==RES_OK;it++)
+        {
+            if (it->isAxisAligned())
+            {
+                res = _exec_segment(*src, *it, decomp.odd, *dest);
+                src = dest;
+                continue;
+            }
+            
+            vector<int> dists = _log_segment_dists(it->kMax);
+            for (size_t i=0;i<dists.size() && res==RES_OK;i++)
+            {
+                if (src==dest)
+                {
+                    if (!tmpIm)
+                      altIm = tmpIm = new imageType(*target);
+                    swap(dest, altIm);
+                }
+                res = _exec_single_segment_3points(*src, it->step, dists[i], decomp.odd, *dest);
+                src = dest;
+            }
+        }
+        
+        if (src!=target)
+          copy(*src, *target);
+        if (tmpIm)
+          delete tmpIm;
+        
+        if (padIm)
+        {
+            copy(*padIm, margin.x, margin.y, margin.z, imIn.getWidth(), imIn.getHeight(), imIn.getDepth(), imOut);
+            
+            this->finalize(*padIm, *padIm, StrElt());
+            this->initialize(imIn, imOut, StrElt());
+            delete padIm;
+        }
+        
+        return res;
+    }
+    
+    template <class T_in, class lineFunction_T>
+    vector<int> MorphImageFunction<T_in, lineFunction_T, T_in, true>::_log_segment_dists(int radius)
+    {
+        // Segment of radius r = sum of the 3 points segments of radius
+        // 1, 2, 4, ..., 2^(n-1) and r-(2^n-1)
+        vector<int> dists;
+        
+        for (int dist=1;radius>0;dist*=2)
+        {
+            dists.push_back(MIN(dist, radius));
+            radius -= dists.back();
+        }
+        return dists;
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_segment(const imageType &imIn, const StrEltSegment &seg, bool /*odd*/, imageType &imOut)
+    {
+        ASSERT(seg.isAxisAligned() && seg.isSymmetric(), RES_ERR_NOT_IMPLEMENTED);
+        
+        UINT radius = seg.kMax;
+        
+        if (radius==0)
+          return copy(imIn, imOut);
+        
+        if (seg.step.x)
+        {
+            if (radius>=VHGW_MIN_HORIZ_RADIUS)
+              return _exec_vhgw_horizontal_segment(imIn, radius, imOut);
+            
+            // Longer segments give the same result than one covering the line
+            vector<int> dists = _log_segment_dists(MIN(radius, this->lineLen));
+            const imageType *src = &imIn;
+            for (size_t i=0;i<dists.size();i++)
+            {
+                ASSERT(_exec_single_horizontal_segment(*src, dists[i], imOut)==RES_OK);
+                src = &imOut;
+            }
+            return RES_OK;
+        }
+        else if (seg.step.y)
+          return _exec_vhgw_vertical_segment(imIn, radius, imOut);
+        else
+          return _exec_vhgw_depth_segment(imIn, radius, imOut);
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_single_segment_3points(const imageType &imIn, const IntPoint &step, int dist, bool odd, imageType &imOut)
+    {
+        int w, h, d;
+        imIn.getSize(&w, &h, &d);
+
+        int nthreads = Core::getInstance()->getNumberOfThreads();
+        lineType *_bufs = this->createAlignedBuffers(2*nthreads, this->lineLen);
+        lineType buf1 = _bufs[0];
+        lineType buf2 = _bufs[nthreads];
+
+        volType srcSlices = imIn.getSlices();
+        volType destSlices = imOut.getSlices();
+
+        int dy = dist*step.y;
+        int dz = dist*step.z;
+        int lineCount = h*d;
+
+      #ifdef USE_OPEN_MP
+        int tid;
+      #endif // USE_OPEN_MP
+        int l;
+
+      #ifdef USE_OPEN_MP
+        #pragma omp parallel private(tid,buf1,buf2) num_threads(nthreads)
+      #endif // USE_OPEN_MP
+        {
+          #ifdef USE_OPEN_MP
+            tid = omp_get_thread_num();
+            buf1 = _bufs[tid];
+            buf2 = _bufs[tid+nthreads];
+          #endif // USE_OPEN_MP
+
+          #ifdef USE_OPEN_MP
+            #pragma omp for
+          #endif // USE_OPEN_MP
+            for (l=0;l<lineCount;l++)
+            {
+                int y = l % h;
+                int z = l / h;
+                int dx;
+
+                // p + dist.step
+                dx = _segment_shift(step, odd, y, z, dist);
+                if (y+dy<0 || y+dy>=h || z+dz<0 || z+dz>=d || abs(dx)>=w)
+                  copyLine<T_in>(this->borderBuf, this->lineLen, buf1);
+                else
+                  shiftLine<T_in>(srcSlices[z+dz][y+dy], -dx, this->lineLen, buf1, this->borderValue);
+                this->lineFunction(srcSlices[z][y], buf1, this->lineLen, buf2);
+
+                // p - dist.step
+                dx = _segment_shift(step, odd, y-dy, z-dz, dist);
+                if (y-dy<0 || y-dy>=h || z-dz<0 || z-dz>=d || abs(dx)>=w)
+                  copyLine<T_in>(this->borderBuf, this->lineLen, buf1);
+                else
+                  shiftLine<T_in>(srcSlices[z-dz][y-dy], dx, this->lineLen, buf1, this->borderValue);
+                this->lineFunction(buf2, buf1, this->lineLen, destSlices[z][y]);
+            }
+        }
+
+        return RES_OK;
+    }
+
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_vhgw_horizontal_segment(const imageType &imIn, UINT radius, imageType &imOut)
+    {
+        typedef vHGWOperator<T_in, lineFunction_T> opType;
+        
+        int lineCount = imIn.getLineCount();
+        size_t lineLen = this->lineLen;
+        size_t k = 2*radius + 1;
+        
+        // Padded line length (multiple of the segment length)
+        size_t extLen = ((lineLen + 2*radius + k - 1) / k) * k;
+        
+        int nthreads = Core::getInstance()->getNumberOfThreads();
+        lineType *_bufs = this->createAlignedBuffers(3*nthreads, extLen);
+        lineType f = _bufs[0];
+        lineType g = _bufs[nthreads];
+        lineType h = _bufs[2*nthreads];
+        
+        sliceType srcLines = imIn.getLines();
+        sliceType destLines = imOut.getLines();
+        
+        T_in borderValue = this->borderValue;
+        
+      #ifdef USE_OPEN_MP
+        int tid;
+      #endif // USE_OPEN_MP
+        int l;
+        
+      #ifdef USE_OPEN_MP
+        #pragma omp parallel private(tid,f,g,h) num_threads(nthreads)
+      #endif // USE_OPEN_MP
+        {
+          #ifdef USE_OPEN_MP
+            tid = omp_get_thread_num();
+            f = _bufs[tid];
+            g = _bufs[tid+nthreads];
+            h = _bufs[tid+2*nthreads];
+          #endif // USE_OPEN_MP
+            
+            // Borders never change
+            for (size_t i=0;i<radius;i++)
+              f[i] = borderValue;
+            for (size_t i=radius+lineLen;i<extLen;i++)
+              f[i] = borderValue;
+            
+          #ifdef USE_OPEN_MP
+            #pragma omp for
+          #endif // USE_OPEN_MP
+            for (l=0;l<lineCount;l++)
+            {
+                copyLine<T_in>(srcLines[l], lineLen, f+radius);
+                
+                // Forward (g) and backward (h) cumulative values inside each block
+                for (size_t b=0;b<extLen;b+=k)
+                {
+                    g[b] = f[b];
+                    for (size_t i=b+1;i<b+k;i++)
+                      g[i] = opType::apply(g[i-1], f[i]);
+                    
+                    h[b+k-1] = f[b+k-1];
+                    for (size_t i=b+k-1;i>b;i--)
+                      h[i-1] = opType::apply(f[i-1], h[i]);
+                }
+                
+                lineType lineOut = destLines[l];
+                for (size_t x=0;x<lineLen;x++)
+                  lineOut[x] = opType::apply(h[x], g[x+k-1]);
+            }
+        }
+        
+        return RES_OK;
+    }
+    
+    template <class T_in, class lineFunction_T>
+    size_t MorphImageFunction<T_in, lineFunction_T, T_in, true>::_vhgw_strip_width(UINT radius)
+    {
+        // Keep the 3 blocks of strip lines used by each thread in L2
+        size_t k = 2*radius + 1;
+        size_t simdLen = SIMD_VEC_SIZE / sizeof(T_in);
+        size_t width = MORPH_CACHE_SIZE / (3*k*sizeof(T_in));
+        
+        width = MAX(simdLen, (width / simdLen) * simdLen);
+        return MIN(width, this->lineLen);
+    }
+    
+    template <class T_in, class lineFunction_T>
+    void MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_vhgw_lines(const lineType *srcLines, lineType *destLines, size_t lineNbr, UINT radius, size_t x0, size_t width, lineType *bufs)
+    {
+        // Lines are processed block by block (blocks of k lines in the padded
+        // sequence). The next block is fully read before writing the output
+        // lines of the current one, which makes the process inplace safe.
+        size_t k = 2*radius + 1;
+        size_t extLen = lineNbr + 2*radius;
+        
+        lineType *h = bufs;
+        lineType *g = bufs + k;
+        lineType *hNext = bufs + 2*k;
+        
+        // Backward values of the first block
+        copyLine<T_in>(_vhgw_padded_line(srcLines, k-1, lineNbr, radius, x0), width, h[k-1]);
+        for (size_t i=k-1;i>0;i--)
+          lineFunction(_vhgw_padded_line(srcLines, i-1, lineNbr, radius, x0), h[i], width, h[i-1]);
+        
+        for (size_t s=0;s<lineNbr;s+=k)
+        {
+            size_t nNext = s+k<extLen ? MIN(k, extLen-s-k) : 0;
+            
+            if (nNext)
+            {
+                copyLine<T_in>(_vhgw_padded_line(srcLines, s+k, lineNbr, radius, x0), width, g[0]);
+                for (size_t i=1;i<nNext;i++)
+                  lineFunction(g[i-1], _vhgw_padded_line(srcLines, s+k+i, lineNbr, radius, x0), width, g[i]);
+                
+                copyLine<T_in>(_vhgw_padded_line(srcLines, s+k+nNext-1, lineNbr, radius, x0), width, hNext[nNext-1]);
+                for (size_t i=nNext-1;i>0;i--)
+                  lineFunction(_vhgw_padded_line(srcLines, s+k+i-1, lineNbr, radius, x0), hNext[i], width, hNext[i-1]);
+            }
+            
+            copyLine<T_in>(h[0], width, destLines[s]+x0);
+            for (size_t i=1;i<k && s+i<lineNbr;i++)
+              lineFunction(h[i], g[i-1], width, destLines[s+i]+x0);
+            
+            swap(h, hNext);
+        }
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_vhgw_vertical_segment(const imageType &imIn, UINT radius, imageType &imOut)
+    {
+        size_t imHeight = imIn.getHeight();
+        int nSlices = imIn.getDepth();
+        
+        volType srcSlices = imIn.getSlices();
+        volType destSlices = imOut.getSlices();
+        
+        size_t k = 2*radius + 1;
+        size_t stripWidth = this->_vhgw_strip_width(radius);
+        int nStrips = (this->lineLen + stripWidth - 1) / stripWidth;
+        int nTasks = nSlices * nStrips;
+        
+        int nthreads = MIN(int(Core::getInstance()->getNumberOfThreads()), nTasks);
+        nthreads = MAX(nthreads, 1);
+        
+        typename ImDtTypes<T_in>::matrixType _data(nthreads, typename ImDtTypes<T_in>::vectorType(3*k*stripWidth));
+        
+        int t;
+        
+      #ifdef USE_OPEN_MP
+        #pragma omp parallel private(t) num_threads(nthreads)
+      #endif // USE_OPEN_MP
+        {
+            int tid = 0;
+          #ifdef USE_OPEN_MP
+            tid = omp_get_thread_num();
+          #endif // USE_OPEN_MP
+            
+            vector<lineType> bufs(3*k);
+            for (size_t i=0;i<3*k;i++)
+              bufs[i] = _data[tid].data() + i*stripWidth;
+            
+          #ifdef USE_OPEN_MP
+            #pragma omp for
+          #endif // USE_OPEN_MP
+            for (t=0;t<nTasks;t++)
+            {
+                int s = t / nStrips;
+                size_t x0 = (t % nStrips) * stripWidth;
+                size_t width = MIN(stripWidth, this->lineLen-x0);
+                
+                _exec_vhgw_lines(srcSlices[s], destSlices[s], imHeight, radius, x0, width, bufs.data());
+            }
+        }
+        
+        return RES_OK;
+    }
+    
+    template <class T_in, class lineFunction_T>
+    RES_T MorphImageFunction<T_in, lineFunction_T, T_in, true>::_exec_vhgw_depth_segment(const imageType &imIn, UINT radius, imageType &imOut)
+    {
+        size_t w, h, d;
+        imIn.getSize(&w, &h, &d);
+        
+        volType srcSlices = imIn.getSlices();
+        volType destSlices = imOut.getSlices();
+        
+        size_t k = 2*radius + 1;
+        size_t stripWidth = this->_vhgw_strip_width(radius);
+        int nStrips = (w + stripWidth - 1) / stripWidth;
+        int nTasks = h * nStrips;
+        
+        int nthreads = MIN(int(Core::getInstance()->getNumberOfThreads()), nTasks);
+        nthreads = MAX(nthreads, 1);
+        
+        typename ImDtTypes<T_in>::matrixType _data(nthreads, typename ImDtTypes<T_in>::vectorType(3*k*stripWidth));
+        
+        int t;
+        
+      #ifdef USE_OPEN_MP
+        #pragma omp parallel private(t) num_threads(nthreads)
+      #endif // USE_OPEN_MP
+        {
+            int tid = 0;
+          #ifdef USE_OPEN_MP
+            tid = omp_get_thread_num();
+          #endif // USE_OPEN_MP
+            
+            vector<lineType> bufs(3*k);
+            for (size_t i=0;i<3*k;i++)
+              bufs[i] = _data[tid].data() + i*stripWidth;
+            
+            // Lines along z at a given y
+            vector<lineType> srcLines(d), destLines(d);
+            
+          #ifdef USE_OPEN_MP
+            #pragma omp for
+          #endif // USE_OPEN_MP
+            for (t=0;t<nTasks;t++)
+            {
+                size_t y = t / nStrips;
+                size_t x0 = (t % nStrips) * stripWidth;
+                size_t width = MIN(stripWidth, w-x0);
+                
+                for (size_t z=0;z<d;z++)
+                {
+                    srcLines[z] = srcSlices[z][y];
+                    destLines[z] = destSlices[z][y];
+                }
+                
+                _exec_vhgw_lines(srcLines.data(), destLines.data(), d, radius, x0, width, bufs.data());
+            }
+        }
+        
+        return RES_OK;
+    }
     
 } // namespace smil
 
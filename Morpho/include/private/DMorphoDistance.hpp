@@ -809,170 +809,287 @@ namespace smil
 
   /*
    * Euclidean Distance function.
+   *
+   * The squared distance is computed axis after axis, as the lower envelope
+   * of the parabolas rooted at the pixels of each line (Felzenszwalb and
+   * Huttenlocher). Lines are independent and processed in parallel. Along y
+   * and z, blocks of adjacent columns are copied into contiguous buffers, so
+   * that the image is always read and written line by line.
    */
-  template <class T1, class T2>
-  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut)
+  class EuclideanDistanceFunctor
   {
-    ASSERT_ALLOCATED(&imIn, &imOut);
-    ASSERT_SAME_SIZE(&imIn, &imOut);
+  public:
+    // Number of adjacent columns processed together along y and z
+    static const size_t BLOCK_WIDTH = 16;
 
-    ImageFreezer freeze(imOut);
-    Image<T2> tmp(imIn);
+    EuclideanDistanceFunctor(double sx = 1., double sy = 1., double sz = 1.)
+    {
+      spacing[0] = sx;
+      spacing[1] = sy;
+      spacing[2] = sz;
+    }
 
-    typedef Image<T1> imageInType;
-    typedef typename imageInType::lineType lineInType;
-    typedef Image<T2> imageOutType;
-    typedef typename imageOutType::lineType lineOutType;
+    template <class T1, class T2>
+    RES_T operator()(const Image<T1> &imIn, Image<T2> &imOut)
+    {
+      ASSERT_ALLOCATED(&imIn, &imOut);
+      ASSERT_SAME_SIZE(&imIn, &imOut);
 
-    lineInType pixelsIn   = imIn.getPixels();
-    lineOutType pixelsOut = imOut.getPixels();
-    lineOutType pixelsTmp = tmp.getPixels();
-
-    int size[3];
-    imIn.getSize(size);
-    size_t nbrPixelsPerSlice = size[0] * size[1];
-    size_t offset;
-    int x, y, z;
-    T2 infinite = ImDtTypes<T2>::max();
-
-    // H(x,u) is a minimizer, = MIN(h: 0 <= h < u & Any (i: 0 <= i < u : f(x,h)
-    // <= f(x,i)) : h )
-    // sets of the least minimizers that occurs
-    // during the scan from left to right.
-    vector<long int> s(size[0]);
-    // sets of points with the same least minimizer
-    vector<long int> t(size[0]);
-    long int q = 0;
-    long int w;
-
-    for (z = 0; z < size[2]; ++z) {
-      // #ifdef USE_OPEN_MP
-      //   #pragma omp for private(offset,x,y,min)
-      // #endif // USE_OPEN_MP
-      for (x = 0; x < size[0]; ++x) {
-        offset = z * nbrPixelsPerSlice + x;
-        if (pixelsIn[offset] == T1(0)) {
-          pixelsOut[offset] = T2(0);
-        } else {
-          pixelsOut[offset] = infinite;
-        }
-        // SCAN 1
-        for (y = 1; y < size[1]; ++y) {
-          if (pixelsIn[offset + y * size[0]] == T1(0)) {
-            pixelsOut[offset + y * size[0]] = T2(0);
-          } else {
-            // BUG :
-            // 1 + pixelsOut[offset + (y - 1) * size[0]]
-            //    will never be greater than infinite
-            pixelsOut[offset + y * size[0]] =
-                (1 + pixelsOut[offset + (y - 1) * size[0]] > infinite)
-                    ? infinite
-                    : 1 + pixelsOut[offset + (y - 1) * size[0]];
-          }
-        }
-        // SCAN 2
-        for (y = size[1] - 2; y >= 0 && y < size[1]; --y) {
-          if (pixelsOut[offset + (y + 1) * size[0]] <
-              pixelsOut[offset + y * size[0]])
-            pixelsOut[offset + y * size[0]] =
-                (1 + pixelsOut[offset + (y + 1) * size[0]] < infinite)
-                    ? 1 + pixelsOut[offset + (y + 1) * size[0]]
-                    : infinite;
-        }
+      ImageFreezer freeze(imOut);
+      return compute(imIn, imOut, (UINT32 *) NULL);
+    }
+
+    // Also write the offset of the nearest zero pixel into imNearest
+    template <class T1, class T2, class T3>
+    RES_T operator()(const Image<T1> &imIn, Image<T2> &imOut,
+                     Image<T3> &imNearest)
+    {
+      ASSERT_ALLOCATED(&imIn, &imOut, &imNearest);
+      ASSERT_SAME_SIZE(&imIn, &imOut, &imNearest);
+      ASSERT(imIn.getPixelCount() <= size_t(ImDtTypes<T3>::max()),
+             "Image too large for the type of the offsets", RES_ERR);
+
+      ImageFreezer freeze(imOut);
+      ImageFreezer freezeNearest(imNearest);
+      return compute(imIn, imOut, imNearest.getPixels());
+    }
+
+  private:
+    double spacing[3];
+
+    template <class T1, class T2, class F>
+    RES_T compute(const Image<T1> &imIn, Image<T2> &imOut, F *feat)
+    {
+      bool unitSpacing =
+          spacing[0] == 1. && spacing[1] == 1. && spacing[2] == 1.;
+
+      // Wide output types hold the intermediate squared distances
+      if (sizeof(T2) >= 4 &&
+          (!std::numeric_limits<T2>::is_integer || unitSpacing))
+        return transform(imIn, imOut.getPixels(), feat);
+
+      // Others are saturated from a temporary buffer
+      size_t pixCount                     = imIn.getPixelCount();
+      typename Image<T2>::lineType pixOut = imOut.getPixels();
+      T2 maxVal                           = ImDtTypes<T2>::max();
+
+      if (unitSpacing) {
+        vector<UINT32> buf(pixCount);
+        transform(imIn, buf.data(), feat);
+        for (size_t i = 0; i < pixCount; i++)
+          pixOut[i] = buf[i] < UINT32(maxVal) ? T2(buf[i]) : maxVal;
+      } else {
+        vector<float> buf(pixCount);
+        transform(imIn, buf.data(), feat);
+        for (size_t i = 0; i < pixCount; i++)
+          pixOut[i] = buf[i] < double(maxVal) ? T2(buf[i] + 0.5) : maxVal;
       }
+      return RES_OK;
     }
 
-    copy(imOut, tmp);
+    // Squared distances into buf, infinite pixels holding max(W), and
+    // offsets of the nearest zero pixels into feat (if not NULL)
+    template <class T1, class W, class F>
+    RES_T transform(const Image<T1> &imIn, W *buf, F *feat)
+    {
+      typename Image<T1>::lineType pixIn = imIn.getPixels();
+      W infinite                         = ImDtTypes<W>::max();
+      F none                             = ImDtTypes<F>::max();
+      bool integral = std::numeric_limits<W>::is_integer;
+      double w2     = spacing[0] * spacing[0];
 
-#define __f_euclidean(x, i)                                                    \
-  (x - i) * (x - i) + pixelsTmp[offset + i] * pixelsTmp[offset + i]
-#define __sep(a, b)                                                            \
-  (b * b - a * a + pixelsTmp[offset + b] * pixelsTmp[offset + b] -             \
-   pixelsTmp[offset + a] * pixelsTmp[offset + a]) /                            \
-      (2 * (b - a))
+      size_t size[3];
+      imIn.getSize(size);
+      long width  = long(size[0]);
+      int lineNbr = int(size[1] * size[2]);
+      int l;
 
-    for (z = 0; z < size[2]; ++z) {
+      // Along x, the distance to the nearest zero pixel of the line, found
+      // by a forward and a backward scan
 #ifdef USE_OPEN_MP
-#pragma omp for private(offset, y, x, q, w)
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
 #endif // USE_OPEN_MP
-      for (y = 0; y < size[1]; ++y) {
-        offset = z * nbrPixelsPerSlice + y * size[0];
-        q      = 0;
-        t[0]   = 0;
-        s[0]   = 0;
-        // SCAN 3
-        for (x = 1; x < size[0]; ++x) {
-          while (q >= 0 && __f_euclidean(t[q], s[q]) > __f_euclidean(t[q], x)) {
-            q--;
+      for (l = 0; l < lineNbr; l++) {
+        typename Image<T1>::lineType lineIn = pixIn + l * width;
+        W *lineOut                          = buf + l * width;
+        F *lineFeat                         = feat ? feat + l * width : NULL;
+        long last                           = -1;
+
+        for (long x = 0; x < width; x++) {
+          if (lineIn[x] == T1(0))
+            last = x;
+          lineOut[x] = last < 0 ? infinite : W(x - last);
+          if (lineFeat)
+            lineFeat[x] = last < 0 ? none : F(l * width + last);
+        }
+        last = -1;
+        for (long x = width - 1; x >= 0; x--) {
+          if (lineIn[x] == T1(0))
+            last = x;
+          if (last >= 0 &&
+              (lineOut[x] == infinite || W(last - x) < lineOut[x])) {
+            lineOut[x] = W(last - x);
+            if (lineFeat)
+              lineFeat[x] = F(l * width + last);
           }
-          if (q < 0) {
-            q    = 0;
-            s[0] = x;
-          } else {
-            w = 1 + __sep(s[q], x);
-            if (w < size[0]) {
-              q++;
-              s[q] = x;
-              t[q] = w;
-            }
+          if (lineOut[x] != infinite) {
+            double d   = w2 * double(lineOut[x]) * double(lineOut[x]);
+            lineOut[x] = integral ? W(d + 0.5) : W(d);
           }
         }
-        // SCAN 4
-        for (x = size[0] - 1; x >= 0 && x < size[0]; --x) {
-          pixelsOut[offset + x] = __f_euclidean(x, s[q]);
-          if (x == t[q])
-            --q;
-        }
       }
+
+      for (int axis = 1; axis < 3; axis++)
+        if (size[axis] > 1)
+          transformAxis(buf, feat, size, axis);
+
+      return RES_OK;
     }
-#undef __f_euclidean
-#undef __sep
-
-    copy(imOut, tmp);
-// The previous pixels are already squarred ...
-#define __f_euclidean(a, i)                                                    \
-  (a - i) * (a - i) + pixelsTmp[offset + i * nbrPixelsPerSlice]
-#define __sep(a, b)                                                            \
-  (b * b - a * a + pixelsTmp[offset + b * nbrPixelsPerSlice] -                 \
-   pixelsTmp[offset + a * nbrPixelsPerSlice]) /                                \
-      (2 * (b - a))
-    for (y = 0; y < size[1]; ++y) {
-#ifdef USE_OPENMP
-#pragma omp for private(x, z, offset)
-#endif
-      for (x = 0; x < size[0]; ++x) {
-        offset = y * size[0] + x;
-        q      = 0;
-        t[0]   = 0;
-        s[0]   = 0;
-        for (z = 1; z < size[2]; ++z) {
-          while (q >= 0 && __f_euclidean(t[q], s[q]) > __f_euclidean(t[q], z)) {
-            q--;
+
+    // Scans along y (axis 1) or z (axis 2), by blocks of adjacent columns
+    template <class W, class F>
+    void transformAxis(W *buf, F *feat, const size_t *size, int axis)
+    {
+      size_t n           = size[axis];
+      size_t lineStride  = axis == 1 ? size[0] : size[0] * size[1];
+      size_t outerStride = axis == 1 ? size[0] * size[1] : size[0];
+      size_t outerNbr    = axis == 1 ? size[2] : size[1];
+      size_t blockWidth  = std::min(size[0], size_t(BLOCK_WIDTH));
+      size_t blockNbr    = (size[0] + blockWidth - 1) / blockWidth;
+
+      W infinite    = ImDtTypes<W>::max();
+      F none        = ImDtTypes<F>::max();
+      double w2     = spacing[axis] * spacing[axis];
+      int taskNbr   = int(outerNbr * blockNbr);
+      bool integral = std::numeric_limits<W>::is_integer;
+      int task;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel private(task) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      {
+        vector<double> f(n * blockWidth), d(n), z(n + 1);
+        vector<size_t> v(n);
+        // Features of the block and index of the nearest root of each pixel
+        vector<F> ff(feat ? n * blockWidth : 0);
+        vector<size_t> roots(feat ? n * blockWidth : 0);
+
+#ifdef USE_OPEN_MP
+#pragma omp for schedule(dynamic)
+#endif // USE_OPEN_MP
+        for (task = 0; task < taskNbr; task++) {
+          size_t x0    = (task % blockNbr) * blockWidth;
+          size_t width = std::min(blockWidth, size[0] - x0);
+          size_t first = (task / blockNbr) * outerStride + x0;
+          W *start     = buf + first;
+
+          for (size_t i = 0; i < n; i++) {
+            W *p = start + i * lineStride;
+            for (size_t c = 0; c < width; c++)
+              f[c * n + i] = p[c] == infinite
+                                 ? std::numeric_limits<double>::infinity()
+                                 : double(p[c]);
+            if (feat)
+              for (size_t c = 0; c < width; c++)
+                ff[c * n + i] = feat[first + i * lineStride + c];
           }
-          if (q < 0) {
-            q    = 0;
-            s[0] = z;
-          } else {
-            w = 1 + __sep(s[q], z);
-            if (w < size[2]) {
-              q++;
-              s[q] = z;
-              t[q] = w;
+
+          for (size_t c = 0; c < width; c++) {
+            double *fc = f.data() + c * n;
+            lowerEnvelope(fc, n, w2, d.data(), z.data(), v.data(),
+                          feat ? roots.data() + c * n : NULL);
+            std::copy(d.begin(), d.end(), fc);
+          }
+
+          for (size_t i = 0; i < n; i++) {
+            W *p = start + i * lineStride;
+            for (size_t c = 0; c < width; c++) {
+              double val = f[c * n + i];
+              if (val >= double(infinite))
+                p[c] = infinite;
+              else
+                p[c] = integral ? W(val + 0.5) : W(val);
+              if (feat)
+                feat[first + i * lineStride + c] =
+                    p[c] == infinite ? none : ff[c * n + roots[c * n + i]];
             }
           }
         }
-        for (z = size[2] - 1; z >= 0 && z < size[2]; --z) {
-          pixelsOut[offset + z * nbrPixelsPerSlice] = __f_euclidean(z, s[q]);
-          if (z == t[q]) {
-            --q;
-          }
+      }
+    }
+
+    // Lower envelope of the parabolas w2 * (i - p)^2 + f[p], for the pixels
+    // p where f is finite. The root p of each pixel is written to r (if not
+    // NULL).
+    static void lowerEnvelope(const double *f, size_t n, double w2, double *d,
+                              double *z, size_t *v, size_t *r)
+    {
+      const double inf = std::numeric_limits<double>::infinity();
+      long k           = -1;
+
+      for (size_t q = 0; q < n; q++) {
+        if (f[q] == inf)
+          continue;
+        double s = -inf;
+        while (k >= 0) {
+          double p = double(v[k]);
+          s = ((f[q] + w2 * q * q) - (f[v[k]] + w2 * p * p)) /
+              (2 * w2 * (q - p));
+          if (s > z[k])
+            break;
+          k--;
         }
+        if (k < 0)
+          s = -inf;
+        k++;
+        v[k] = q;
+        z[k] = s;
+      }
+
+      if (k < 0) {
+        std::fill(d, d + n, inf);
+        return;
+      }
+      z[k + 1] = inf;
+
+      k = 0;
+      for (size_t q = 0; q < n; q++) {
+        while (z[k + 1] < double(q))
+          k++;
+        double dq = double(q) - double(v[k]);
+        d[q]      = w2 * dq * dq + f[v[k]];
+        if (r)
+          r[q] = v[k];
       }
     }
-#undef __f_euclidean
-#undef __sep
+  };
 
-    return RES_OK;
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut)
+  {
+    EuclideanDistanceFunctor edt;
+    return edt(imIn, imOut);
+  }
+
+  template <class T1, class T2>
+  RES_T distanceEuclidean(const Image<T1> &imIn, Image<T2> &imOut, double sx,
+                          double sy, double sz)
+  {
+    ASSERT(sx > 0. && sy > 0. && sz > 0., "Pixel spacing must be positive",
+           RES_ERR);
+
+    EuclideanDistanceFunctor edt(sx, sy, sz);
+    return edt(imIn, imOut);
+  }
+
+  template <class T1, class T2, class T3>
+  RES_T featureTransform(const Image<T1> &imIn, Image<T2> &imOut,
+                         Image<T3> &imNearest)
+  {
+    EuclideanDistanceFunctor edt;
+    return edt(imIn, imOut, imNearest);
   }
   /** @endcond */
 
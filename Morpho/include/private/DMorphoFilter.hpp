@@ -34,6 +34,7 @@
 #include "DMorphImageOperations.hxx"
 
 #include "Base/include/private/DImageArith.hpp"
+#include "Base/include/private/DIntegralImage.hpp"
 #include "Morpho/include/DMorphoInstance.h"
 #include "DHitOrMiss.hpp"
 
@@ -163,7 +164,6 @@ namespace smil
     return open(imIn, imOut, DEFAULT_SE(seSize));
   }
 
-
   /**
    * Alternate Sequential Filter beginning by a closing
    *
@@ -227,22 +227,242 @@ namespace smil
   }
 
   /** @cond */
-  template <class T> class meanFunct : public MorphImageFunctionBase<T, T>
+  // Bounding box of a SE whose points fill a box, each of them once
+  inline bool isBoxSE(const StrElt &se, int &xmin, int &xmax, int &ymin,
+                      int &ymax, int &zmin, int &zmax)
+  {
+    if (se.odd || se.points.empty())
+      return false;
+
+    xmin = xmax = se.points[0].x;
+    ymin = ymax = se.points[0].y;
+    zmin = zmax = se.points[0].z;
+    for (size_t i = 0; i < se.points.size(); i++) {
+      const IntPoint &p = se.points[i];
+      xmin              = std::min(xmin, p.x);
+      xmax              = std::max(xmax, p.x);
+      ymin              = std::min(ymin, p.y);
+      ymax              = std::max(ymax, p.y);
+      zmin              = std::min(zmin, p.z);
+      zmax              = std::max(zmax, p.z);
+    }
+
+    size_t bw = xmax - xmin + 1;
+    size_t bh = ymax - ymin + 1;
+    if (se.points.size() != bw * bh * (zmax - zmin + 1))
+      return false;
+
+    vector<bool> filled(se.points.size(), false);
+    for (size_t i = 0; i < se.points.size(); i++) {
+      const IntPoint &p = se.points[i];
+      filled[((p.z - zmin) * bh + p.y - ymin) * bw + p.x - xmin] = true;
+    }
+    return std::find(filled.begin(), filled.end(), false) == filled.end();
+  }
+
+  template <class T>
+  class meanFunct : public MorphNeighborhoodFunction<T, T, meanFunct<T>>
   {
   public:
-    typedef MorphImageFunctionBase<T, T> parentClass;
+    inline void processPixel(size_t pointOffset, const vector<int> &dOffsetList)
+    {
+      double meanVal                      = 0;
+      vector<int>::const_iterator dOffset = dOffsetList.begin();
+      while (dOffset != dOffsetList.end()) {
+        meanVal += double(this->pixelsIn[pointOffset + *dOffset]);
+        dOffset++;
+      }
+      this->pixelsOut[pointOffset] = T(meanVal / double(dOffsetList.size()));
+    }
 
-    virtual inline void processPixel(size_t pointOffset,
-                                     vector<int> &dOffsetList)
+    // Sums are accumulated point by point over the whole run (vectorizable)
+    inline void processRun(size_t pointOffset, size_t len,
+                           const vector<int> &dOffsetList)
     {
-      double meanVal                = 0;
-      vector<int>::iterator dOffset = dOffsetList.begin();
+      vector<double> sums(len, 0.);
+      double *s = sums.data();
+
+      vector<int>::const_iterator dOffset = dOffsetList.begin();
       while (dOffset != dOffsetList.end()) {
-        meanVal += double(parentClass::pixelsIn[pointOffset + *dOffset]);
+        const T *in = this->pixelsIn + pointOffset + *dOffset;
+        for (size_t i = 0; i < len; i++)
+          s[i] += double(in[i]);
         dOffset++;
       }
-      parentClass::pixelsOut[pointOffset] =
-          T(meanVal / double(dOffsetList.size()));
+
+      T *out          = this->pixelsOut + pointOffset;
+      double ptNumber = double(dOffsetList.size());
+      for (size_t i = 0; i < len; i++)
+        out[i] = T(s[i] / ptNumber);
+    }
+  };
+
+  // Mean over a box, with running sums along each axis: the cost per pixel
+  // doesn't depend on the size of the box
+  template <class T> class meanBoxFunct
+  {
+  public:
+    typedef typename IntegralSumType<T>::type sumType;
+
+    RES_T _exec(const Image<T> &imIn, Image<T> &imOut, int xmin, int xmax,
+                int ymin, int ymax, int zmin, int zmax)
+    {
+      ASSERT_ALLOCATED(&imIn, &imOut);
+      ASSERT_SAME_SIZE(&imIn, &imOut);
+
+      if (&imIn == &imOut) {
+        Image<T> tmpIm(imIn, true); // clone
+        return _exec(tmpIm, imOut, xmin, xmax, ymin, ymax, zmin, zmax);
+      }
+
+      ImageFreezer freeze(imOut);
+
+      imIn.getSize(imSize);
+      box[0] = xmin;
+      box[1] = xmax;
+      box[2] = ymin;
+      box[3] = ymax;
+
+      size_t w = imSize[0], h = imSize[1], d = imSize[2];
+      const T *pixelsIn = imIn.getPixels();
+      T *pixelsOut      = imOut.getPixels();
+
+      // Horizontal windows are the same for all lines
+      xBegin.resize(w);
+      xEnd.resize(w);
+      for (size_t x = 0; x < w; x++) {
+        xBegin[x] = std::min(std::max(int(x) + xmin, 0), int(w));
+        xEnd[x]   = std::max(std::min(int(x) + xmax + 1, int(w)), xBegin[x]);
+      }
+
+      int nthreads = 1;
+#ifdef USE_OPEN_MP
+      nthreads = Core::getInstance()->getNumberOfThreads();
+#endif // USE_OPEN_MP
+      bandNbr = std::min(int(h), 4 * nthreads);
+
+      if (d == 1) {
+        processSlice(pixelsIn, 1, pixelsOut);
+        return RES_OK;
+      }
+
+      // 3D: sums over the z window of each pixel, updated slice by slice
+      size_t sliceSize = w * h;
+      vector<sumType> sliceSums(sliceSize, sumType(0));
+      sumType *sums = sliceSums.data();
+
+      for (int z = 0; z < int(d); z++) {
+        int zBegin = std::max(z + zmin, 0);
+        int zEnd   = std::min(z + zmax + 1, int(d));
+
+        if (z == 0) {
+          for (int k = zBegin; k < zEnd; k++)
+            addSlice(sums, pixelsIn + k * sliceSize, true);
+        } else {
+          if (z + zmax < int(d) && z + zmax >= 0)
+            addSlice(sums, pixelsIn + (z + zmax) * sliceSize, true);
+          if (z - 1 + zmin >= 0 && z - 1 + zmin < int(d))
+            addSlice(sums, pixelsIn + (z - 1 + zmin) * sliceSize, false);
+        }
+
+        processSlice(sums, std::max(zEnd - zBegin, 0),
+                     pixelsOut + z * sliceSize);
+      }
+
+      return RES_OK;
+    }
+
+  protected:
+    size_t imSize[3];
+    int box[4];
+    int bandNbr;
+    vector<int> xBegin, xEnd;
+
+    // Add (or remove) a slice to the sums
+    void addSlice(sumType *sums, const T *slice, bool add)
+    {
+      int sliceSize = imSize[0] * imSize[1];
+      int i;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < sliceSize; i++) {
+        if (add)
+          sums[i] += sumType(slice[i]);
+        else
+          sums[i] -= sumType(slice[i]);
+      }
+    }
+
+    // Means of the rectangles over the 2D slice src, whose pixels are each
+    // the sum of zCount values
+    template <class srcT>
+    void processSlice(const srcT *src, int zCount, T *out)
+    {
+      int b;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (b = 0; b < bandNbr; b++)
+        processBand(src, imSize[1] * b / bandNbr,
+                    imSize[1] * (b + 1) / bandNbr, zCount, out);
+    }
+
+    // Lines [y0,y1) of a slice: column sums are updated line by line, and
+    // prefix sums of the columns give the horizontal windows
+    template <class srcT>
+    void processBand(const srcT *src, size_t y0, size_t y1, int zCount,
+                     T *out)
+    {
+      int w = imSize[0], h = imSize[1];
+      vector<sumType> colSums(w, sumType(0));
+      vector<sumType> prefix(w + 1, sumType(0));
+      sumType *cols = colSums.data();
+      sumType *pre  = prefix.data();
+
+      for (int y = y0; y < int(y1); y++) {
+        int yBegin = std::max(y + box[2], 0);
+        int yEnd   = std::min(y + box[3] + 1, h);
+
+        if (y == int(y0)) {
+          for (int k = yBegin; k < yEnd; k++)
+            addLine(cols, src + size_t(k) * w, w, true);
+        } else {
+          if (y + box[3] < h && y + box[3] >= 0)
+            addLine(cols, src + size_t(y + box[3]) * w, w, true);
+          if (y - 1 + box[2] >= 0 && y - 1 + box[2] < h)
+            addLine(cols, src + size_t(y - 1 + box[2]) * w, w, false);
+        }
+
+        for (int x = 0; x < w; x++)
+          pre[x + 1] = pre[x] + cols[x];
+
+        T *lineOut   = out + size_t(y) * w;
+        double count = double(std::max(yEnd - yBegin, 0) * zCount);
+        for (int x = 0; x < w; x++) {
+          int n = xEnd[x] - xBegin[x];
+          if (n == 0 || count == 0)
+            lineOut[x] = T(0);
+          else
+            lineOut[x] = T(double(pre[xEnd[x]] - pre[xBegin[x]]) /
+                           (double(n) * count));
+        }
+      }
+    }
+
+    template <class srcT>
+    inline void addLine(sumType *cols, const srcT *line, int w, bool add)
+    {
+      if (add)
+        for (int x = 0; x < w; x++)
+          cols[x] += sumType(line[x]);
+      else
+        for (int x = 0; x < w; x++)
+          cols[x] -= sumType(line[x]);
     }
   };
   /** @endcond */
@@ -250,6 +470,12 @@ namespace smil
   /**
    * Mean filter
    *
+   * Box shaped SEs (segments, squares, cubes) are computed with running
+   * sums, in a time independent of their size. Sums are exact for integer
+   * types; for floating point types they are computed in double precision,
+   * in another order than the point by point filter, so the results may
+   * differ from it by rounding errors.
+   *
    * @param[in] imIn : input image
    * @param[out] imOut : output image
    * @param[in] se : structuring element
@@ -261,6 +487,18 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
+    // The homothety of a box of size s is the box scaled by s. Very small
+    // boxes are faster point by point.
+    int xmin, xmax, ymin, ymax, zmin, zmax;
+    int s = se.size > 1 ? se.size : 1;
+    if (isBoxSE(se, xmin, xmax, ymin, ymax, zmin, zmax) &&
+        (s * (xmax - xmin) + 1) * (s * (ymax - ymin) + 1) *
+                (s * (zmax - zmin) + 1) >= 9) {
+      meanBoxFunct<T> f;
+      return f._exec(imIn, imOut, s * xmin, s * xmax, s * ymin, s * ymax,
+                     s * zmin, s * zmax);
+    }
+
     meanFunct<T> f;
 
     ASSERT((f._exec(imIn, imOut, se) == RES_OK));
@@ -269,75 +507,499 @@ namespace smil
   }
 
   /** @cond */
-  template <class T> class medianFunct : public MorphImageFunctionBase<T, T>
+  // Value of rank n among the neighbors of each pixel
+  template <class T, class derivedT>
+  class rankFunctBase : public MorphNeighborhoodFunction<T, T, derivedT>
   {
   public:
-    typedef MorphImageFunctionBase<T, T> parentClass;
+    inline void processPixel(size_t pointOffset, const vector<int> &dOffsetList)
+    {
+      vector<T> vals(dOffsetList.size());
+      processPixel(pointOffset, dOffsetList, vals);
+    }
 
-    virtual inline void processPixel(size_t pointOffset,
-                                     vector<int> &dOffsetList)
+    inline void processRun(size_t pointOffset, size_t len,
+                           const vector<int> &dOffsetList)
     {
-      vector<T> vals;
-      vector<int>::iterator dOffset = dOffsetList.begin();
-      while (dOffset != dOffsetList.end()) {
-        vals.push_back(parentClass::pixelsIn[pointOffset + *dOffset]);
-        dOffset++;
-      }
-      sort(vals.begin(), vals.end());
-      parentClass::pixelsOut[pointOffset] = vals[dOffsetList.size() / 2];
+      vector<T> vals(dOffsetList.size());
+      for (size_t i = 0; i < len; i++)
+        processPixel(pointOffset + i, dOffsetList, vals);
+    }
+
+  protected:
+    inline void processPixel(size_t pointOffset, const vector<int> &dOffsetList,
+                             vector<T> &vals)
+    {
+      if (vals.empty())
+        return;
+      for (size_t i = 0; i < vals.size(); i++)
+        vals[i] = this->pixelsIn[pointOffset + dOffsetList[i]];
+
+      size_t n = static_cast<derivedT *>(this)->getRank(vals.size());
+      n        = std::min(n, vals.size() - 1);
+      std::nth_element(vals.begin(), vals.begin() + n, vals.end());
+      this->pixelsOut[pointOffset] = vals[n];
     }
   };
-  /** @endcond */
 
-  /**
-   * Median filter
-   *
-   * @param[in] imIn : input image
-   * @param[out] imOut : output image
-   * @param[in] se : structuring element
-   */
   template <class T>
-  RES_T median(const Image<T> &imIn, Image<T> &imOut,
-               const StrElt &se = DEFAULT_SE)
+  class medianFunct : public rankFunctBase<T, medianFunct<T>>
   {
-    ASSERT_ALLOCATED(&imIn, &imOut);
-    ASSERT_SAME_SIZE(&imIn, &imOut);
+  public:
+    inline size_t getRank(size_t ptNumber)
+    {
+      return ptNumber / 2;
+    }
+  };
 
-    medianFunct<T> f;
+  template <class T> class rankFunct : public rankFunctBase<T, rankFunct<T>>
+  {
+  public:
+    rankFunct(double per) : percentile(per)
+    {
+    }
 
-    ASSERT((f._exec(imIn, imOut, se) == RES_OK));
+    inline size_t getRank(size_t ptNumber)
+    {
+      return static_cast<size_t>(ptNumber * this->percentile);
+    }
 
-    return RES_OK;
-  }
+  private:
+    double percentile;
+  };
+  // Histogram of the values of a sliding window, tracking the value of a
+  // given rank (Huang). Coarse bins allow to skip empty ranges of values.
+  template <class T> class rankHistogram
+  {
+  public:
+    rankHistogram()
+        : fine(size_t(ImDtTypes<T>::max()) + 1, 0),
+          coarse((fine.size() >> coarseShift), 0), rnk(0), value(0),
+          lessCount(0)
+    {
+    }
 
-  /** @cond */
-  template <class T> class rankFunct : public MorphImageFunctionBase<T, T>
+    // Empty histogram is expected
+    inline void reset(size_t r)
+    {
+      rnk       = r;
+      value     = 0;
+      lessCount = 0;
+    }
+    inline void add(T v)
+    {
+      fine[v]++;
+      coarse[v >> coarseShift]++;
+      if (v < value)
+        lessCount++;
+    }
+    inline void remove(T v)
+    {
+      fine[v]--;
+      coarse[v >> coarseShift]--;
+      if (v < value)
+        lessCount--;
+    }
+
+    // Move the tracked value until lessCount <= rnk < lessCount + fine[value]
+    inline T get()
+    {
+      while (lessCount > rnk) {
+        if ((value & coarseMask) == 0 &&
+            lessCount - coarse[(value >> coarseShift) - 1] > rnk) {
+          value -= coarseMask + 1;
+          lessCount -= coarse[value >> coarseShift];
+        } else {
+          value--;
+          lessCount -= fine[value];
+        }
+      }
+      while (lessCount + fine[value] <= rnk) {
+        if ((value & coarseMask) == 0 &&
+            lessCount + coarse[value >> coarseShift] <= rnk) {
+          lessCount += coarse[value >> coarseShift];
+          value += coarseMask + 1;
+        } else {
+          lessCount += fine[value];
+          value++;
+        }
+      }
+      return T(value);
+    }
+
+  private:
+    static const size_t coarseShift = sizeof(T) == 1 ? 4 : 8;
+    static const size_t coarseMask  = (1 << coarseShift) - 1;
+
+    vector<UINT> fine;
+    vector<UINT> coarse;
+    size_t rnk;
+    size_t value;
+    size_t lessCount;
+  };
+
+  // Sliding histogram implementation of the rank filter: along a run, only
+  // the pixels entering and leaving the SE are updated.
+  template <class T>
+  class rankHistFunct : public rankFunctBase<T, rankHistFunct<T>>
   {
   public:
-    typedef MorphImageFunctionBase<T, T> parentClass;
+    typedef rankFunctBase<T, rankHistFunct<T>> parentClass;
 
-    rankFunct(double per) : MorphImageFunctionBase<T, T>(), percentile(per)
+    rankHistFunct(double per) : percentile(per)
     {
     }
-    virtual inline void processPixel(size_t pointOffset,
-                                     vector<int> &dOffsetList)
+
+    inline size_t getRank(size_t ptNumber)
     {
-      vector<T> vals;
-      vector<int>::iterator dOffset = dOffsetList.begin();
-      while (dOffset != dOffsetList.end()) {
-        vals.push_back(parentClass::pixelsIn[pointOffset + *dOffset]);
-        dOffset++;
+      return static_cast<size_t>(ptNumber * this->percentile);
+    }
+
+    RES_T _exec(const Image<T> &imIn, Image<T> &imOut, const StrElt &se)
+    {
+      // One histogram per thread
+      histograms.clear();
+      histograms.resize(Core::getInstance()->getNumberOfThreads());
+      return parentClass::_exec(imIn, imOut, se);
+    }
+
+    inline void processRun(size_t pointOffset, size_t len,
+                           const vector<int> &dOffsetList)
+    {
+      size_t ptNbr = dOffsetList.size();
+      if (ptNbr == 0)
+        return;
+
+      int tid = 0;
+#ifdef USE_OPEN_MP
+      tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+      rankHistogram<T> &hist = histograms[tid];
+
+      // Points entering the SE when moving to the next pixel, and (relative
+      // to the next pixel) points leaving it
+      vector<int> sorted(dOffsetList);
+      sort(sorted.begin(), sorted.end());
+      vector<int> entering, leaving;
+      for (size_t i = 0; i < ptNbr; i++) {
+        int o = sorted[i];
+        if (!binary_search(sorted.begin(), sorted.end(), o + 1))
+          entering.push_back(o);
+        if (!binary_search(sorted.begin(), sorted.end(), o - 1))
+          leaving.push_back(o - 1);
+      }
+
+      const T *in = this->pixelsIn + pointOffset;
+      T *out      = this->pixelsOut + pointOffset;
+
+      hist.reset(std::min(getRank(ptNbr), ptNbr - 1));
+      for (size_t i = 0; i < ptNbr; i++)
+        hist.add(in[sorted[i]]);
+      out[0] = hist.get();
+
+      for (size_t x = 1; x < len; x++) {
+        for (size_t i = 0; i < leaving.size(); i++)
+          hist.remove(in[x + leaving[i]]);
+        for (size_t i = 0; i < entering.size(); i++)
+          hist.add(in[x + entering[i]]);
+        out[x] = hist.get();
+      }
+
+      // Leave an empty histogram
+      for (size_t i = 0; i < ptNbr; i++)
+        hist.remove(in[len - 1 + sorted[i]]);
+    }
+
+  private:
+    double percentile;
+    vector<rankHistogram<T>> histograms;
+  };
+
+  // Rank filter with rectangular SEs on UINT8 images (Perreault-Hebert):
+  // the histograms of the image columns are updated when moving down, and
+  // the window histogram is updated with whole column histograms when moving
+  // right. The cost per pixel does not depend on the SE size.
+  // Images are processed by tiles (in parallel) so that the column
+  // histograms of a tile stay in cache.
+  template <class T> class rankRectHistFunct
+  {
+  public:
+    rankRectHistFunct(double per) : percentile(per)
+    {
+    }
+
+    RES_T _exec(const Image<T> &imIn, Image<T> &imOut, int xmin, int xmax,
+                int ymin, int ymax)
+    {
+      ASSERT_ALLOCATED(&imIn, &imOut);
+      ASSERT_SAME_SIZE(&imIn, &imOut);
+
+      if (&imIn == &imOut) {
+        Image<T> tmpIm(imIn, true); // clone
+        return _exec(tmpIm, imOut, xmin, xmax, ymin, ymax);
       }
-      sort(vals.begin(), vals.end());
-      parentClass::pixelsOut[pointOffset] =
-          vals[static_cast<int>(dOffsetList.size() * this->percentile)];
+
+      ImageFreezer freeze(imOut);
+
+      int w = imIn.getWidth();
+      int h = imIn.getHeight();
+      int d = imIn.getDepth();
+
+      typename ImDtTypes<T>::volType slicesIn  = imIn.getSlices();
+      typename ImDtTypes<T>::volType slicesOut = imOut.getSlices();
+
+      // The column histograms are built at the beginning of each tile
+      int tileHeight = std::max(64, 4 * (ymax - ymin + 1));
+      int tileWidth  = std::max(64, int(MORPH_CACHE_SIZE / 2 /
+                                        (histSize * sizeof(UINT16))) -
+                                       (xmax - xmin));
+      tileWidth      = std::min(tileWidth, w);
+
+      int nTilesX = (w + tileWidth - 1) / tileWidth;
+      int nTilesY = (h + tileHeight - 1) / tileHeight;
+      int nTiles  = nTilesX * nTilesY * d;
+
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+      nthreads     = std::max(1, std::min(nthreads, nTiles));
+
+      vector<vector<UINT16>> colHists(nthreads);
+      int t;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (t = 0; t < nTiles; t++) {
+        int tid = 0;
+#ifdef USE_OPEN_MP
+        tid = omp_get_thread_num();
+#endif // USE_OPEN_MP
+
+        int x0 = (t % nTilesX) * tileWidth;
+        int y0 = ((t / nTilesX) % nTilesY) * tileHeight;
+        int z  = t / (nTilesX * nTilesY);
+        int x1 = std::min(x0 + tileWidth, w);
+        int y1 = std::min(y0 + tileHeight, h);
+
+        // Columns used by the tile
+        int cx0 = std::max(x0 + xmin, 0);
+        int cx1 = std::min(x1 + xmax, w);
+        if (cx0 >= cx1)
+          continue;
+
+        vector<UINT16> &colHist = colHists[tid];
+        colHist.assign(size_t(cx1 - cx0) * histSize, 0);
+
+        for (int y = std::max(y0 + ymin, 0); y <= std::min(y0 + ymax, h - 1);
+             y++)
+          updateColumns(colHist, slicesIn[z][y], cx0, cx1, 1);
+
+        for (int y = y0; y < y1; y++) {
+          if (y > y0) {
+            if (y - 1 + ymin >= 0 && y - 1 + ymin < h)
+              updateColumns(colHist, slicesIn[z][y - 1 + ymin], cx0, cx1, -1);
+            if (y + ymax >= 0 && y + ymax < h)
+              updateColumns(colHist, slicesIn[z][y + ymax], cx0, cx1, 1);
+          }
+          int rowNbr = std::min(y + ymax, h - 1) - std::max(y + ymin, 0) + 1;
+          if (rowNbr > 0)
+            processLine(colHist, cx0, cx1, slicesOut[z][y], x0, x1, rowNbr,
+                        xmin, xmax);
+        }
+      }
+
+      return RES_OK;
     }
 
   private:
+    // 16 coarse bins followed by 256 fine bins
+    static const int coarseShift = 4;
+    static const int coarseSize  = 16;
+    static const int histSize    = 16 + 256;
+
+    inline void updateColumns(vector<UINT16> &colHist, const T *lineIn,
+                              int cx0, int cx1, int incr)
+    {
+      UINT16 *col = colHist.data();
+      for (int x = cx0; x < cx1; x++, col += histSize) {
+        col[lineIn[x] >> coarseShift] += incr;
+        col[coarseSize + lineIn[x]] += incr;
+      }
+    }
+
+    // Output pixels [x0,x1) of a line, from the histograms of the columns
+    // [cx0,cx1).
+    // Only the coarse bins of the window histogram are updated at each
+    // pixel: the fine bins of a coarse bin are brought up to date when the
+    // rank falls into it.
+    inline void processLine(const vector<UINT16> &colHist, int cx0, int cx1,
+                            T *lineOut, int x0, int x1, int rowNbr, int xmin,
+                            int xmax)
+    {
+      const UINT16 *cols = colHist.data() - size_t(cx0) * histSize;
+      UINT16 hist[histSize];
+      int lastUpdate[coarseSize];
+
+      std::fill(hist, hist + coarseSize, 0);
+      std::fill(lastUpdate, lastUpdate + coarseSize, x0 - (xmax - xmin) - 2);
+
+      for (int x = std::max(x0 + xmin, cx0); x <= std::min(x0 + xmax, cx1 - 1);
+           x++)
+        addBins(hist, cols + size_t(x) * histSize, coarseSize);
+
+      for (int x = x0; x < x1; x++) {
+        if (x > x0) {
+          if (x - 1 + xmin >= cx0 && x - 1 + xmin < cx1)
+            subBins(hist, cols + size_t(x - 1 + xmin) * histSize, coarseSize);
+          if (x + xmax >= cx0 && x + xmax < cx1)
+            addBins(hist, cols + size_t(x + xmax) * histSize, coarseSize);
+        }
+        int colNbr = std::min(x + xmax, cx1 - 1) - std::max(x + xmin, cx0) + 1;
+        if (colNbr <= 0)
+          continue;
+
+        size_t n = size_t(rowNbr) * colNbr;
+        size_t k = std::min(static_cast<size_t>(n * percentile), n - 1);
+
+        size_t count = 0, c = 0;
+        while (count + hist[c] <= k)
+          count += hist[c++];
+
+        // Fine bins of the coarse bin c
+        size_t fine = coarseSize + (c << coarseShift);
+        UINT16 *fineHist = hist + fine;
+        if (x - lastUpdate[c] > xmax - xmin) {
+          std::fill(fineHist, fineHist + coarseSize, 0);
+          for (int cx = std::max(x + xmin, cx0);
+               cx <= std::min(x + xmax, cx1 - 1); cx++)
+            addBins(fineHist, cols + size_t(cx) * histSize + fine, coarseSize);
+        } else {
+          for (int ux = lastUpdate[c] + 1; ux <= x; ux++) {
+            if (ux - 1 + xmin >= cx0 && ux - 1 + xmin < cx1)
+              subBins(fineHist, cols + size_t(ux - 1 + xmin) * histSize + fine,
+                      coarseSize);
+            if (ux + xmax >= cx0 && ux + xmax < cx1)
+              addBins(fineHist, cols + size_t(ux + xmax) * histSize + fine,
+                      coarseSize);
+          }
+        }
+        lastUpdate[c] = x;
+
+        size_t v = 0;
+        while (count + fineHist[v] <= k)
+          count += fineHist[v++];
+        lineOut[x] = T((c << coarseShift) + v);
+      }
+    }
+
+    static inline void addBins(UINT16 *hist, const UINT16 *col, int nbr)
+    {
+      for (int i = 0; i < nbr; i++)
+        hist[i] += col[i];
+    }
+    static inline void subBins(UINT16 *hist, const UINT16 *col, int nbr)
+    {
+      for (int i = 0; i < nbr; i++)
+        hist[i] -= col[i];
+    }
+
     double percentile;
   };
+
+  // Sliding histograms are used on UINT8 and UINT16 images when the SE
+  // has at least minSEPoints points. Rectangular SEs use column histograms
+  // on UINT8 images (they would be too large for UINT16 ones).
+  template <class T> struct rankHistogramCompatible {
+    static const bool value      = false;
+    static const bool rectangles = false;
+    static const UINT minSEPoints = 0;
+  };
+  template <> struct rankHistogramCompatible<UINT8> {
+    static const bool value       = true;
+    static const bool rectangles  = true;
+    static const UINT minSEPoints = 8;
+  };
+  template <> struct rankHistogramCompatible<UINT16> {
+    static const bool value       = true;
+    static const bool rectangles  = false;
+    static const UINT minSEPoints = 20;
+  };
+
+  // Bounding box of a SE whose points fill a rectangle
+  inline bool isRectangleSE(const StrElt &se, int &xmin, int &xmax, int &ymin,
+                            int &ymax)
+  {
+    int zmin, zmax;
+    return isBoxSE(se, xmin, xmax, ymin, ymax, zmin, zmax) && zmin == 0 &&
+           zmax == 0;
+  }
+
+  template <class T, bool useHistogram = rankHistogramCompatible<T>::value>
+  struct rankFilter {
+    static RES_T median(const Image<T> &imIn, Image<T> &imOut,
+                        const StrElt &se)
+    {
+      medianFunct<T> f;
+      return f._exec(imIn, imOut, se);
+    }
+    static RES_T rank(const Image<T> &imIn, Image<T> &imOut,
+                      double percentile, const StrElt &se)
+    {
+      rankFunct<T> f(percentile);
+      return f._exec(imIn, imOut, se);
+    }
+  };
+
+  template <class T> struct rankFilter<T, true> {
+    static RES_T median(const Image<T> &imIn, Image<T> &imOut,
+                        const StrElt &se)
+    {
+      // floor(n*0.5) is n/2
+      return rank(imIn, imOut, 0.5, se);
+    }
+    static RES_T rank(const Image<T> &imIn, Image<T> &imOut,
+                      double percentile, const StrElt &se)
+    {
+      StrElt se2 = se.size > 1 ? se.homothety(se.size) : se;
+
+      // Window histograms have 16 bits counts
+      int xmin, xmax, ymin, ymax;
+      if (rankHistogramCompatible<T>::rectangles &&
+          se2.points.size() <= ImDtTypes<UINT16>::max() &&
+          isRectangleSE(se2, xmin, xmax, ymin, ymax)) {
+        rankRectHistFunct<T> f(percentile);
+        return f._exec(imIn, imOut, xmin, xmax, ymin, ymax);
+      }
+
+      if (se2.points.size() < rankHistogramCompatible<T>::minSEPoints) {
+        rankFunct<T> f(percentile);
+        return f._exec(imIn, imOut, se2);
+      }
+
+      rankHistFunct<T> f(percentile);
+      return f._exec(imIn, imOut, se2);
+    }
+  };
   /** @endcond */
 
+  /**
+   * Median filter
+   *
+   * @param[in] imIn : input image
+   * @param[out] imOut : output image
+   * @param[in] se : structuring element
+   */
+  template <class T>
+  RES_T median(const Image<T> &imIn, Image<T> &imOut,
+               const StrElt &se = DEFAULT_SE)
+  {
+    ASSERT_ALLOCATED(&imIn, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imOut);
+
+    ASSERT((rankFilter<T>::median(imIn, imOut, se) == RES_OK));
+
+    return RES_OK;
+  }
+
   /**
    * Rank filter
    * @param[in] imIn : input image
@@ -352,9 +1014,7 @@ namespace smil
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
-    rankFunct<T> f(percentile);
-
-    ASSERT((f._exec(imIn, imOut, se) == RES_OK));
+    ASSERT((rankFilter<T>::rank(imIn, imOut, percentile, se) == RES_OK));
 
     return RES_OK;
   }
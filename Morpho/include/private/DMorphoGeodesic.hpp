@@ -204,9 +204,8 @@ namespace smil
    * #    #   #   ######  #    #         ### #   ####   ######   ####   ######
    */
   /** @cond */
-  template <class T>
-  RES_T initBuildHierarchicalQueue(const Image<T> &imIn,
-                                   HierarchicalQueue<T> &hq)
+  template <class T, class HQ_Type>
+  RES_T initBuildHierarchicalQueue(const Image<T> &imIn, HQ_Type &hq)
   {
     // Initialize the priority queue
     hq.initialize(imIn);
@@ -228,9 +227,8 @@ namespace smil
     return RES_OK;
   }
 
-  template <class T>
-  RES_T initBuildHierarchicalQueue(const Image<T> &imIn,
-                                   HierarchicalQueue<T> &hq,
+  template <class T, class HQ_Type>
+  RES_T initBuildHierarchicalQueue(const Image<T> &imIn, HQ_Type &hq,
                                    const T noPushValue)
   {
     // Initialize the priority queue
@@ -255,10 +253,9 @@ namespace smil
     return RES_OK;
   }
 
-  template <class T, class operatorT>
+  template <class T, class operatorT, class HQ_Type>
   RES_T processBuildHierarchicalQueue(Image<T> &imIn, const Image<T> &imMask,
-                                      Image<UINT8> &imStatus,
-                                      HierarchicalQueue<T> &hq,
+                                      Image<UINT8> &imStatus, HQ_Type &hq,
                                       const StrElt &se)
   {
     typename ImDtTypes<T>::lineType inPixels       = imIn.getPixels();
@@ -347,19 +344,464 @@ namespace smil
       return max(a, b);
     }
   };
+
+  /*
+   * Hybrid reconstruction (L. Vincent, 1993)
+   *
+   * A forward and a backward raster scan propagate the marker values along
+   * the scan directions. The pixels which could still propagate their value
+   * after the backward scan are put in a FIFO, which handles the remaining
+   * (non monotonic) paths.
+   *
+   * The marker and the mask are copied into buffers with a border of the
+   * neutral value (which can't propagate), so that neighbors are read without
+   * bound checks. Offsets are computed for even and odd lines, to handle
+   * hexagonal SEs.
+   *
+   * With several threads, the image is split into slabs along its last
+   * dimension (z, or y for 2D images). Each slab is reconstructed on its
+   * own, ignoring the neighbors of the other slabs. Then, until nothing
+   * changes, the pixels of the slab boundaries take the values propagated
+   * from the neighbor slabs, and the FIFO of each slab propagates them.
+   *
+   * If @b dual, reconstruction by erosion.
+   */
+  template <class T, bool dual> class HybridBuildFunc
+  {
+  public:
+    // By default, one slab per thread
+    HybridBuildFunc(size_t slabNbr = 0) : requestedSlabNbr(slabNbr)
+    {
+    }
+
+    RES_T operator()(const Image<T> &imIn, const Image<T> &imMask,
+                     Image<T> &imOut, const StrElt &se)
+    {
+      imIn.getSize(imSize);
+      splitAxis = imSize[2] > 1 ? 2 : 1;
+
+      initOffsets(se);
+      copyIn(imIn, imMask);
+
+      size_t slabNbr = requestedSlabNbr;
+      if (slabNbr == 0) {
+        slabNbr = 1;
+#ifdef USE_OPEN_MP
+        slabNbr = min(size_t(Core::getInstance()->getNumberOfThreads()),
+                      imSize[splitAxis] / MIN_SLAB_SIZE);
+#endif // USE_OPEN_MP
+      }
+      slabNbr = min(slabNbr, imSize[splitAxis]);
+
+      if (slabNbr <= 1) {
+        Slab slab;
+        slab.begin   = 0;
+        slab.end     = imSize[splitAxis];
+        slab.bounded = false;
+        processSlab(slab);
+      } else
+        processSlabs(slabNbr);
+
+      copyOut(imOut);
+      return RES_OK;
+    }
+
+  protected:
+    // Minimum thickness of the slabs processed by a thread
+    static const size_t MIN_SLAB_SIZE = 16;
+    size_t requestedSlabNbr;
+
+    struct Slab {
+      // Range along the split axis
+      size_t begin, end;
+      // Neighbors out of the slab are ignored
+      bool bounded;
+      queue<size_t> fifo;
+      // New values of the boundary pixels
+      vector<pair<size_t, T>> updates;
+    };
+
+    // Offsets of neighbors, and their shift along the split axis
+    struct OffsetList {
+      vector<int> offsets;
+      vector<int> shifts;
+    };
+
+    size_t imSize[3];
+    size_t pad[3], padSize[3];
+    int splitAxis;
+    size_t maxShift;
+    bool odd;
+
+    // Neighbors before and after a pixel in the raster order, for even and
+    // odd lines
+    OffsetList causalOffsets[2], antiCausalOffsets[2], allOffsets[2];
+
+    vector<T> marker, mask;
+
+    // Value which can't propagate (min() is the smallest positive value for
+    // floating point types)
+    static inline T borderValue()
+    {
+      return dual ? numeric_limits<T>::max() : numeric_limits<T>::lowest();
+    }
+    // a would be raised (lowered if dual) by b
+    static inline bool below(const T &a, const T &b)
+    {
+      return dual ? a > b : a < b;
+    }
+    static inline T propagateOp(const T &a, const T &b)
+    {
+      return dual ? min(a, b) : max(a, b);
+    }
+    static inline T limitOp(const T &a, const T &m)
+    {
+      return dual ? max(a, m) : min(a, m);
+    }
+
+    inline size_t paddedOffset(size_t x, size_t y, size_t z) const
+    {
+      return ((z + pad[2]) * padSize[1] + y + pad[1]) * padSize[0] + x +
+             pad[0];
+    }
+
+    inline int lineParity(size_t y) const
+    {
+      return odd ? int(y % 2) : 0;
+    }
+
+    void initOffsets(const StrElt &se)
+    {
+      odd = se.odd;
+
+      vector<IntPoint> pts;
+      pad[0] = pad[1] = pad[2] = 0;
+      for (size_t i = 0; i < se.points.size(); i++) {
+        const IntPoint &p = se.points[i];
+        if ((p.x == 0 && p.y == 0 && p.z == 0) ||
+            (imSize[2] == 1 && p.z != 0))
+          continue;
+        pts.push_back(p);
+        pad[0] = max(pad[0], size_t(abs(p.x)) + (odd ? 1 : 0));
+        pad[1] = max(pad[1], size_t(abs(p.y)));
+        pad[2] = max(pad[2], size_t(abs(p.z)));
+      }
+      for (int i = 0; i < 3; i++)
+        padSize[i] = imSize[i] + 2 * pad[i];
+      maxShift = pad[splitAxis];
+
+      for (int parity = 0; parity < 2; parity++) {
+        OffsetList *lists[3] = {&causalOffsets[parity],
+                                &antiCausalOffsets[parity],
+                                &allOffsets[parity]};
+        for (int l = 0; l < 3; l++) {
+          lists[l]->offsets.clear();
+          lists[l]->shifts.clear();
+        }
+
+        for (size_t i = 0; i < pts.size(); i++) {
+          const IntPoint &p = pts[i];
+          int dx            = p.x;
+          // On odd lines, neighbors on even lines are shifted to the right
+          if (odd && parity == 1 && (p.y % 2) != 0)
+            dx += 1;
+          int off   = dx + int(padSize[0]) * (p.y + int(padSize[1]) * p.z);
+          int shift = splitAxis == 2 ? p.z : p.y;
+
+          OffsetList &list =
+              off < 0 ? causalOffsets[parity] : antiCausalOffsets[parity];
+          list.offsets.push_back(off);
+          list.shifts.push_back(shift);
+          allOffsets[parity].offsets.push_back(off);
+          allOffsets[parity].shifts.push_back(shift);
+        }
+      }
+    }
+
+    // Offsets of the neighbors in the slab, for pixels at position pos along
+    // the split axis
+    inline const vector<int> &slabOffsets(const OffsetList &list,
+                                          const Slab &slab, size_t pos,
+                                          vector<int> &buf) const
+    {
+      if (!slab.bounded ||
+          (pos >= slab.begin + maxShift && pos + maxShift < slab.end))
+        return list.offsets;
+
+      buf.clear();
+      for (size_t k = 0; k < list.offsets.size(); k++) {
+        long nbPos = long(pos) + list.shifts[k];
+        if (nbPos >= long(slab.begin) && nbPos < long(slab.end))
+          buf.push_back(list.offsets[k]);
+      }
+      return buf;
+    }
+
+    // Lines of a slab
+    inline void slabLines(const Slab &slab, size_t &y0, size_t &y1,
+                          size_t &z0, size_t &z1) const
+    {
+      y0 = 0;
+      y1 = imSize[1];
+      z0 = 0;
+      z1 = imSize[2];
+      if (splitAxis == 2) {
+        z0 = slab.begin;
+        z1 = slab.end;
+      } else {
+        y0 = slab.begin;
+        y1 = slab.end;
+      }
+    }
+
+    void copyIn(const Image<T> &imIn, const Image<T> &imMask)
+    {
+      size_t padCount = padSize[0] * padSize[1] * padSize[2];
+      marker.assign(padCount, borderValue());
+      mask.assign(padCount, borderValue());
+
+      typename ImDtTypes<T>::volType inSlices   = imIn.getSlices();
+      typename ImDtTypes<T>::volType maskSlices = imMask.getSlices();
+
+      for (size_t z = 0; z < imSize[2]; z++)
+        for (size_t y = 0; y < imSize[1]; y++) {
+          const T *in = inSlices[z][y];
+          const T *m  = maskSlices[z][y];
+          T *mk       = &marker[paddedOffset(0, y, z)];
+          T *pm       = &mask[paddedOffset(0, y, z)];
+          for (size_t x = 0; x < imSize[0]; x++) {
+            pm[x] = m[x];
+            mk[x] = limitOp(in[x], m[x]);
+          }
+        }
+    }
+
+    void copyOut(Image<T> &imOut)
+    {
+      typename ImDtTypes<T>::volType outSlices = imOut.getSlices();
+
+      for (size_t z = 0; z < imSize[2]; z++)
+        for (size_t y = 0; y < imSize[1]; y++)
+          copyLine<T>(&marker[paddedOffset(0, y, z)], imSize[0],
+                      outSlices[z][y]);
+    }
+
+    void processSlab(Slab &slab)
+    {
+      forwardScan(slab);
+      backwardScan(slab);
+      propagate(slab);
+    }
+
+    void processSlabs(size_t slabNbr)
+    {
+      vector<Slab> slabs(slabNbr);
+      for (size_t i = 0; i < slabNbr; i++) {
+        slabs[i].begin   = imSize[splitAxis] * i / slabNbr;
+        slabs[i].end     = imSize[splitAxis] * (i + 1) / slabNbr;
+        slabs[i].bounded = true;
+      }
+
+      int slabCount = int(slabNbr);
+      int i;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#endif // USE_OPEN_MP
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (i = 0; i < slabCount; i++)
+        processSlab(slabs[i]);
+
+      // Exchange the boundary values until no slab changes
+      while (true) {
+        size_t updateNbr = 0;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads) reduction(+ : updateNbr)
+#endif // USE_OPEN_MP
+        for (i = 0; i < slabCount; i++) {
+          getBoundaryUpdates(slabs[i]);
+          updateNbr += slabs[i].updates.size();
+        }
+
+        if (updateNbr == 0)
+          break;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+        for (i = 0; i < slabCount; i++) {
+          applyBoundaryUpdates(slabs[i]);
+          propagate(slabs[i]);
+        }
+      }
+    }
+
+    void forwardScan(Slab &slab)
+    {
+      size_t y0, y1, z0, z1;
+      slabLines(slab, y0, y1, z0, z1);
+      vector<int> buf;
+
+      for (size_t z = z0; z < z1; z++)
+        for (size_t y = y0; y < y1; y++) {
+          const vector<int> &offs =
+              slabOffsets(causalOffsets[lineParity(y)], slab,
+                          splitAxis == 2 ? z : y, buf);
+          const int *o  = offs.data();
+          size_t offNbr = offs.size();
+          T *mk         = &marker[paddedOffset(0, y, z)];
+          const T *m    = &mask[paddedOffset(0, y, z)];
+
+          for (size_t x = 0; x < imSize[0]; x++) {
+            T val = mk[x];
+            for (size_t k = 0; k < offNbr; k++)
+              val = propagateOp(val, mk[x + o[k]]);
+            mk[x] = limitOp(val, m[x]);
+          }
+        }
+    }
+
+    void backwardScan(Slab &slab)
+    {
+      size_t y0, y1, z0, z1;
+      slabLines(slab, y0, y1, z0, z1);
+      vector<int> buf;
+
+      for (size_t z = z1; z-- > z0;)
+        for (size_t y = y1; y-- > y0;) {
+          const vector<int> &offs =
+              slabOffsets(antiCausalOffsets[lineParity(y)], slab,
+                          splitAxis == 2 ? z : y, buf);
+          const int *o      = offs.data();
+          size_t offNbr     = offs.size();
+          size_t lineOffset = paddedOffset(0, y, z);
+          T *mk             = &marker[lineOffset];
+          const T *m        = &mask[lineOffset];
+
+          for (size_t x = imSize[0]; x-- > 0;) {
+            T val = mk[x];
+            for (size_t k = 0; k < offNbr; k++)
+              val = propagateOp(val, mk[x + o[k]]);
+            val   = limitOp(val, m[x]);
+            mk[x] = val;
+
+            // Can it still propagate its value to a neighbor after it?
+            for (size_t k = 0; k < offNbr; k++) {
+              const T &nbVal = mk[x + o[k]];
+              if (below(nbVal, val) && below(nbVal, m[x + o[k]])) {
+                slab.fifo.push(lineOffset + x);
+                break;
+              }
+            }
+          }
+        }
+    }
+
+    void propagate(Slab &slab)
+    {
+      T *mk      = marker.data();
+      const T *m = mask.data();
+      vector<int> buf;
+
+      while (!slab.fifo.empty()) {
+        size_t off = slab.fifo.front();
+        slab.fifo.pop();
+
+        size_t y   = off / padSize[0] % padSize[1] - pad[1];
+        size_t pos = splitAxis == 2
+                         ? off / (padSize[0] * padSize[1]) - pad[2]
+                         : y;
+        const vector<int> &offs =
+            slabOffsets(allOffsets[lineParity(y)], slab, pos, buf);
+        T val = mk[off];
+
+        for (size_t k = 0; k < offs.size(); k++) {
+          size_t nbOff = off + offs[k];
+          if (below(mk[nbOff], val) && mk[nbOff] != m[nbOff]) {
+            mk[nbOff] = limitOp(val, m[nbOff]);
+            slab.fifo.push(nbOff);
+          }
+        }
+      }
+    }
+
+    // Values propagated to the boundary pixels of a slab from the other
+    // slabs. Only reads the images.
+    void getBoundaryUpdates(Slab &slab)
+    {
+      slab.updates.clear();
+
+      size_t lowEnd    = min(slab.begin + maxShift, slab.end);
+      size_t highBegin = max(lowEnd, slab.end - min(maxShift, slab.end));
+
+      for (size_t pos = slab.begin; pos < slab.end; pos++) {
+        if (pos == lowEnd)
+          pos = highBegin;
+        if (pos >= slab.end)
+          break;
+
+        size_t y0 = pos, y1 = pos + 1, z0 = 0, z1 = 1;
+        if (splitAxis == 2) {
+          y0 = 0;
+          y1 = imSize[1];
+          z0 = pos;
+          z1 = pos + 1;
+        }
+
+        for (size_t z = z0; z < z1; z++)
+          for (size_t y = y0; y < y1; y++) {
+            const OffsetList &list = allOffsets[lineParity(y)];
+            size_t lineOffset      = paddedOffset(0, y, z);
+
+            for (size_t x = 0; x < imSize[0]; x++) {
+              size_t off = lineOffset + x;
+              T val      = marker[off];
+              T newVal   = val;
+
+              for (size_t k = 0; k < list.offsets.size(); k++) {
+                long nbPos = long(pos) + list.shifts[k];
+                if (nbPos < long(slab.begin) || nbPos >= long(slab.end))
+                  newVal = propagateOp(newVal, marker[off + list.offsets[k]]);
+              }
+              newVal = limitOp(newVal, mask[off]);
+              if (below(val, newVal))
+                slab.updates.push_back(make_pair(off, newVal));
+            }
+          }
+      }
+    }
+
+    void applyBoundaryUpdates(Slab &slab)
+    {
+      for (size_t i = 0; i < slab.updates.size(); i++) {
+        size_t off = slab.updates[i].first;
+        if (below(marker[off], slab.updates[i].second)) {
+          marker[off] = slab.updates[i].second;
+          slab.fifo.push(off);
+        }
+      }
+      slab.updates.clear();
+    }
+  };
   /** @endcond */
 
   /**
-   * dualBuild() - Reconstruction by erosion - dual build - (using hierarchical queues).
+   * dualBuild() - Reconstruction by erosion - dual build
    *
    * @param[in] imIn : input image
    * @param[in] imMask : mask
    * @param[out] imOut : output image
    * @param[in] se : structuring element
+   * @param[in] method : @b "hybrid" (raster scans followed by a FIFO
+   * propagation) or @b "hq" (hierarchical queue)
    */
   template <class T>
   RES_T dualBuild(const Image<T> &imIn, const Image<T> &imMask, Image<T> &imOut,
-                  const StrElt &se = DEFAULT_SE)
+                  const StrElt &se = DEFAULT_SE, string method = "hybrid")
   {
     //         if (isBinary(imIn) && isBinary(imMask))
     //           return dualBinBuild(imIn, imMask, imOut, se);
@@ -369,8 +811,17 @@ namespace smil
 
     ImageFreezer freeze(imOut);
 
+    if (method == "hybrid") {
+      HybridBuildFunc<T, true> func;
+      return func(imIn, imMask, imOut, se);
+    }
+    if (method != "hq") {
+      ERR_MSG("* Unknown method " + method);
+      return RES_ERR;
+    }
+
     Image<UINT8> imStatus(imIn);
-    HierarchicalQueue<T> pq;
+    typename HierarchicalQueueSelector<T>::type pq;
 
     // Make sure that imIn >= imMask
     ASSERT((sup(imIn, imMask, imOut) == RES_OK));
@@ -387,30 +838,42 @@ namespace smil
   }
 
   /**
-   * build() - Reconstruction by dilation (using hierarchical queues).
+   * build() - Reconstruction by dilation
    *
    * @param[in] imIn : input image
    * @param[in] imMask : mask
    * @param[out] imOut : output image
    * @param[in] se : structuring element
+   * @param[in] method : @b "hybrid" (raster scans followed by a FIFO
+   * propagation) or @b "hq" (hierarchical queue)
    */
   template <class T>
   RES_T build(const Image<T> &imIn, const Image<T> &imMask, Image<T> &imOut,
-              const StrElt &se = DEFAULT_SE)
+              const StrElt &se = DEFAULT_SE, string method = "hybrid")
   {
-    if (isBinary(imIn) && isBinary(imMask))
-      return binBuild(imIn, imMask, imOut, se);
-
     ASSERT_ALLOCATED(&imIn, &imMask, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imMask, &imOut);
 
+    if (method == "hybrid") {
+      ImageFreezer freeze(imOut);
+      HybridBuildFunc<T, false> func;
+      return func(imIn, imMask, imOut, se);
+    }
+    if (method != "hq") {
+      ERR_MSG("* Unknown method " + method);
+      return RES_ERR;
+    }
+
+    if (isBinary(imIn) && isBinary(imMask))
+      return binBuild(imIn, imMask, imOut, se, method);
+
     ImageFreezer freeze(imOut);
 
     Image<UINT8> imStatus(imIn);
 
     // Reverse hierarchical queue (the highest token corresponds to the highest
     // gray value)
-    HierarchicalQueue<T> rpq(true);
+    typename HierarchicalQueueSelector<T>::type rpq(true);
 
     // Make sure that imIn <= imMask
     ASSERT((inf(imIn, imMask, imOut) == RES_OK));
@@ -427,16 +890,18 @@ namespace smil
   }
 
   /**
-   * binBuild() - Reconstruction (using hierarchical queues).
+   * binBuild() - Reconstruction of binary images
    *
    * @param[in] imIn : input image
    * @param[in] imMask : mask
    * @param[out] imOut : output image
    * @param[in] se : structuring element
+   * @param[in] method : @b "hybrid" (raster scans followed by a FIFO
+   * propagation) or @b "hq" (hierarchical queue)
    */
   template <class T>
   RES_T binBuild(const Image<T> &imIn, const Image<T> &imMask, Image<T> &imOut,
-                 const StrElt &se = DEFAULT_SE)
+                 const StrElt &se = DEFAULT_SE, string method = "hybrid")
   {
     ASSERT_ALLOCATED(&imIn, &imMask, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imMask, &imOut);
@@ -444,11 +909,20 @@ namespace smil
     // T maxValue =  NUMERIC_LIMITS<T>::max();
     ImageFreezer freeze(imOut);
 
+    if (method == "hybrid") {
+      HybridBuildFunc<T, false> func;
+      return func(imIn, imMask, imOut, se);
+    }
+    if (method != "hq") {
+      ERR_MSG("* Unknown method " + method);
+      return RES_ERR;
+    }
+
     Image<UINT8> imStatus(imIn);
 
     // Reverse hierarchical queue (the highest token corresponds to the highest
     // gray value)
-    HierarchicalQueue<T> rpq(true);
+    typename HierarchicalQueueSelector<T>::type rpq(true);
 
     // Make sure that imIn <= imMask
     ASSERT((inf(imIn, imMask, imOut) == RES_OK));
@@ -507,23 +981,24 @@ namespace smil
    * @param[in] height : value to be subtracted to the image values
    * @param[out] imOut : output image
    * @param[in] se : structuring element
+   * @param[in] method : reconstruction method (see build())
    */
   template <class T>
   RES_T hBuild(const Image<T> &imIn, const T &height, Image<T> &imOut,
-               const StrElt &se = DEFAULT_SE)
+               const StrElt &se = DEFAULT_SE, string method = "hybrid")
   {
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
     if (&imIn == &imOut) {
-      Image<T> tmpIm = imIn;
-      return hBuild(tmpIm, height, imOut, se);
+      Image<T> tmpIm(imIn, true);
+      return hBuild(tmpIm, height, imOut, se, method);
     }
 
     ImageFreezer freeze(imOut);
 
     ASSERT((sub(imIn, T(height), imOut) == RES_OK));
-    ASSERT((build(imOut, imIn, imOut, se) == RES_OK));
+    ASSERT((build(imOut, imIn, imOut, se, method) == RES_OK));
 
     return RES_OK;
   }
@@ -537,23 +1012,24 @@ namespace smil
    * @param[in] height : value to be added to the image values
    * @param[out] imOut : output image
    * @param[in] se : structuring element
+   * @param[in] method : reconstruction method (see dualBuild())
    */
   template <class T>
   RES_T hDualBuild(const Image<T> &imIn, const T &height, Image<T> &imOut,
-                   const StrElt &se = DEFAULT_SE)
+                   const StrElt &se = DEFAULT_SE, string method = "hybrid")
   {
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
     if (&imIn == &imOut) {
-      Image<T> tmpIm = imIn;
-      return hDualBuild(tmpIm, height, imOut, se);
+      Image<T> tmpIm(imIn, true);
+      return hDualBuild(tmpIm, height, imOut, se, method);
     }
 
     ImageFreezer freeze(imOut);
 
     ASSERT((add(imIn, T(height), imOut) == RES_OK));
-    ASSERT((dualBuild(imOut, imIn, imOut, se) == RES_OK));
+    ASSERT((dualBuild(imOut, imIn, imOut, se, method) == RES_OK));
 
     return RES_OK;
   }
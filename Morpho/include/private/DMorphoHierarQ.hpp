@@ -32,8 +32,11 @@
 
 #include <queue>
 #include <deque>
+#include <stack>
+#include <algorithm>
 
 #include "Core/include/private/DTypes.hpp"
+#include "Core/include/private/DTraits.hpp"
 #include "Morpho/include/DStructuringElement.h"
 
 namespace smil
@@ -184,6 +187,20 @@ namespace smil
 
     void initialize(const Image<T> &img)
     {
+      // Stacks which don't depend on the image are kept from one call to
+      // the next: only empty them
+      if (initialized && !StackType::preallocate) {
+        if (size > 0) {
+          for (size_t i = 0; i < GRAY_LEVEL_NBR; i++)
+            while (stacks[i]->size() > 0)
+              stacks[i]->pop();
+        }
+        memset(tokenNbr, 0, GRAY_LEVEL_NBR * sizeof(size_t));
+        size        = 0;
+        higherLevel = reverseOrder ? 0 : ImDtTypes<T>::max();
+        return;
+      }
+
       if (initialized)
         reset();
 
@@ -193,8 +210,10 @@ namespace smil
       GRAY_LEVEL_MAX = ImDtTypes<T>::max();
       GRAY_LEVEL_NBR = ImDtTypes<T>::cardinal();
 
-      stacks   = new StackType *[GRAY_LEVEL_NBR]();
-      tokenNbr = new size_t[GRAY_LEVEL_NBR];
+      if (!stacks) {
+        stacks   = new StackType *[GRAY_LEVEL_NBR]();
+        tokenNbr = new size_t[GRAY_LEVEL_NBR];
+      }
 
       if (StackType::preallocate) {
         size_t *h = new size_t[GRAY_LEVEL_NBR];
@@ -302,6 +321,219 @@ namespace smil
     }
   };
 
+  /**
+   * Hierarchical queue with buckets sized after the image
+   *
+   * Same interface and ordering as HierarchicalQueue (lowest values first, or
+   * highest ones if @b reverseOrder, and FIFO among equal values), but it
+   * never allocates more than 65536 buckets, and the memory of the tokens is
+   * proportional to their number:
+   * - for 8 and 16 bits integer types, there is a bucket per gray level,
+   *   holding its tokens in a FIFO,
+   * - for wider and floating point types, buckets split the value range of the
+   *   image given to initialize() (at most one bucket per 4 pixels). The
+   *   bucket of the lowest level is kept as a binary heap on (value, push
+   *   order). Values out of the range go to the first or last bucket.
+   *
+   * Bucket buffers keep their capacity from one initialize() to the next.
+   */
+  template <class T, class TokenType = size_t> class BucketHierarchicalQueue
+  {
+  protected:
+    struct Token {
+      T value;
+      TokenType token;
+      size_t order;
+    };
+
+    // Heap order: the top is the lowest value, first pushed
+    struct TokenAfter {
+      bool reverseOrder;
+
+      inline bool operator()(const Token &a, const Token &b) const
+      {
+        if (a.value != b.value)
+          return reverseOrder ? a.value < b.value : a.value > b.value;
+        return a.order > b.order;
+      }
+    };
+
+    struct Bucket {
+      vector<Token> tokens;
+      size_t first;
+
+      Bucket() : first(0)
+      {
+      }
+    };
+
+    static const bool exactLevels = IS_INTEGER(T) && sizeof(T) <= 2;
+    static const size_t MAX_BUCKET_NBR = 65536;
+
+    vector<Bucket> buckets;
+    size_t bucketNbr;
+    size_t curBucket;
+    size_t size;
+    size_t pushNbr;
+
+    // Value range of the buckets
+    double minValue, maxValue, scale;
+
+    const bool reverseOrder;
+    TokenAfter tokenAfter;
+
+    inline size_t getBucket(T value) const
+    {
+      double level;
+      if (exactLevels)
+        level = double(value) - minValue;
+      else {
+        level = (double(value) - minValue) * scale;
+        if (!(level >= 0.))
+          level = 0.;
+        else if (level > double(bucketNbr - 1))
+          level = double(bucketNbr - 1);
+      }
+      size_t b = size_t(level);
+      return reverseOrder ? bucketNbr - 1 - b : b;
+    }
+
+    // The lowest non empty bucket becomes the current one
+    inline void findNewReferenceLevel()
+    {
+      while (buckets[curBucket].tokens.size() == buckets[curBucket].first)
+        curBucket++;
+      if (!exactLevels)
+        std::make_heap(buckets[curBucket].tokens.begin(),
+                       buckets[curBucket].tokens.end(), tokenAfter);
+    }
+
+  public:
+    BucketHierarchicalQueue(bool rOrder = false)
+        : bucketNbr(0), curBucket(0), size(0), pushNbr(0),
+          reverseOrder(rOrder)
+    {
+      tokenAfter.reverseOrder = rOrder;
+    }
+
+    void reset()
+    {
+      for (size_t i = 0; i < buckets.size(); i++) {
+        buckets[i].tokens.clear();
+        buckets[i].first = 0;
+      }
+      size    = 0;
+      pushNbr = 0;
+    }
+
+    void initialize(const Image<T> &img)
+    {
+      reset();
+
+      if (exactLevels) {
+        minValue  = double(ImDtTypes<T>::min());
+        maxValue  = double(ImDtTypes<T>::max());
+        bucketNbr = ImDtTypes<T>::cardinal();
+        scale     = 1.;
+      } else {
+        vector<T> range = rangeVal(img);
+        minValue        = double(range[0]);
+        maxValue        = double(range[1]);
+        bucketNbr       = std::max(img.getPixelCount() / 4, size_t(1));
+        bucketNbr       = std::min(bucketNbr, MAX_BUCKET_NBR);
+        // Integer values of a bucket aren't split
+        if (IS_INTEGER(T))
+          bucketNbr = size_t(std::min(double(bucketNbr),
+                                      maxValue - minValue + 1.));
+        scale = maxValue > minValue
+                    ? double(bucketNbr) / (maxValue - minValue +
+                                           (IS_INTEGER(T) ? 1. : 0.))
+                    : 0.;
+      }
+      if (buckets.size() < bucketNbr)
+        buckets.resize(bucketNbr);
+
+      curBucket = bucketNbr - 1;
+    }
+
+    inline size_t getSize()
+    {
+      return size;
+    }
+
+    inline bool isEmpty()
+    {
+      return size == 0;
+    }
+
+    //! Value of the next token
+    inline T getHigherLevel()
+    {
+      const Bucket &b = buckets[curBucket];
+      if (b.tokens.size() == b.first)
+        return reverseOrder ? ImDtTypes<T>::min() : ImDtTypes<T>::max();
+      return b.tokens[b.first].value;
+    }
+
+    inline void push(T value, TokenType token)
+    {
+      size_t b  = getBucket(value);
+      Token tok = {value, token, pushNbr++};
+      Bucket &bucket = buckets[b];
+
+      if (b < curBucket || size == 0) {
+        curBucket = b;
+        bucket.tokens.push_back(tok);
+        if (!exactLevels)
+          std::make_heap(bucket.tokens.begin(), bucket.tokens.end(),
+                         tokenAfter);
+      } else {
+        bucket.tokens.push_back(tok);
+        if (!exactLevels && b == curBucket)
+          std::push_heap(bucket.tokens.begin(), bucket.tokens.end(),
+                         tokenAfter);
+      }
+      size++;
+    }
+
+    inline TokenType pop()
+    {
+      Bucket &bucket = buckets[curBucket];
+      TokenType token;
+
+      if (exactLevels) {
+        token = bucket.tokens[bucket.first++].token;
+        if (bucket.first == bucket.tokens.size()) {
+          bucket.tokens.clear();
+          bucket.first = 0;
+        }
+      } else {
+        std::pop_heap(bucket.tokens.begin(), bucket.tokens.end(), tokenAfter);
+        token = bucket.tokens.back().token;
+        bucket.tokens.pop_back();
+      }
+
+      if (--size > 0 && bucket.tokens.size() == bucket.first)
+        findNewReferenceLevel();
+      return token;
+    }
+  };
+
+  /**
+   * Default hierarchical queue for a pixel type: HierarchicalQueue for 8 bits
+   * types, BucketHierarchicalQueue otherwise.
+   */
+  template <class T, class TokenType = size_t,
+            bool smallType = (IS_INTEGER(T) && sizeof(T) == 1)>
+  struct HierarchicalQueueSelector {
+    typedef BucketHierarchicalQueue<T, TokenType> type;
+  };
+
+  template <class T, class TokenType>
+  struct HierarchicalQueueSelector<T, TokenType, true> {
+    typedef HierarchicalQueue<T, TokenType> type;
+  };
+
   /** @}*/
 
 } // namespace smil
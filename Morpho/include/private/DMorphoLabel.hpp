@@ -39,6 +39,10 @@
 #include <map>
 #include <functional>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
 namespace smil
 {
   /**
@@ -355,6 +359,462 @@ namespace smil
     T2 max_value_label;
   };
 
+#ifdef __SSE2__
+  /*
+   * Changes of value in 16 bytes of pixels of an integer type of size
+   * bytes: bit k * size of edges() is set if pixel k differs from the
+   * previous one. Other types are scanned pixel by pixel.
+   */
+  template <int size> struct RunEdgesSSE {
+    static const bool enabled = false;
+    static inline int edges(const void * /*pixels*/)
+    {
+      return 0;
+    }
+  };
+
+  template <> struct RunEdgesSSE<1> {
+    static const bool enabled = true;
+    static inline int edges(const void *pixels)
+    {
+      const char *p = (const char *) pixels;
+      __m128i cur   = _mm_loadu_si128((const __m128i *) p);
+      __m128i prev  = _mm_loadu_si128((const __m128i *) (p - 1));
+      return ~_mm_movemask_epi8(_mm_cmpeq_epi8(cur, prev)) & 0xFFFF;
+    }
+  };
+
+  template <> struct RunEdgesSSE<2> {
+    static const bool enabled = true;
+    static inline int edges(const void *pixels)
+    {
+      const char *p = (const char *) pixels;
+      __m128i cur   = _mm_loadu_si128((const __m128i *) p);
+      __m128i prev  = _mm_loadu_si128((const __m128i *) (p - 2));
+      return ~_mm_movemask_epi8(_mm_cmpeq_epi16(cur, prev)) & 0x5555;
+    }
+  };
+
+  template <> struct RunEdgesSSE<4> {
+    static const bool enabled = true;
+    static inline int edges(const void *pixels)
+    {
+      const char *p = (const char *) pixels;
+      __m128i cur   = _mm_loadu_si128((const __m128i *) p);
+      __m128i prev  = _mm_loadu_si128((const __m128i *) (p - 4));
+      return ~_mm_movemask_epi8(_mm_cmpeq_epi32(cur, prev)) & 0x1111;
+    }
+  };
+#endif // __SSE2__
+
+  /*
+   * Run-based union-find labelling
+   *
+   * Labels the flat zones (of non zero pixels) like labelFunctGeneric, with
+   * the same label numbers (in the raster order of the first pixel of each
+   * zone), for symmetric SEs which connect horizontal neighbors:
+   * - the image is split into blocks of lines (of slices for 3D images),
+   *   one per thread,
+   * - each block extracts the runs of equal values of its lines, and unions
+   *   the runs of each line with the overlapping runs of the previous
+   *   neighbor lines which are in the block,
+   * - the runs of the first lines of each block are then merged with the
+   *   ones of the previous blocks,
+   * - a single pass over the runs numbers the components: since a run is
+   *   always attached to a run before it, the root of a component is its
+   *   first run.
+   *
+   * The runs can then be gathered into a BlobTable with getBlobTable(),
+   * without reading the label image again.
+   */
+  template <class T1, class T2> class labelFunctUnionFind
+  {
+  public:
+    // By default, one block per thread
+    labelFunctUnionFind(size_t blockNbr = 0)
+        : requestedBlockNbr(blockNbr), labelNbr(0)
+    {
+    }
+
+    size_t getLabelNbr()
+    {
+      return labelNbr;
+    }
+
+    // Run table of the components of the last labelling, blob i being the
+    // component of label i (before wrapping to the label type range)
+    void getBlobTable(BlobTable &blobs)
+    {
+      vector<PixelSequence> seqs(runs.size());
+      int lineCount = int(lineNbr);
+      int l;
+
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (l = 0; l < lineCount; l++) {
+        size_t lineOffset = size_t(l) * imSize[0];
+        for (size_t i = lineRuns[l]; i < lineRuns[l + 1]; i++)
+          seqs[i] = PixelSequence(lineOffset + runs[i].start,
+                                  runs[i].end - runs[i].start);
+      }
+
+      blobs.fill(seqs, parents, labelNbr);
+    }
+
+    // Whether the SE can be handled: symmetric, and horizontal neighbors
+    // connected on every line
+    static bool isSupported(const StrElt &se)
+    {
+      vector<IntPoint> displ[2];
+      getDisplacements(se, displ);
+      bool odd = se.odd;
+
+      for (int parity = 0; parity < 2; parity++) {
+        bool left = false, right = false;
+        for (size_t i = 0; i < displ[parity].size(); i++) {
+          const IntPoint &d = displ[parity][i];
+          if (d.y == 0 && d.z == 0) {
+            right = right || d.x == 1;
+            left  = left || d.x == -1;
+          }
+          // The opposite displacement from the neighbor line
+          const vector<IntPoint> &nbDispl =
+              displ[odd ? (parity + abs(d.y)) % 2 : 0];
+          bool found = false;
+          for (size_t j = 0; j < nbDispl.size() && !found; j++)
+            found = nbDispl[j].x == -d.x && nbDispl[j].y == -d.y &&
+                    nbDispl[j].z == -d.z;
+          if (!found)
+            return false;
+        }
+        if (!left || !right)
+          return false;
+      }
+      return true;
+    }
+
+    RES_T _exec(const Image<T1> &imIn, Image<T2> &imOut, const StrElt &se)
+    {
+      ASSERT_ALLOCATED(&imIn, &imOut);
+      ASSERT_SAME_SIZE(&imIn, &imOut);
+      ASSERT(isSupported(se), "Unsupported structuring element", RES_ERR);
+
+      imIn.getSize(imSize);
+      lineNbr = imSize[1] * imSize[2];
+      initLineNeighbors(homothety(se));
+
+      // Blocks of lines (of whole slices in 3D)
+      size_t planeNbr  = imSize[2] > 1 ? imSize[2] : imSize[1];
+      size_t planeSize = imSize[2] > 1 ? imSize[1] : 1;
+      size_t blockNbr  = requestedBlockNbr;
+#ifdef USE_OPEN_MP
+      int nthreads = Core::getInstance()->getNumberOfThreads();
+      if (blockNbr == 0)
+        blockNbr = min(size_t(nthreads), planeNbr / 4);
+#endif // USE_OPEN_MP
+      blockNbr = max(size_t(1), min(blockNbr, planeNbr));
+
+      vector<size_t> blockLines(blockNbr + 1);
+      for (size_t b = 0; b <= blockNbr; b++)
+        blockLines[b] = planeNbr * b / blockNbr * planeSize;
+
+      typename ImDtTypes<T1>::sliceType inLines = imIn.getLines();
+      typename ImDtTypes<T2>::sliceType outLines = imOut.getLines();
+
+      // Runs of each block
+      vector<vector<Run>> blockRuns(blockNbr);
+      lineRuns.assign(lineNbr + 1, 0);
+      int blockCount = int(blockNbr);
+      int b;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (b = 0; b < blockCount; b++)
+        for (size_t l = blockLines[b]; l < blockLines[b + 1]; l++)
+          lineRuns[l + 1] = extractRuns(inLines[l], blockRuns[b]);
+
+      // Index of the first run of each line
+      for (size_t l = 0; l < lineNbr; l++)
+        lineRuns[l + 1] += lineRuns[l];
+
+      runs.resize(lineRuns[lineNbr]);
+      parents.resize(runs.size());
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (b = 0; b < blockCount; b++) {
+        size_t first = lineRuns[blockLines[b]];
+        for (size_t i = 0; i < blockRuns[b].size(); i++) {
+          runs[first + i]    = blockRuns[b][i];
+          parents[first + i] = first + i;
+        }
+        vector<Run>().swap(blockRuns[b]);
+
+        for (size_t l = blockLines[b]; l < blockLines[b + 1]; l++)
+          mergeLine(l, blockLines[b], l + 1);
+      }
+
+      // Block borders: only the first lines of a block have neighbors in
+      // the previous ones
+      for (b = 1; b < blockCount; b++) {
+        size_t lastLine = min(blockLines[b + 1], blockLines[b] + maxLineDist);
+        for (size_t l = blockLines[b]; l < lastLine; l++)
+          mergeLine(l, 0, blockLines[b]);
+      }
+
+      // Number the components
+      labelNbr = 0;
+      for (size_t i = 0; i < runs.size(); i++) {
+        if (parents[i] == i)
+          parents[i] = ++labelNbr;
+        else
+          parents[i] = parents[parents[i]];
+      }
+
+      // Labels wrap around when the type is too small
+      size_t maxLabel = size_t(ImDtTypes<T2>::max()) - 1;
+      bool wrap       = labelNbr > maxLabel;
+
+      // Write the labels
+      int lineCount = int(lineNbr);
+      int l;
+
+#ifdef USE_OPEN_MP
+#pragma omp parallel for num_threads(nthreads)
+#endif // USE_OPEN_MP
+      for (l = 0; l < lineCount; l++) {
+        T2 *lineOut = outLines[l];
+        std::fill(lineOut, lineOut + imSize[0], T2(0));
+        for (size_t i = lineRuns[l]; i < lineRuns[l + 1]; i++) {
+          T2 lbl = wrap ? T2((parents[i] - 1) % maxLabel + 1) : T2(parents[i]);
+          std::fill(lineOut + runs[i].start, lineOut + runs[i].end, lbl);
+        }
+      }
+
+      return RES_OK;
+    }
+
+  protected:
+    struct Run {
+      UINT32 start, end;
+      T1 value;
+    };
+
+    // Neighbor lines before a line, and the shifts of the neighbors of a
+    // pixel in them, as intervals of consecutive shifts
+    struct LineNeighbor {
+      int dy, dz;
+      vector<int> dx[2];
+      vector<pair<int, int>> dxRanges[2];
+    };
+
+    size_t requestedBlockNbr;
+    size_t imSize[3];
+    size_t lineNbr;
+    bool oddSE;
+    vector<LineNeighbor> lineNeighbors;
+    // Number of lines between a line and its farthest previous neighbor
+    size_t maxLineDist;
+
+    vector<Run> runs;
+    vector<size_t> lineRuns;
+    // Union-find forest (a parent is always before its children), then
+    // component numbers
+    vector<size_t> parents;
+    size_t labelNbr;
+
+    // Points of the SE, scaled as in MorphImageFunctionBase
+    static StrElt homothety(const StrElt &se)
+    {
+      return se.size > 1 ? se.homothety(se.size) : se;
+    }
+
+    // Displacements of the neighbors, for even and odd lines
+    static void getDisplacements(const StrElt &se, vector<IntPoint> displ[2])
+    {
+      StrElt se2 = homothety(se);
+      for (int parity = 0; parity < 2; parity++) {
+        displ[parity].clear();
+        for (size_t i = 0; i < se2.points.size(); i++) {
+          IntPoint d = se2.points[i];
+          if (d.x == 0 && d.y == 0 && d.z == 0)
+            continue;
+          if (se2.odd && parity == 1 && (d.y % 2) != 0)
+            d.x += 1;
+          displ[parity].push_back(d);
+        }
+      }
+    }
+
+    void initLineNeighbors(const StrElt &se)
+    {
+      vector<IntPoint> displ[2];
+      getDisplacements(se, displ);
+      oddSE = se.odd;
+
+      // The SE is symmetric: only the neighbors before are needed. Runs
+      // already hold the direct horizontal neighbors, farther ones on the
+      // same line are handled as a neighbor line.
+      lineNeighbors.clear();
+      maxLineDist = 0;
+      for (int parity = 0; parity < 2; parity++)
+        for (size_t i = 0; i < displ[parity].size(); i++) {
+          const IntPoint &d = displ[parity][i];
+          if (d.z > 0 || (d.z == 0 && d.y > 0) ||
+              (d.z == 0 && d.y == 0 && d.x >= -1))
+            continue;
+          if (imSize[2] == 1 && d.z != 0)
+            continue;
+
+          size_t n = 0;
+          while (n < lineNeighbors.size() &&
+                 (lineNeighbors[n].dy != d.y || lineNeighbors[n].dz != d.z))
+            n++;
+          if (n == lineNeighbors.size()) {
+            LineNeighbor nb;
+            nb.dy = d.y;
+            nb.dz = d.z;
+            lineNeighbors.push_back(nb);
+            maxLineDist = max(maxLineDist, size_t(-d.y - d.z * int(imSize[1])));
+          }
+          lineNeighbors[n].dx[parity].push_back(d.x);
+        }
+
+      // A pixel and its neighbors at x+a, ..., x+b are merged at once
+      for (size_t n = 0; n < lineNeighbors.size(); n++)
+        for (int parity = 0; parity < 2; parity++) {
+          vector<int> &dx                   = lineNeighbors[n].dx[parity];
+          vector<pair<int, int>> &dxRanges = lineNeighbors[n].dxRanges[parity];
+          std::sort(dx.begin(), dx.end());
+          dxRanges.clear();
+          for (size_t k = 0; k < dx.size(); k++) {
+            if (!dxRanges.empty() && dx[k] <= dxRanges.back().second + 1)
+              dxRanges.back().second = max(dxRanges.back().second, dx[k]);
+            else
+              dxRanges.push_back(make_pair(dx[k], dx[k]));
+          }
+        }
+    }
+
+    // The line is cut where the value changes, and the non zero segments
+    // are kept. Changes are found 16 bytes at a time (integer types, with
+    // SSE2), then taken from the bit mask without a test per pixel.
+    size_t extractRuns(const T1 *line, vector<Run> &lineRunsOut)
+    {
+      size_t count = 0;
+      size_t w     = imSize[0];
+      size_t start = 0; // Current segment
+      size_t x     = 1;
+
+#ifdef __SSE2__
+      typedef RunEdgesSSE<numeric_limits<T1>::is_integer ? int(sizeof(T1))
+                                                         : 0>
+          edgesT;
+      if (edgesT::enabled) {
+        const size_t step = 16 / sizeof(T1);
+        for (; x + step <= w; x += step) {
+          int edges = edgesT::edges(line + x);
+          while (edges) {
+            size_t e = x + size_t(__builtin_ctz(edges)) / sizeof(T1);
+            count += addRun(line, start, e, lineRunsOut);
+            start = e;
+            edges &= edges - 1;
+          }
+        }
+      }
+#endif // __SSE2__
+
+      for (; x < w; x++)
+        if (line[x] != line[x - 1]) {
+          count += addRun(line, start, x, lineRunsOut);
+          start = x;
+        }
+      if (w > 0)
+        count += addRun(line, start, w, lineRunsOut);
+      return count;
+    }
+
+    // Keep the segment [start, end) if it isn't background
+    static inline size_t addRun(const T1 *line, size_t start, size_t end,
+                                vector<Run> &lineRunsOut)
+    {
+      if (line[start] == T1(0))
+        return 0;
+      Run run;
+      run.start = UINT32(start);
+      run.end   = UINT32(end);
+      run.value = line[start];
+      lineRunsOut.push_back(run);
+      return 1;
+    }
+
+    inline size_t findRoot(size_t i)
+    {
+      while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i          = parents[i];
+      }
+      return i;
+    }
+
+    inline void unite(size_t i, size_t j)
+    {
+      i = findRoot(i);
+      j = findRoot(j);
+      if (i < j)
+        parents[j] = i;
+      else if (j < i)
+        parents[i] = j;
+    }
+
+    // Unions of the runs of line l with the ones of its neighbor lines in
+    // [firstLine, lastLine)
+    void mergeLine(size_t l, size_t firstLine, size_t lastLine)
+    {
+      size_t y   = l % imSize[1];
+      size_t z   = l / imSize[1];
+      int parity = oddSE ? int(y % 2) : 0;
+
+      for (size_t n = 0; n < lineNeighbors.size(); n++) {
+        const LineNeighbor &nb = lineNeighbors[n];
+        long nbY               = long(y) + nb.dy;
+        long nbZ               = long(z) + nb.dz;
+        if (nbY < 0 || nbY >= long(imSize[1]) || nbZ < 0)
+          continue;
+        size_t nbLine = size_t(nbZ) * imSize[1] + size_t(nbY);
+        if (nbLine < firstLine || nbLine >= lastLine)
+          continue;
+
+        const vector<pair<int, int>> &shifts = nb.dxRanges[parity];
+        for (size_t k = 0; k < shifts.size(); k++)
+          mergeRuns(lineRuns[l], lineRuns[l + 1], lineRuns[nbLine],
+                    lineRuns[nbLine + 1], shifts[k].first, shifts[k].second);
+      }
+    }
+
+    // Pixel x of the first runs is connected to pixels x+first, ...,
+    // x+last of the second ones. The windows of consecutive first runs may
+    // overlap: each one is compared with all the second runs it meets.
+    inline void mergeRuns(size_t i, size_t iEnd, size_t j, size_t jEnd,
+                          int first, int last)
+    {
+      for (; i < iEnd; i++) {
+        const Run &r1 = runs[i];
+        long s1 = long(r1.start) + first, e1 = long(r1.end) + last;
+
+        while (j < jEnd && long(runs[j].end) <= s1)
+          j++;
+        for (size_t k = j; k < jEnd && long(runs[k].start) < e1; k++)
+          if (runs[k].value == r1.value)
+            unite(i, k);
+      }
+    }
+  };
+
   template <class T> struct lambdaEqualOperator {
     inline bool operator()(T &a, T &b)
     {
@@ -557,17 +1017,76 @@ namespace smil
     if ((void *) &imIn == (void *) &imOut) {
       // clone
       Image<T1> tmpIm(imIn, true);
-      return label(tmpIm, imOut);
+      return label(tmpIm, imOut, se);
     }
 
     ASSERT_ALLOCATED(&imIn, &imOut);
     ASSERT_SAME_SIZE(&imIn, &imOut);
 
-    labelFunctGeneric<T1, T2> f;
+    size_t lblNbr;
 
-    ASSERT((f._exec(imIn, imOut, se) == RES_OK), 0);
+    if (labelFunctUnionFind<T1, T2>::isSupported(se)) {
+      labelFunctUnionFind<T1, T2> f;
+      ASSERT((f._exec(imIn, imOut, se) == RES_OK), 0);
+      lblNbr = f.getLabelNbr();
+    } else {
+      labelFunctGeneric<T1, T2> f;
+      ASSERT((f._exec(imIn, imOut, se) == RES_OK), 0);
+      lblNbr = f.getLabelNbr();
+    }
 
-    size_t lblNbr = f.getLabelNbr();
+    if (lblNbr > size_t(ImDtTypes<T2>::max()))
+      std::cerr << "Label number exceeds data type max!" << std::endl;
+
+    return lblNbr;
+  }
+
+  /**
+   * labelWithBlobs() - Image labelization, also giving the blobs of the
+   * labels
+   *
+   * Equivalent to label() followed by computeBlobTable(), but the blobs are
+   * gathered from the runs found while labelling, without a second pass over
+   * the image.
+   *
+   * @param[in] imIn : input image
+   * @param[out] imOut : output image
+   * @param[out] blobs : run table of the connected components, blob @b i
+   * being the component of label @b i
+   * @param[in] se : structuring element
+   * @returns the number of labels (or 0 if error)
+   *
+   * @note
+   * When the label type @b T2 is too small, the labels wrap around in
+   * @b imOut. The blobs stay distinct, unless the SE is one which label()
+   * does not handle with runs.
+   */
+  template <class T1, class T2>
+  size_t labelWithBlobs(const Image<T1> &imIn, Image<T2> &imOut,
+                        BlobTable &blobs, const StrElt &se = DEFAULT_SE)
+  {
+    if ((void *) &imIn == (void *) &imOut) {
+      // clone
+      Image<T1> tmpIm(imIn, true);
+      return labelWithBlobs(tmpIm, imOut, blobs, se);
+    }
+
+    ASSERT_ALLOCATED(&imIn, &imOut);
+    ASSERT_SAME_SIZE(&imIn, &imOut);
+
+    size_t lblNbr;
+
+    if (labelFunctUnionFind<T1, T2>::isSupported(se)) {
+      labelFunctUnionFind<T1, T2> f;
+      ASSERT((f._exec(imIn, imOut, se) == RES_OK), 0);
+      f.getBlobTable(blobs);
+      lblNbr = f.getLabelNbr();
+    } else {
+      labelFunctGeneric<T1, T2> f;
+      ASSERT((f._exec(imIn, imOut, se) == RES_OK), 0);
+      ASSERT((computeBlobTable(imOut, blobs) == RES_OK), 0);
+      lblNbr = f.getLabelNbr();
+    }
 
     if (lblNbr > size_t(ImDtTypes<T2>::max()))
       std::cerr << "Label number exceeds data type max!" << std::endl;
@@ -865,26 +1384,39 @@ namespace smil
 
   /** @cond */
   template <class T1, class T2>
-  class neighborsFunct : public MorphImageFunctionBase<T1, T2>
+  class neighborsFunct
+      : public MorphNeighborhoodFunction<T1, T2, neighborsFunct<T1, T2>>
   {
   public:
-    typedef MorphImageFunctionBase<T1, T2> parentClass;
+    inline void processPixel(size_t pointOffset, const vector<int> &dOffsetList)
+    {
+      vector<T1> vals;
+      vals.reserve(dOffsetList.size());
+      processPixel(pointOffset, dOffsetList, vals);
+    }
 
-    virtual inline void processPixel(size_t pointOffset,
-                                     vector<int> &dOffsetList)
+    inline void processRun(size_t pointOffset, size_t len,
+                           const vector<int> &dOffsetList)
     {
       vector<T1> vals;
-      UINT nbrValues                = 0;
-      vector<int>::iterator dOffset = dOffsetList.begin();
+      vals.reserve(dOffsetList.size());
+      for (size_t i = 0; i < len; i++)
+        processPixel(pointOffset + i, dOffsetList, vals);
+    }
+
+  protected:
+    inline void processPixel(size_t pointOffset, const vector<int> &dOffsetList,
+                             vector<T1> &vals)
+    {
+      vals.clear();
+      vector<int>::const_iterator dOffset = dOffsetList.begin();
       while (dOffset != dOffsetList.end()) {
-        T1 val = parentClass::pixelsIn[pointOffset + *dOffset];
-        if (find(vals.begin(), vals.end(), val) == vals.end()) {
+        T1 val = this->pixelsIn[pointOffset + *dOffset];
+        if (find(vals.begin(), vals.end(), val) == vals.end())
           vals.push_back(val);
-          nbrValues++;
-        }
         dOffset++;
       }
-      parentClass::pixelsOut[pointOffset] = T2(nbrValues);
+      this->pixelsOut[pointOffset] = T2(vals.size());
     }
   };
   /** @endcond */
@@ -63,7 +63,8 @@ namespace smil
   // BEGIN BMI
 
 
-template <class T, class CriterionT, class OffsetT=size_t, class LabelT = UINT32>
+template <class T, class CriterionT, class OffsetT=size_t, class LabelT = UINT32,
+          class HQ_Type = typename HierarchicalQueueSelector<T, OffsetT>::type>
 class MaxTree2
 {
 private:
@@ -72,7 +73,7 @@ private:
     
   //    PriorityQueue<T, OffsetT> pq;
   //  HierarchicalQueue<T,size_t, STD_Queue<size_t> > &hq;
-  HierarchicalQueue<T,OffsetT> hq;
+  HQ_Type hq;
 
     T **levels;
     
@@ -404,8 +405,8 @@ public:
   // END BMI
 
 // Update criteria on a given max-tree node.// From Andres
-template <class T, class CriterionT, class OffsetT, class LabelT>
-inline void MaxTree2<T, CriterionT,OffsetT,LabelT>::updateCriteria( const int node )
+template <class T, class CriterionT, class OffsetT, class LabelT, class HQ_Type>
+inline void MaxTree2<T, CriterionT,OffsetT,LabelT,HQ_Type>::updateCriteria( const int node )
 {
   LabelT child = getChild(node);
   while ( child != 0 )
@@ -58,13 +58,15 @@ namespace smil
   /*
    * class BaseFlooding
    */
-  template <class T, class labelT, class HQ_Type = HierarchicalQueue<T>>
+  template <class T, class labelT,
+            class HQ_Type = typename HierarchicalQueueSelector<T>::type>
   class BaseFlooding
   {
   public:
     BaseFlooding() : STAT_QUEUED(ImDtTypes<labelT>::max())
     {
       pixelCount = 0;
+      imSize[0] = imSize[1] = imSize[2] = 0;
     }
     virtual ~BaseFlooding()
     {
@@ -92,6 +94,23 @@ namespace smil
     bool oddSE;
     vector<int> dOffsets;
 
+    // Geometry of the previous call: the offsets only depend on it
+    vector<IntPoint> prevSEPts;
+
+    bool sameGeometry(const size_t newSize[3], const StrElt &se) const
+    {
+      if (newSize[0] != imSize[0] || newSize[1] != imSize[1] ||
+          newSize[2] != imSize[2] || se.odd != oddSE ||
+          se.points.size() != prevSEPts.size())
+        return false;
+      for (size_t i = 0; i < prevSEPts.size(); i++) {
+        const IntPoint &p1 = se.points[i], &p2 = prevSEPts[i];
+        if (p1.x != p2.x || p1.y != p2.y || p1.z != p2.z)
+          return false;
+      }
+      return true;
+    }
+
     T currentLevel;
 
   public:
@@ -130,8 +149,15 @@ namespace smil
       lblPixels = imLbl.getPixels();
 
       pixelCount = imIn.getPixelCount();
+
+      size_t newSize[3];
+      imIn.getSize(newSize);
+      if (!dOffsets.empty() && sameGeometry(newSize, se))
+        return RES_OK;
+
       imIn.getSize(imSize);
       pixPerSlice = imSize[0] * imSize[1];
+      prevSEPts   = se.points;
 
       dOffsets.clear();
       sePts.clear();
@@ -234,7 +260,8 @@ namespace smil
   /*
    * class WatershedFlooding
    */
-  template <class T, class labelT, class HQ_Type = HierarchicalQueue<T>>
+  template <class T, class labelT,
+            class HQ_Type = typename HierarchicalQueueSelector<T>::type>
   class WatershedFlooding
 #ifndef SWIG
       : public BaseFlooding<T, labelT, HQ_Type>
@@ -243,6 +270,7 @@ namespace smil
   protected:
     vector<size_t> tmpOffsets;
     typename ImDtTypes<T>::lineType wsPixels;
+    Image<labelT> imBasins;
     const T STAT_LABELED, STAT_QUEUED, STAT_CANDIDATE, STAT_WS_LINE;
 
   public:
@@ -289,6 +317,30 @@ namespace smil
       return RES_OK;
     }
 
+    /**
+     * Watershed of a new frame, keeping the queue buffers, the neighbor
+     * offsets and the basins image from the previous call.
+     *
+     * Meant to be called on a sequence of images of the same size: nothing is
+     * reallocated between two frames. The basins are available through
+     * getBasins().
+     */
+    RES_T reflood(const Image<T> &imIn, const Image<labelT> &imMarkers,
+                  Image<T> &imOut, const StrElt &se = DEFAULT_SE)
+    {
+      ASSERT_ALLOCATED(&imIn, &imMarkers);
+      ASSERT_SAME_SIZE(&imIn, &imMarkers);
+
+      ASSERT(imBasins.setSize(imIn) == RES_OK);
+      return flood(imIn, imMarkers, imOut, imBasins, se);
+    }
+
+    //! Basins of the last reflood() call
+    Image<labelT> &getBasins()
+    {
+      return imBasins;
+    }
+
     virtual RES_T initialize(const Image<T> &imIn, Image<labelT> &imLbl,
                              Image<T> &imOut, const StrElt &se)
     {
@@ -70,7 +70,7 @@ namespace smil
     * 
     * @smilexample{custom_extinction_value.py}
     */
-    template <class T, class labelT, class extValType=UINT, class HQ_Type=HierarchicalQueue<T> >
+    template <class T, class labelT, class extValType=UINT, class HQ_Type=typename HierarchicalQueueSelector<T>::type >
     class ExtinctionFlooding 
 #ifndef SWIG    
         : public BaseFlooding<T, labelT, HQ_Type>
@@ -349,7 +349,7 @@ namespace smil
     };
 
 
-    template <class T, class labelT, class extValType=UINT, class HQ_Type=HierarchicalQueue<T> >
+    template <class T, class labelT, class extValType=UINT, class HQ_Type=typename HierarchicalQueueSelector<T>::type >
     class AreaExtinctionFlooding : public ExtinctionFlooding<T, labelT, extValType, HQ_Type>
     {
       public:
@@ -409,7 +409,7 @@ namespace smil
         }
     };
 
-    template <class T, class labelT, class extValType=UINT, class HQ_Type=HierarchicalQueue<T> >
+    template <class T, class labelT, class extValType=UINT, class HQ_Type=typename HierarchicalQueueSelector<T>::type >
     class VolumeExtinctionFlooding : public ExtinctionFlooding<T, labelT, extValType, HQ_Type>
     {
         vector<UINT> areas, volumes;
@@ -477,7 +477,7 @@ namespace smil
         
     };
 
-    template <class T, class labelT, class extValType=UINT, class HQ_Type=HierarchicalQueue<T> >
+    template <class T, class labelT, class extValType=UINT, class HQ_Type=typename HierarchicalQueueSelector<T>::type >
     class DynamicExtinctionFlooding : public AreaExtinctionFlooding<T, labelT, extValType, HQ_Type>
     {
         virtual labelT mergeBasins(const labelT &lbl1, const labelT &lbl2)
@@ -175,6 +175,7 @@ TEMPLATE_WRAP_FUNC_3T_CROSS(watershedExtinctionGraph);
 
 %include "Morpho/include/private/DMorphoLabel.hpp"
 TEMPLATE_WRAP_FUNC_2T_CROSS(label);
+TEMPLATE_WRAP_FUNC_2T_CROSS(labelWithBlobs);
 TEMPLATE_WRAP_FUNC_2T_CROSS(labelWithoutFunctor);
 TEMPLATE_WRAP_FUNC_2T_CROSS(labelWithoutFunctor2Partitions);
 TEMPLATE_WRAP_FUNC_2T_CROSS(lambdaLabel);
@@ -205,6 +206,8 @@ TEMPLATE_WRAP_FUNC(fullThick);
 
 %include "Morpho/include/private/DSkeleton.hpp"
 TEMPLATE_WRAP_FUNC(skiz);
+TEMPLATE_WRAP_FUNC(lblVoronoi);
+TEMPLATE_WRAP_FUNC(skizEuclidean);
 TEMPLATE_WRAP_FUNC(pruneSkiz);
 TEMPLATE_WRAP_FUNC(skeleton);
 TEMPLATE_WRAP_FUNC_2T_CROSS(extinctionValues);
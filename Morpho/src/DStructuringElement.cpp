@@ -28,6 +28,7 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 
 #include "Morpho/include/DStructuringElement.h"
@@ -155,6 +156,129 @@ StrElt StrElt::noCenter() const
   return se;
 }
 
+bool StrElt::decompose(StrEltDecomposition &decomp) const
+{
+  int n = size;
+
+  decomp.odd = false;
+  decomp.segments.clear();
+  decomp.elementarySEs.clear();
+
+  switch (seT) {
+    case SE_Horiz:
+      decomp.segments.push_back(StrEltSegment(IntPoint(1, 0, 0), -n, n));
+      return true;
+    case SE_Vert:
+      decomp.segments.push_back(StrEltSegment(IntPoint(0, 1, 0), -n, n));
+      return true;
+    case SE_Squ:
+      decomp.segments.push_back(StrEltSegment(IntPoint(0, 1, 0), -n, n));
+      decomp.segments.push_back(StrEltSegment(IntPoint(1, 0, 0), -n, n));
+      return true;
+    case SE_Cube:
+      decomp.segments.push_back(StrEltSegment(IntPoint(0, 1, 0), -n, n));
+      decomp.segments.push_back(StrEltSegment(IntPoint(1, 0, 0), -n, n));
+      decomp.segments.push_back(StrEltSegment(IntPoint(0, 0, 1), -n, n));
+      return true;
+    case SE_Hex: {
+      // Hexagon of size 2m   = sum of the segments of size m along the three
+      //                        directions of the grid
+      // Hexagon of size 2m+1 = hexagon + the same segments
+      int m = n / 2;
+      decomp.odd = true;
+      if (n % 2)
+        decomp.elementarySEs.push_back(HexSE());
+      if (m > 0) {
+        decomp.segments.push_back(StrEltSegment(IntPoint(1, 0, 0), -m, m));
+        decomp.segments.push_back(StrEltSegment(IntPoint(1, -1, 0), -m, m));
+        decomp.segments.push_back(StrEltSegment(IntPoint(-1, -1, 0), -m, m));
+      }
+      return true;
+    }
+    case SE_Cross: {
+      // Diamond of size 2m+1 = cross + both diagonals of size m
+      // Diamond of size 2m   = 2 crosses + both diagonals of size m-1
+      int crossNbr = n % 2 ? 1 : 2;
+      int m        = (n - crossNbr) / 2;
+      for (int i = 0; i < crossNbr; i++)
+        decomp.elementarySEs.push_back(CrossSE());
+      if (m > 0) {
+        decomp.segments.push_back(StrEltSegment(IntPoint(1, 1, 0), -m, m));
+        decomp.segments.push_back(StrEltSegment(IntPoint(1, -1, 0), -m, m));
+      }
+      return true;
+    }
+    case SE_Cross3D: {
+      // The octahedron is not a sum of segments
+      decomp.elementarySEs.assign(n, Cross3DSE());
+      return true;
+    }
+    case SE_Rhombicuboctahedron: {
+      // Same split as MorphImageFunction::_exec_rhombicuboctahedron:
+      // octahedron followed by a cube
+      double nbSquareDbl   = double(n) / (1 + sqrt(2.));
+      double nbSquareFloor = floor(nbSquareDbl);
+      int nbSquare         = (nbSquareDbl - nbSquareFloor) < 0.5f
+                                 ? int(nbSquareFloor)
+                                 : int(nbSquareFloor + 1);
+      decomp.elementarySEs.assign(max(n - nbSquare, 1), Cross3DSE());
+      if (nbSquare > 0) {
+        decomp.segments.push_back(
+            StrEltSegment(IntPoint(0, 1, 0), -nbSquare, nbSquare));
+        decomp.segments.push_back(
+            StrEltSegment(IntPoint(1, 0, 0), -nbSquare, nbSquare));
+        decomp.segments.push_back(
+            StrEltSegment(IntPoint(0, 0, 1), -nbSquare, nbSquare));
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool StrEltSegment::isAxisAligned() const
+{
+  int nonZeroNbr = (step.x != 0) + (step.y != 0) + (step.z != 0);
+  return nonZeroNbr == 1 && abs(step.x) + abs(step.y) + abs(step.z) == 1;
+}
+
+bool StrEltDecomposition::hasObliqueSegments() const
+{
+  for (vector<StrEltSegment>::const_iterator it = segments.begin();
+       it != segments.end(); it++)
+    if (!it->isAxisAligned())
+      return true;
+  return false;
+}
+
+IntPoint StrEltDecomposition::getExtent() const
+{
+  IntPoint ext(0, 0, 0);
+
+  for (vector<StrEltSegment>::const_iterator it = segments.begin();
+       it != segments.end(); it++) {
+    int k = max(abs(it->kMin), abs(it->kMax));
+    ext.x += k * abs(it->step.x);
+    ext.y += k * abs(it->step.y);
+    ext.z += k * abs(it->step.z);
+  }
+  for (vector<StrElt>::const_iterator it = elementarySEs.begin();
+       it != elementarySEs.end(); it++) {
+    IntPoint seExt(0, 0, 0);
+    for (vector<IntPoint>::const_iterator pt = it->points.begin();
+         pt != it->points.end(); pt++) {
+      seExt.x = max(seExt.x, abs(pt->x) + (it->odd ? 1 : 0));
+      seExt.y = max(seExt.y, abs(pt->y));
+      seExt.z = max(seExt.z, abs(pt->z));
+    }
+    ext.x += seExt.x;
+    ext.y += seExt.y;
+    ext.z += seExt.z;
+  }
+  return ext;
+}
+
 void StrElt::printSelf(ostream &os, string indent) const
 {
   os << indent << "Structuring Element" << endl;
@@ -54,6 +54,31 @@ class Test_Distance : public TestCase
 
         if (retVal != RES_OK)
            im2.printSelf (1); 
+
+        // Squared Euclidean distance on a volume, isotropic and with thicker
+        // slices
+        Image<UINT8> vol(512, 512, 512);
+        Image<UINT32> volDist(vol);
+        Image<float> volDistF(vol);
+        fill(vol, UINT8(255));
+        for (size_t i = 0; i < vol.getPixelCount(); i += 1013)
+          vol.getPixels()[i] = 0;
+
+        BENCH_NRUNS = 2;
+        BENCH_IMG(distanceEuclidean, vol, volDist);
+        BENCH_IMG(distanceEuclidean, vol, volDistF, 0.5, 0.5, 2.);
+
+        // Feature transform, and influence zones without flooding
+        Image<UINT32> volNearest(vol);
+        BENCH_IMG(featureTransform, vol, volDist, volNearest);
+
+        Image<UINT8> imSeeds(1024, 1024);
+        Image<UINT8> imSkiz(imSeeds);
+        fill(imSeeds, UINT8(0));
+        for (size_t i = 0; i < imSeeds.getPixelCount(); i += 4999)
+          imSeeds.getPixels()[i] = 255;
+        BENCH_IMG(inflZones, imSeeds, imSkiz);
+        BENCH_IMG(skizEuclidean, imSeeds, imSkiz);
     }
 };
 
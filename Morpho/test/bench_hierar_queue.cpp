@@ -38,6 +38,25 @@
 
 using namespace smil;
 
+// Sequence of frames of the same size, as on an acquisition line
+#define FRAME_NBR 8
+
+Image<UINT8> frames[FRAME_NBR];
+Image<UINT16> frameMarkers[FRAME_NBR];
+
+void watershedFrames(Image<UINT8> &imOut)
+{
+    for (int f=0;f<FRAME_NBR;f++)
+      watershed(frames[f], frameMarkers[f], imOut);
+}
+
+void refloodFrames(Image<UINT8> &imOut)
+{
+    static WatershedFlooding<UINT8,UINT16> flooding;
+    for (int f=0;f<FRAME_NBR;f++)
+      flooding.reflood(frames[f], frameMarkers[f], imOut);
+}
+
 int main()
 {
     Image<UINT8> im1("https://smil.cmm.minesparis.psl.eu/images/barbara.png");
@@ -51,7 +70,10 @@ int main()
     UINT BENCH_NRUNS = 50;
     
     sup(im1, UINT8(30), im2);
-    BENCH_IMG(build, im2, im1, im3);
+    BENCH_IMG_STR(build, "hybrid", im2, im1, im3, hSE(), "hybrid");
+    BENCH_IMG_STR(build, "hq", im2, im1, im3, hSE(), "hq");
+    BENCH_IMG_STR(dualBuild, "hybrid", im1, im2, im3, hSE(), "hybrid");
+    BENCH_IMG_STR(dualBuild, "hq", im1, im2, im3, hSE(), "hq");
     
     gradient(im1, im2);
     
@@ -69,6 +91,20 @@ int main()
     
     BENCH_NRUNS = 10;
     BENCH_IMG(watershedExtinction, im2, imLbl, im4);
+    
+    Image<UINT8> imFrame(1600, 1200);
+    Image<UINT8> imTmp(imFrame);
+    for (int f=0;f<FRAME_NBR;f++)
+    {
+        frames[f].setSize(imFrame);
+        frameMarkers[f].setSize(imFrame);
+        randFill(imTmp);
+        open(imTmp, frames[f], hSE(2));
+        minima(frames[f], imTmp);
+        label(imTmp, frameMarkers[f]);
+    }
+    BENCH_IMG_STR(watershedFrames, "8 frames", imFrame);
+    BENCH_IMG_STR(refloodFrames, "8 frames", imFrame);
         
 }
 
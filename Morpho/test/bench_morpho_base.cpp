@@ -54,6 +54,29 @@ int main()
     
     cout << endl;
     
+    // Large SEs (van Herk/Gil-Werman kernels and decompositions): runtime
+    // should not (or only logarithmically) depend on the size
+    // (BENCH_IMG_STR has its own loop variable: don't name ours "i")
+    UINT seSizes[] = { 1, 2, 5, 10, 20, 50, 100 };
+    UINT seSizesNbr = sizeof(seSizes)/sizeof(UINT);
+    
+    BENCH_NRUNS = 10;
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "sSE(" << seSizes[s] << ")", im1, im2, sSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(open, "sSE(" << seSizes[s] << ")", im1, im2, sSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "HorizSE(" << seSizes[s] << ")", im1, im2, HorizSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "VertSE(" << seSizes[s] << ")", im1, im2, VertSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "hSE(" << seSizes[s] << ")", im1, im2, hSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "cSE(" << seSizes[s] << ")", im1, im2, cSE(seSizes[s]));
+    BENCH_NRUNS = 1E2;
+    
+    cout << endl;
+    
     // 3D
     
     im1.setSize(500, 500, 100);
@@ -64,5 +87,25 @@ int main()
     BENCH_IMG_STR(open, "CubeSE", im1, im2, CubeSE());
     BENCH_IMG_STR(open, "Cross3DSE", im1, im2, Cross3DSE());
     BENCH_IMG_STR(open, "RhombicuboctahedronSE", im1, im2, RhombicuboctahedronSE());
+    
+    BENCH_NRUNS = 5;
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(dilate, "CubeSE(" << seSizes[s] << ")", im1, im2, CubeSE(seSizes[s]));
+    // The octahedron part is still iterated
+    for (UINT s=0;s<4;s++)
+      BENCH_IMG_STR(dilate, "RhombicuboctahedronSE(" << seSizes[s] << ")", im1, im2, RhombicuboctahedronSE(seSizes[s]));
+    
+    cout << endl;
+    
+    // Generic SEs (tiled execution) on large volumes
+    Image<UINT16> vol1(512, 512, 512);
+    Image<UINT16> vol2(vol1);
+    
+    StrElt generic_cubeSE = CubeSE();
+    generic_cubeSE.seT = SE_Generic;
+    
+    BENCH_NRUNS = 2;
+    BENCH_IMG_STR(dilate, "generic CubeSE (27 points)", vol1, vol2, generic_cubeSE);
+    BENCH_IMG_STR(erode, "generic CubeSE (27 points)", vol1, vol2, generic_cubeSE);
 }
 
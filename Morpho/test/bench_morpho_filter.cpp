@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2011-2015, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "Core/include/DCore.h"
+#include "DMorpho.h"
+
+using namespace smil;
+
+// Previous implementation (sort of the neighbor values at each pixel)
+template <class T>
+RES_T sortedRank(const Image<T> &imIn, Image<T> &imOut, double percentile, const StrElt &se)
+{
+    rankFunct<T> f(percentile);
+    return f._exec(imIn, imOut, se);
+}
+
+// Point by point mean
+template <class T>
+RES_T pointMean(const Image<T> &imIn, Image<T> &imOut, const StrElt &se)
+{
+    meanFunct<T> f;
+    return f._exec(imIn, imOut, se);
+}
+
+int main()
+{
+    Image<UINT8> im1(4096, 4096);
+    Image<UINT8> im2(im1);
+    randFill(im1);
+    
+    Image<UINT16> im3(im1);
+    Image<UINT16> im4(im1);
+    randFill(im3);
+    
+    // (BENCH_IMG_STR has its own loop variable: don't name ours "i")
+    UINT seSizes[] = { 1, 2, 3, 7 };
+    UINT seSizesNbr = sizeof(seSizes)/sizeof(UINT);
+    
+    UINT BENCH_NRUNS = 1;
+    
+    // Sliding histograms: column histograms for rectangles (UINT8),
+    // Huang's algorithm otherwise
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(median, "SquSE(" << seSizes[s] << ")", im1, im2, SquSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(median, "CrossSE(" << seSizes[s] << ")", im1, im2, CrossSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(median, "SquSE(" << seSizes[s] << ")", im3, im4, SquSE(seSizes[s]));
+    
+    cout << endl;
+    
+    // Integral image for boxes, whatever their size
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(mean, "SquSE(" << seSizes[s] << ")", im1, im2, SquSE(seSizes[s]));
+    for (UINT s=0;s<seSizesNbr;s++)
+      BENCH_IMG_STR(pointMean, "SquSE(" << seSizes[s] << ")", im1, im2, SquSE(seSizes[s]));
+    
+    cout << endl;
+    
+    // Sort based implementation
+    for (UINT s=0;s<3;s++)
+      BENCH_IMG_STR(sortedRank, "0.5 SquSE(" << seSizes[s] << ")", im1, im2, 0.5, SquSE(seSizes[s]));
+    for (UINT s=0;s<3;s++)
+      BENCH_IMG_STR(sortedRank, "0.5 SquSE(" << seSizes[s] << ")", im3, im4, 0.5, SquSE(seSizes[s]));
+}
+
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2011-2015, Matthieu FAESSEL and ARMINES
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Matthieu FAESSEL, or ARMINES nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "Core/include/DCore.h"
+#include "DMorpho.h"
+
+using namespace smil;
+
+int main()
+{
+    // 3D volume with grains, as on CT scans
+    Image<UINT8> im1(256, 256, 256);
+    Image<UINT8> im2(im1);
+    Image<UINT8> im3(im1);
+    randFill(im2);
+    open(im2, im1, CubeSE(2));
+    erode(im1, im2, CubeSE(3));
+    
+    UINT BENCH_NRUNS = 3;
+    
+    // Reconstruction with 1 to max threads (one slab per thread)
+    UINT maxThreads = Core::getInstance()->getMaxNumberOfThreads();
+    for (UINT n=1;n<=maxThreads;n*=2)
+    {
+        Core::getInstance()->setNumberOfThreads(n);
+        ostringstream str;
+        str << n << " threads";
+        BENCH_IMG_STR(build, str.str(), im2, im1, im3, CubeSE());
+        BENCH_IMG_STR(dualBuild, str.str(), im1, im2, im3, CubeSE());
+    }
+    Core::getInstance()->resetNumberOfThreads();
+    
+    BENCH_IMG_STR(build, "hq", im2, im1, im3, CubeSE(), "hq");
+}
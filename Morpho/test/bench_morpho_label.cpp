@@ -33,6 +33,30 @@
 
 using namespace smil;
 
+// Previous labelling, for comparison
+template <class T1, class T2>
+size_t genericLabel(const Image<T1> &imIn, Image<T2> &imOut, const StrElt &se)
+{
+    labelFunctGeneric<T1,T2> f;
+    f._exec(imIn, imOut, se);
+    return f.getLabelNbr();
+}
+
+// Labels, blobs and areas
+size_t labelThenBlobs(const Image<UINT8> &imIn, Image<UINT32> &imOut)
+{
+    size_t lblNbr = label(imIn, imOut, SquSE());
+    map<UINT32, Blob> blobs = computeBlobs(imOut);
+    blobsArea(blobs);
+    return lblNbr;
+}
+
+size_t fusedLabelBlobs(const Image<UINT8> &imIn, Image<UINT32> &imOut)
+{
+    BlobTable blobs;
+    return labelWithBlobs(imIn, imOut, blobs, SquSE());
+}
+
 int main()
 {
     Image<UINT8> im1(1024, 1024);
@@ -46,8 +70,22 @@ int main()
     
     UINT BENCH_NRUNS = 100;
     BENCH_IMG(label, im1, im2, CrossSE());
+    BENCH_IMG(genericLabel, im1, im2, CrossSE());
+    BENCH_IMG(label, im1, im2, SquSE());
+    BENCH_IMG(genericLabel, im1, im2, SquSE());
     BENCH_IMG(lambdaLabel, im1, UINT8(10), im2, CrossSE());
     BENCH_IMG(fastLabel, im1, im2, CrossSE());
     BENCH_IMG(labelWithArea, im1, im2, CrossSE());
+    
+    // Many small components
+    Image<UINT8> im3(2048, 2048);
+    Image<UINT32> im4(im3);
+    randFill(im3);
+    threshold(im3, UINT8(128), UINT8(255), im3);
+    BENCH_NRUNS = 10;
+    BENCH_IMG(label, im3, im4, SquSE());
+    BENCH_IMG(genericLabel, im3, im4, SquSE());
+    BENCH_IMG(labelThenBlobs, im3, im4);
+    BENCH_IMG(fusedLabelBlobs, im3, im4);
 }
 
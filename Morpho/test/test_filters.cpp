@@ -70,6 +70,16 @@ class Test_Mean : public TestCase
         imTruth.printSelf(1);
         im2.printSelf(1);
       }
+      
+      // Inplace
+      Image<UINT8> im3(23, 11, 9);
+      Image<UINT8> im4(im3);
+      Image<UINT8> im3Truth(im3);
+      randFill(im3);
+      mean(im3, im3Truth, CubeSE());
+      copy(im3, im4);
+      mean(im4, im4, CubeSE());
+      TEST_ASSERT(im4==im3Truth);
   }
 };
 
@@ -114,12 +124,133 @@ class Test_Median : public TestCase
   }
 };
 
+class Test_Rank : public TestCase
+{
+  virtual void run()
+  {
+      // Lowest and highest ranks are erosions and dilations ignoring the
+      // pixels outside the image
+      Image<UINT8> im1(23, 11, 9);
+      Image<UINT8> im2(im1);
+      Image<UINT8> imTruth(im1);
+      
+      randFill(im1);
+      
+      smil::rank(im1, im2, 0., CubeSE());
+      erode(im1, imTruth, CubeSE(), UINT8(255));
+      TEST_ASSERT(im2==imTruth);
+      
+      smil::rank(im1, im2, 0.99, SquSE(2));
+      dilate(im1, imTruth, SquSE(2), UINT8(0));
+      TEST_ASSERT(im2==imTruth);
+  }
+};
+
+class Test_RankHistogram : public TestCase
+{
+  // Compare the histogram implementations with the sort based one
+  template <class T>
+  bool compare(const Image<T> &im1, double percentile, const StrElt &se)
+  {
+      Image<T> im2(im1), im3(im1);
+      
+      smil::rank(im1, im2, percentile, se);
+      rankFunct<T> f(percentile);
+      f._exec(im1, im3, se);
+      return im2==im3;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT8> im1(301, 97, 3);
+      randFill(im1);
+      
+      TEST_ASSERT(compare(im1, 0.5, SquSE(3)));
+      TEST_ASSERT(compare(im1, 0.2, HorizSE(5)));
+      TEST_ASSERT(compare(im1, 0.7, CrossSE(2)));
+      TEST_ASSERT(compare(im1, 0.5, HexSE(2)));
+      TEST_ASSERT(compare(im1, 1., CubeSE()));
+      
+      Image<UINT16> im2(im1);
+      randFill(im2);
+      
+      TEST_ASSERT(compare(im2, 0.5, SquSE(3)));
+      TEST_ASSERT(compare(im2, 0.9, HexSE(2)));
+  }
+};
+
+class Test_MeanBox : public TestCase
+{
+  // Compare the integral image implementation with the point by point one
+  template <class T>
+  bool compare(const Image<T> &im1, const StrElt &se)
+  {
+      Image<T> im2(im1), im3(im1);
+      
+      mean(im1, im2, se);
+      meanFunct<T> f;
+      f._exec(im1, im3, se);
+      return im2==im3;
+  }
+  
+  // Floating point sums are rounded in another order
+  bool compareFloat(const Image<float> &im1, const StrElt &se)
+  {
+      Image<float> im2(im1), im3(im1);
+      
+      mean(im1, im2, se);
+      meanFunct<float> f;
+      f._exec(im1, im3, se);
+      for (size_t i=0;i<im1.getPixelCount();i++)
+        if (fabs(im2.getPixels()[i]-im3.getPixels()[i]) > 1e-3)
+          return false;
+      return true;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT8> im1(301, 97, 5);
+      randFill(im1);
+      
+      TEST_ASSERT(compare(im1, SquSE()));
+      TEST_ASSERT(compare(im1, SquSE(4)));
+      TEST_ASSERT(compare(im1, HorizSE(7)));
+      TEST_ASSERT(compare(im1, VertSE(3)));
+      TEST_ASSERT(compare(im1, CubeSE(2)));
+      
+      // Box not centered on the origin
+      StrElt se;
+      for (int y=0;y<3;y++)
+        for (int x=-1;x<4;x++)
+          se.addPoint(x, y);
+      TEST_ASSERT(compare(im1, se));
+      TEST_ASSERT(compare(im1, se(2)));
+      
+      Image<UINT16> im2(im1);
+      randFill(im2);
+      
+      TEST_ASSERT(compare(im2, SquSE(3)));
+      TEST_ASSERT(compare(im2, CubeSE()));
+      
+      // Negative and fractional values
+      Image<float> im3(im1);
+      for (size_t i=0;i<im3.getPixelCount();i++)
+        im3.getPixels()[i] = float(im2.getPixels()[i]) / 7.f - 4000.f;
+      TEST_ASSERT(compareFloat(im3, SquSE(3)));
+      TEST_ASSERT(compareFloat(im3, HorizSE(7)));
+      TEST_ASSERT(compareFloat(im3, CubeSE(2)));
+  }
+};
+
 
 int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_Mean);
       ADD_TEST(ts, Test_Median);
+      ADD_TEST(ts, Test_Rank);
+      ADD_TEST(ts, Test_RankHistogram);
+      ADD_TEST(ts, Test_MeanBox);
       
       return ts.run();
 }
@@ -61,6 +61,75 @@ class Test_HierarchicalQueue : public TestCase
   }
 };
 
+class Test_BucketHierarchicalQueue : public TestCase
+{
+  // Same interleaved pushes and pops (with values lower than the current
+  // level) in both queues
+  template <class T, class refQueueT, class queueT>
+  bool compare(const Image<T> &img, refQueueT &refQueue, queueT &queue,
+               const Image<UINT16> &refImg, T valScale)
+  {
+      refQueue.initialize(refImg);
+      queue.initialize(img);
+      
+      UINT16 *vals = refImg.getPixels();
+      size_t n = refImg.getPixelCount();
+      bool same = true;
+      
+      for (size_t k=0;k<n;k++)
+      {
+          refQueue.push(vals[k], k);
+          queue.push(T(vals[k])/valScale, k);
+          if (k%3==2)
+            same = same && refQueue.pop()==queue.pop();
+      }
+      while (!refQueue.isEmpty())
+        same = same && !queue.isEmpty() && refQueue.pop()==queue.pop();
+      return same && queue.isEmpty();
+  }
+  
+  virtual void run()
+  {
+      Image<UINT16> img16(50, 40);
+      randFill(img16);
+      Image<UINT16> img16b(img16);
+      div(img16, UINT16(500), img16b); // many equal values
+      
+      for (int r=0;r<2;r++)
+      {
+          bool reverse = r==1;
+          
+          HierarchicalQueue<UINT16> refQueue(reverse);
+          BucketHierarchicalQueue<UINT16> queue16(reverse);
+          TEST_ASSERT(compare(img16, refQueue, queue16, img16, UINT16(1)));
+          TEST_ASSERT(compare(img16b, refQueue, queue16, img16b, UINT16(1)));
+          
+          Image<UINT32> img32(img16b);
+          copy(img16b, img32);
+          BucketHierarchicalQueue<UINT32> queue32(reverse);
+          TEST_ASSERT(compare(img32, refQueue, queue32, img16b, UINT32(1)));
+          
+          // Pushed values out of the range of the initialization image
+          Image<UINT32> img32b(img32);
+          fill(img32b, UINT32(50));
+          TEST_ASSERT(compare(img32b, refQueue, queue32, img16b, UINT32(1)));
+      }
+      
+      BucketHierarchicalQueue<float> queueF;
+      queueF.initialize(Image<float>(10, 10));
+      float fVals[] = { 0.5f, 0.25f, 0.5f, 0.125f, 0.3f };
+      for (size_t k=0;k<5;k++)
+        queueF.push(fVals[k], k);
+      TEST_ASSERT(queueF.getHigherLevel()==0.125f);
+      TEST_ASSERT(queueF.pop()==3);
+      TEST_ASSERT(queueF.pop()==1);
+      TEST_ASSERT(queueF.pop()==4);
+      TEST_ASSERT(queueF.pop()==0);
+      TEST_ASSERT(queueF.pop()==2);
+      TEST_ASSERT(queueF.isEmpty());
+  }
+};
+
 class Test_InitHierarchicalQueue : public TestCase
 {
   virtual void run()
@@ -203,6 +272,7 @@ int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_HierarchicalQueue);
+      ADD_TEST(ts, Test_BucketHierarchicalQueue);
       ADD_TEST(ts, Test_InitHierarchicalQueue);
       ADD_TEST(ts, Test_Build);
       ADD_TEST(ts, Test_BinBuild);
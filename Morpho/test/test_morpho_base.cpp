@@ -586,6 +586,181 @@ class Test_Dilate_Rhombicuboctahedron : public TestCase
   }
 };
 
+class Test_VHGW : public TestCase
+{
+  // Compare the van Herk/Gil-Werman kernels with the iterated generic
+  // implementation of the same SE
+  bool compare(const Image<UINT8> &im1, const StrElt &se, UINT8 borderVal)
+  {
+      Image<UINT8> im2(im1), im3(im1);
+      
+      StrElt genSE(se);
+      genSE.seT = SE_Generic;
+      
+      dilate(im1, im2, se, borderVal);
+      dilate(im1, im3, genSE, borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      erode(im1, im2, se, borderVal);
+      erode(im1, im3, genSE, borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      // Inplace
+      copy(im1, im2);
+      dilate(im2, im2, se, borderVal);
+      dilate(im1, im3, genSE, borderVal);
+      return im2==im3;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT8> im1(37, 29);
+      randFill(im1);
+      
+      UINT sizes[] = { 2, 3, 7, 20 };
+      for (int i=0;i<4;i++)
+      {
+          UINT s = sizes[i];
+          TEST_ASSERT(compare(im1, HorizSE(s), 0));
+          TEST_ASSERT(compare(im1, VertSE(s), 0));
+          TEST_ASSERT(compare(im1, SquSE(s), 0));
+          TEST_ASSERT(compare(im1, SquSE(s), 128));
+          TEST_ASSERT(compare(im1, CubeSE(s), 0));
+      }
+      
+      TEST_ASSERT(compare(im1, HorizSE(VHGW_MIN_HORIZ_RADIUS), 0));
+      
+      Image<UINT8> im3D(13, 11, 9);
+      randFill(im3D);
+      TEST_ASSERT(compare(im3D, CubeSE(2), 0));
+      TEST_ASSERT(compare(im3D, CubeSE(5), 255));
+  }
+};
+
+class Test_GenericTiles : public TestCase
+{
+  // Generic SEs are processed tile by tile: compare with the dedicated 
+  // kernels on images spanning several tiles
+  bool compare(const Image<UINT8> &im1, const StrElt &se, UINT8 borderVal)
+  {
+      Image<UINT8> im2(im1), im3(im1);
+      
+      StrElt genSE(se);
+      genSE.seT = SE_Generic;
+      
+      dilate(im1, im2, se, borderVal);
+      dilate(im1, im3, genSE, borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      erode(im1, im2, se, borderVal);
+      erode(im1, im3, genSE, borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      // Inplace
+      copy(im1, im2);
+      erode(im2, im2, genSE, borderVal);
+      erode(im1, im3, se, borderVal);
+      return im2==im3;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT8> im1(1000, 70);
+      randFill(im1);
+      
+      TEST_ASSERT(compare(im1, SquSE(), 0));
+      TEST_ASSERT(compare(im1, SquSE(), 255));
+      TEST_ASSERT(compare(im1, HexSE(), 0));
+      TEST_ASSERT(compare(im1, CrossSE(), 128));
+      
+      Image<UINT8> im3D(1000, 40, 20);
+      randFill(im3D);
+      
+      TEST_ASSERT(compare(im3D, CubeSE(), 0));
+      TEST_ASSERT(compare(im3D, CubeSE(), 255));
+      TEST_ASSERT(compare(im3D, SquSE(), 0));
+  }
+};
+
+class Test_SEDecomposition : public TestCase
+{
+  // Compare the decomposed SE with the chain of elementary SEs it replaces
+  bool compare(const Image<UINT8> &im1, const StrElt &se, const vector<StrElt> &chain, UINT8 borderVal)
+  {
+      Image<UINT8> im2(im1), im3(im1);
+      
+      dilate(im1, im2, se, borderVal);
+      copy(im1, im3);
+      for (size_t i=0;i<chain.size();i++)
+        dilate(im3, im3, chain[i], borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      // Inplace
+      copy(im1, im2);
+      dilate(im2, im2, se, borderVal);
+      if (!(im2==im3))
+        return false;
+      
+      erode(im1, im2, se, borderVal);
+      copy(im1, im3);
+      for (size_t i=0;i<chain.size();i++)
+        erode(im3, im3, chain[i], borderVal);
+      return im2==im3;
+  }
+  
+  bool compare(const Image<UINT8> &im1, const StrElt &se, const StrElt &se1, UINT8 borderVal)
+  {
+      return compare(im1, se, vector<StrElt>(se.size, se1), borderVal);
+  }
+  
+  virtual void run()
+  {
+      StrEltDecomposition decomp;
+      
+      TEST_ASSERT(HexSE(40).decompose(decomp));
+      TEST_ASSERT(decomp.odd && decomp.segments.size()==3 && decomp.segments[2].kMax==20 && decomp.elementarySEs.empty());
+      TEST_ASSERT(CrossSE(7).decompose(decomp));
+      TEST_ASSERT(decomp.elementarySEs.size()==1 && decomp.segments.size()==2 && decomp.segments[0].kMax==3);
+      TEST_ASSERT(decomp.hasObliqueSegments());
+      TEST_ASSERT(SquSE(3).decompose(decomp));
+      TEST_ASSERT(!decomp.hasObliqueSegments());
+      TEST_ASSERT(!StrElt().decompose(decomp));
+      
+      Image<UINT8> im1(37, 29);
+      randFill(im1);
+      
+      UINT sizes[] = { 3, VHGW_MIN_CROSS_SE_SIZE, VHGW_MIN_CROSS_SE_SIZE+1, VHGW_MIN_HEX_SE_SIZE, VHGW_MIN_HEX_SE_SIZE+1, 40 };
+      for (int i=0;i<6;i++)
+      {
+          UINT s = sizes[i];
+          TEST_ASSERT(compare(im1, HexSE(s), HexSE(), 0));
+          TEST_ASSERT(compare(im1, HexSE(s), HexSE(), 128));
+          TEST_ASSERT(compare(im1, CrossSE(s), CrossSE(), 0));
+          TEST_ASSERT(compare(im1, CrossSE(s), CrossSE(), 128));
+      }
+      
+      Image<UINT8> im3D(13, 11, 9);
+      randFill(im3D);
+      
+      TEST_ASSERT(compare(im3D, CrossSE(VHGW_MIN_CROSS_SE_SIZE+1), CrossSE(), 255));
+      
+      // Octahedron (size-nbSquare) followed by a cube (nbSquare)
+      vector<StrElt> chain(1, Cross3DSE());
+      chain.push_back(CubeSE());
+      TEST_ASSERT(compare(im3D, RhombicuboctahedronSE(2), chain, 0));
+      
+      chain.assign(3, Cross3DSE());
+      chain.insert(chain.end(), 2, CubeSE());
+      TEST_ASSERT(compare(im3D, RhombicuboctahedronSE(5), chain, 0));
+      TEST_ASSERT(compare(im3D, RhombicuboctahedronSE(5), chain, 255));
+  }
+};
+
 int main()
 {
       TestSuite ts;
@@ -597,6 +772,9 @@ int main()
       ADD_TEST(ts, Test_Dilate_Squ);
       ADD_TEST(ts, Test_Dilate_3D);
       ADD_TEST(ts, Test_Dilate_Rhombicuboctahedron);
+      ADD_TEST(ts, Test_VHGW);
+      ADD_TEST(ts, Test_GenericTiles);
+      ADD_TEST(ts, Test_SEDecomposition);
       
 //       UINT BENCH_NRUNS = 5E3;
 //       Image<UINT8> im1(1024, 1024), im2(im1);
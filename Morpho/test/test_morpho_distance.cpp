@@ -118,12 +118,123 @@ class TestDistanceCross : public TestCase
   }
 };
 
+class TestDistanceEuclidean : public TestCase
+{
+  // Squared distance to the nearest zero pixel, by exhaustive search
+  template <class T>
+  bool sameAsBruteForce(const Image<UINT8> &imIn, const Image<T> &imOut,
+                        double sx, double sy, double sz, double tol)
+  {
+    size_t s[3];
+    imIn.getSize(s);
+    for (size_t z = 0; z < s[2]; z++)
+      for (size_t y = 0; y < s[1]; y++)
+        for (size_t x = 0; x < s[0]; x++) {
+          double best = -1;
+          for (size_t k = 0; k < s[2]; k++)
+            for (size_t j = 0; j < s[1]; j++)
+              for (size_t i = 0; i < s[0]; i++) {
+                if (imIn.getPixel(i, j, k) != 0)
+                  continue;
+                double dx = sx * (double(i) - x), dy = sy * (double(j) - y),
+                       dz = sz * (double(k) - z);
+                double d  = dx * dx + dy * dy + dz * dz;
+                if (best < 0 || d < best)
+                  best = d;
+              }
+          if (fabs(double(imOut.getPixel(x, y, z)) - best) > tol)
+            return false;
+        }
+    return true;
+  }
+
+  virtual void run()
+  {
+    Image<UINT8> im1(23, 19, 7);
+    fill(im1, UINT8(255));
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      if ((i * 7919) % 97 == 0)
+        im1.getPixels()[i] = 0;
+
+    Image<UINT32> im32(im1);
+    distanceEuclidean(im1, im32);
+    TEST_ASSERT(sameAsBruteForce(im1, im32, 1., 1., 1., 0.));
+
+    Image<float> imF(im1);
+    distanceEuclidean(im1, imF, 0.5, 0.7, 2.5);
+    TEST_ASSERT(sameAsBruteForce(im1, imF, 0.5, 0.7, 2.5, 1e-3));
+
+    // Saturated output
+    Image<UINT8> im8(im1);
+    distanceEuclidean(im1, im8);
+    bool saturated = true;
+    for (size_t i = 0; i < im8.getPixelCount(); i++)
+      saturated &= im8.getPixels()[i] == std::min(im32.getPixels()[i], UINT32(255));
+    TEST_ASSERT(saturated);
+
+    // 2D image, with a single zero pixel
+    Image<UINT8> im2(7, 5);
+    Image<UINT16> im16(im2);
+    fill(im2, UINT8(255));
+    im2.setPixel(1, 1, UINT8(0));
+    distanceEuclidean(im2, im16);
+    TEST_ASSERT(im16.getPixel(4, 4) == 18 && im16.getPixel(6, 0) == 26);
+  }
+};
+
+class TestFeatureTransform : public TestCase
+{
+  virtual void run()
+  {
+    Image<UINT8> im1(29, 17, 5);
+    Image<UINT32> imDist(im1);
+    Image<UINT32> imNearest(im1);
+    fill(im1, UINT8(255));
+    for (size_t i = 0; i < im1.getPixelCount(); i++)
+      if ((i * 7919) % 89 == 0)
+        im1.getPixels()[i] = 0;
+
+    featureTransform(im1, imDist, imNearest);
+
+    Image<UINT32> imTruth(im1);
+    distanceEuclidean(im1, imTruth);
+    TEST_ASSERT(imDist == imTruth);
+
+    // The nearest pixel is a zero pixel at the computed distance
+    size_t s[3];
+    im1.getSize(s);
+    bool ok = true;
+    for (size_t i = 0; i < im1.getPixelCount(); i++) {
+      size_t n = imNearest.getPixels()[i];
+      if (im1.getPixels()[i] == 0 && n != i)
+        ok = false;
+      if (n >= im1.getPixelCount() || im1.getPixels()[n] != 0) {
+        ok = false;
+        continue;
+      }
+      long dx = long(i % s[0]) - long(n % s[0]);
+      long dy = long((i / s[0]) % s[1]) - long((n / s[0]) % s[1]);
+      long dz = long(i / (s[0] * s[1])) - long(n / (s[0] * s[1]));
+      if (UINT32(dx * dx + dy * dy + dz * dz) != imDist.getPixels()[i])
+        ok = false;
+    }
+    TEST_ASSERT(ok);
+
+    // Without zero pixels
+    fill(im1, UINT8(255));
+    featureTransform(im1, imDist, imNearest);
+    TEST_ASSERT(maxVal(imNearest) == ImDtTypes<UINT32>::max() &&
+                minVal(imNearest) == ImDtTypes<UINT32>::max());
+  }
+};
 
 int main()
 {
   TestSuite ts;
   ADD_TEST(ts, TestDistanceSquare);
   ADD_TEST(ts, TestDistanceCross);      
+  ADD_TEST(ts, TestDistanceEuclidean);
+  ADD_TEST(ts, TestFeatureTransform);
   return ts.run();     
 }
 
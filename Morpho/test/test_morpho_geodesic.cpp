@@ -29,6 +29,7 @@
 
 
 #include "DMorphoGeodesic.hpp"
+#include "DMorphoFilter.hpp"
 
 using namespace smil;
 
@@ -69,11 +70,202 @@ class Test_Build : public TestCase
   }
 };
 
+// The hybrid engine must give the same results as the hierarchical queues
+template <class T>
+class Test_HybridBuild : public TestCase
+{
+  bool sameBuilds(Image<T> &imIn, Image<T> &imMask, const StrElt &se)
+  {
+      Image<T> imHQ(imIn);
+      Image<T> imHybrid(imIn);
+      bool same = true;
+      
+      build(imIn, imMask, imHQ, se, "hq");
+      build(imIn, imMask, imHybrid, se, "hybrid");
+      same = same && imHQ==imHybrid;
+      
+      dualBuild(imMask, imIn, imHQ, se, "hq");
+      dualBuild(imMask, imIn, imHybrid, se, "hybrid");
+      same = same && imHQ==imHybrid;
+      
+      hBuild(imMask, T(20), imHQ, se, "hq");
+      hBuild(imMask, T(20), imHybrid, se, "hybrid");
+      same = same && imHQ==imHybrid;
+      
+      // In place
+      copy(imMask, imHybrid);
+      hDualBuild(imHybrid, T(20), imHybrid, se);
+      hDualBuild(imMask, T(20), imHQ, se, "hq");
+      same = same && imHQ==imHybrid;
+      
+      return same;
+  }
+  
+  virtual void run()
+  {
+      Image<T> imMask(67, 45);
+      Image<T> imIn(imMask);
+      Image<T> imTmp(imMask);
+      
+      randFill(imTmp);
+      open(imTmp, imMask, hSE(2));
+      erode(imMask, imIn, hSE(3));
+      
+      TEST_ASSERT(sameBuilds(imIn, imMask, hSE()));
+      TEST_ASSERT(sameBuilds(imIn, imMask, sSE()));
+      TEST_ASSERT(sameBuilds(imIn, imMask, cSE()));
+      TEST_ASSERT(sameBuilds(imIn, imMask, hSE(2)));
+      
+      Image<T> imMask3D(23, 17, 11);
+      Image<T> imIn3D(imMask3D);
+      Image<T> imTmp3D(imMask3D);
+      
+      randFill(imTmp3D);
+      open(imTmp3D, imMask3D, CubeSE());
+      erode(imMask3D, imIn3D, CubeSE(2));
+      
+      TEST_ASSERT(sameBuilds(imIn3D, imMask3D, CubeSE()));
+      TEST_ASSERT(sameBuilds(imIn3D, imMask3D, Cross3DSE()));
+      
+      // Binary images
+      Image<T> imBinMask(imMask);
+      Image<T> imBinIn(imMask);
+      Image<T> imHQ(imMask);
+      threshold(imMask, imBinMask);
+      erode(imBinMask, imBinIn, hSE(4));
+      binBuild(imBinIn, imBinMask, imHQ, hSE(), "hq");
+      binBuild(imBinIn, imBinMask, imTmp, hSE());
+      TEST_ASSERT(imHQ==imTmp);
+      
+      TEST_ASSERT(build(imIn, imMask, imTmp, hSE(), "unknown")==RES_ERR);
+  }
+};
+
+// Zero and negative values, below the smallest positive float (operator==
+// doesn't suit float images)
+class Test_FloatBuild : public TestCase
+{
+  virtual void run()
+  {
+      Image<float> imMarker(31, 23);
+      Image<float> imMask(imMarker);
+      Image<float> imHQ(imMarker);
+      Image<float> imHybrid(imMarker);
+      
+      fill(imMask, 3.f);
+      fill(imMarker, -5.f);
+      imMarker.setPixel(10, 10, -1.f);
+      build(imMarker, imMask, imHQ, CrossSE(), "hq");
+      build(imMarker, imMask, imHybrid, CrossSE(), "hybrid");
+      TEST_ASSERT(equ(imHQ, imHybrid));
+      TEST_ASSERT(imHybrid.getPixel(0, 0)==-1.f);
+      
+      fill(imMarker, 0.f);
+      build(imMarker, imMask, imHybrid, CrossSE(), "hybrid");
+      TEST_ASSERT(imHybrid.getPixel(0, 0)==0.f);
+      
+      fill(imMarker, 5.f);
+      imMarker.setPixel(10, 10, 1.f);
+      dualBuild(imMarker, imMask, imHQ, CrossSE(), "hq");
+      dualBuild(imMarker, imMask, imHybrid, CrossSE(), "hybrid");
+      TEST_ASSERT(equ(imHQ, imHybrid));
+      TEST_ASSERT(imHybrid.getPixel(0, 0)==3.f);
+      
+      // Slab boundaries exchange the same values
+      fill(imMarker, -5.f);
+      imMarker.setPixel(10, 10, -1.f);
+      build(imMarker, imMask, imHQ, CrossSE(), "hq");
+      HybridBuildFunc<float, false> buildFunc(3);
+      buildFunc(imMarker, imMask, imHybrid, CrossSE());
+      TEST_ASSERT(equ(imHQ, imHybrid));
+  }
+};
+
+// Slabs reconstructed separately, then exchanging their boundaries
+template <class T>
+class Test_SlabBuild : public TestCase
+{
+  bool sameBuilds(Image<T> &imIn, Image<T> &imMask, const StrElt &se,
+                  size_t slabNbr)
+  {
+      Image<T> imHQ(imIn);
+      Image<T> imSlabs(imIn);
+      bool same = true;
+      
+      build(imIn, imMask, imHQ, se, "hq");
+      HybridBuildFunc<T, false> buildFunc(slabNbr);
+      buildFunc(imIn, imMask, imSlabs, se);
+      same = same && imHQ==imSlabs;
+      
+      dualBuild(imMask, imIn, imHQ, se, "hq");
+      HybridBuildFunc<T, true> dualBuildFunc(slabNbr);
+      dualBuildFunc(imMask, imIn, imSlabs, se);
+      same = same && imHQ==imSlabs;
+      
+      return same;
+  }
+  
+  virtual void run()
+  {
+      Image<T> imMask(53, 97);
+      Image<T> imIn(imMask);
+      Image<T> imTmp(imMask);
+      
+      randFill(imTmp);
+      open(imTmp, imMask, hSE(2));
+      erode(imMask, imIn, hSE(3));
+      
+      size_t slabNbrs[] = { 2, 3, 7, 97 };
+      for (int i=0;i<4;i++)
+      {
+          TEST_ASSERT(sameBuilds(imIn, imMask, hSE(), slabNbrs[i]));
+          TEST_ASSERT(sameBuilds(imIn, imMask, sSE(), slabNbrs[i]));
+          TEST_ASSERT(sameBuilds(imIn, imMask, cSE(), slabNbrs[i]));
+      }
+      
+      // Mask with a long path crossing all the slabs several times
+      Image<T> imSnake(40, 60);
+      Image<T> imSeed(imSnake);
+      fill(imSnake, T(0));
+      for (size_t x=1;x<39;x+=4)
+      {
+          drawRectangle(imSnake, x, 1, 2, 58, T(100), true);
+          drawRectangle(imSnake, x, (x/4)%2 ? 1 : 57, 5, 2, T(100), true);
+      }
+      fill(imSeed, T(0));
+      imSeed.setPixel(1, 1, T(100));
+      for (int i=0;i<4;i++)
+        TEST_ASSERT(sameBuilds(imSeed, imSnake, sSE(), slabNbrs[i]));
+      
+      Image<T> imMask3D(23, 17, 31);
+      Image<T> imIn3D(imMask3D);
+      Image<T> imTmp3D(imMask3D);
+      
+      randFill(imTmp3D);
+      open(imTmp3D, imMask3D, CubeSE());
+      erode(imMask3D, imIn3D, CubeSE(2));
+      
+      TEST_ASSERT(sameBuilds(imIn3D, imMask3D, CubeSE(), 4));
+      TEST_ASSERT(sameBuilds(imIn3D, imMask3D, Cross3DSE(), 5));
+  }
+};
+
 
 int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_Build);
+      
+      typedef Test_HybridBuild<UINT8> Test_HybridBuild_UINT8;
+      typedef Test_HybridBuild<UINT16> Test_HybridBuild_UINT16;
+      ADD_TEST(ts, Test_HybridBuild_UINT8);
+      ADD_TEST(ts, Test_HybridBuild_UINT16);
+      ADD_TEST(ts, Test_FloatBuild);
+      
+      typedef Test_SlabBuild<UINT8> Test_SlabBuild_UINT8;
+      typedef Test_SlabBuild<UINT16> Test_SlabBuild_UINT16;
+      ADD_TEST(ts, Test_SlabBuild_UINT8);
+      ADD_TEST(ts, Test_SlabBuild_UINT16);
       return ts.run();
       
 }
@@ -239,6 +239,156 @@ class Test_LabelNeighbors : public TestCase
   }
 };
 
+// Union-find labelling must give the same labels as the flooding one
+template <class T1, class T2>
+class Test_LabelUnionFind : public TestCase
+{
+  bool sameLabels(const Image<T1> &imIn, const StrElt &se, size_t blockNbr)
+  {
+      Image<T2> imGeneric(imIn);
+      Image<T2> imUF(imIn);
+      
+      labelFunctGeneric<T1,T2> fGeneric;
+      fGeneric._exec(imIn, imGeneric, se);
+      labelFunctUnionFind<T1,T2> fUF(blockNbr);
+      fUF._exec(imIn, imUF, se);
+      
+      return fGeneric.getLabelNbr()==fUF.getLabelNbr() && imGeneric==imUF;
+  }
+  
+  virtual void run()
+  {
+      // Flat zones of a few gray levels
+      Image<T1> im2D(97, 61);
+      Image<T1> imTmp(im2D);
+      randFill(imTmp);
+      div(imTmp, T1(ImDtTypes<T1>::max()/4+1), im2D);
+      
+      size_t blockNbrs[] = { 1, 2, 5, 61 };
+      for (int i=0;i<4;i++)
+      {
+          TEST_ASSERT(sameLabels(im2D, sSE(), blockNbrs[i]));
+          TEST_ASSERT(sameLabels(im2D, cSE(), blockNbrs[i]));
+          TEST_ASSERT(sameLabels(im2D, hSE(), blockNbrs[i]));
+          TEST_ASSERT(sameLabels(im2D, sSE(2), blockNbrs[i]));
+      }
+      
+      Image<T1> im3D(31, 19, 23);
+      Image<T1> imTmp3D(im3D);
+      randFill(imTmp3D);
+      div(imTmp3D, T1(ImDtTypes<T1>::max()/3+1), im3D);
+      
+      TEST_ASSERT(sameLabels(im3D, CubeSE(), 1));
+      TEST_ASSERT(sameLabels(im3D, CubeSE(), 4));
+      TEST_ASSERT(sameLabels(im3D, Cross3DSE(), 3));
+      TEST_ASSERT(sameLabels(im3D, Cross3DSE(), 23));
+      
+      // Only symmetric SEs connecting horizontal neighbors
+      typedef labelFunctUnionFind<T1,T2> ufType;
+      TEST_ASSERT(ufType::isSupported(hSE()));
+      TEST_ASSERT(ufType::isSupported(CubeSE()));
+      TEST_ASSERT(!ufType::isSupported(VertSE()));
+      TEST_ASSERT(!ufType::isSupported(StrElt(false, 2, 0, 1)));
+  }
+};
+
+// More components than label values
+class Test_LabelUnionFindOverflow : public TestCase
+{
+  virtual void run()
+  {
+      Image<UINT8> imIn(40, 40);
+      Image<UINT8> imGeneric(imIn);
+      Image<UINT8> imUF(imIn);
+      fill(imIn, UINT8(0));
+      for (size_t y=0;y<40;y+=2)
+        for (size_t x=0;x<40;x+=2)
+          imIn.setPixel(x, y, UINT8(1));
+      
+      labelFunctGeneric<UINT8,UINT8> fGeneric;
+      fGeneric._exec(imIn, imGeneric, sSE());
+      labelFunctUnionFind<UINT8,UINT8> fUF(3);
+      fUF._exec(imIn, imUF, sSE());
+      
+      TEST_ASSERT(fUF.getLabelNbr()==400);
+      TEST_ASSERT(imGeneric==imUF);
+  }
+};
+
+class Test_LabelWithBlobs : public TestCase
+{
+  // Same blobs and areas as label() followed by computeBlobs()
+  bool sameBlobs(const Image<UINT8> &imIn, const StrElt &se)
+  {
+      Image<UINT16> imLbl(imIn);
+      Image<UINT16> imFused(imIn);
+      BlobTable blobTable;
+      
+      size_t lblNbr = label(imIn, imLbl, se);
+      if (labelWithBlobs(imIn, imFused, blobTable, se)!=lblNbr)
+        return false;
+      if (!(imLbl==imFused) || blobTable.getBlobNbr()!=lblNbr)
+        return false;
+      
+      map<UINT16, Blob> blobs = computeBlobs(imLbl);
+      map<UINT16, Blob> fusedBlobs = blobTable.toBlobs<UINT16>();
+      if (blobs.size()!=fusedBlobs.size())
+        return false;
+      
+      map<UINT16, double> areas = blobsArea(blobs);
+      for (map<UINT16, Blob>::iterator it=blobs.begin();it!=blobs.end();it++)
+      {
+          vector<PixelSequence> &seqs = it->second.sequences;
+          vector<PixelSequence> &fusedSeqs = fusedBlobs[it->first].sequences;
+          if (seqs.size()!=fusedSeqs.size())
+            return false;
+          for (size_t i=0;i<seqs.size();i++)
+            if (seqs[i].offset!=fusedSeqs[i].offset || seqs[i].size!=fusedSeqs[i].size)
+              return false;
+          if (double(blobTable.areas[it->first])!=areas[it->first])
+            return false;
+      }
+      return true;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT8> im2D(57, 43);
+      randFill(im2D);
+      threshold(im2D, UINT8(100), UINT8(255), im2D);
+      
+      TEST_ASSERT(sameBlobs(im2D, sSE()));
+      TEST_ASSERT(sameBlobs(im2D, hSE()));
+      // Not handled by runs
+      TEST_ASSERT(sameBlobs(im2D, VertSE()));
+      
+      Image<UINT8> im3D(13, 11, 9);
+      randFill(im3D);
+      threshold(im3D, UINT8(170), UINT8(255), im3D);
+      TEST_ASSERT(sameBlobs(im3D, Cross3DSE()));
+      
+      // Blobs stay distinct when labels wrap around: UINT8 labels restart at
+      // 1 after 254, so blobs 1 and 255 share the label 1
+      Image<UINT8> imIn(60, 40);
+      Image<UINT8> imOut(imIn);
+      BlobTable blobTable;
+      fill(imIn, UINT8(0));
+      for (size_t y=0;y<40;y+=2)
+        for (size_t x=0;x<60;x+=4)
+          drawLine(imIn, int(x), int(y), int(x+1), int(y), UINT8(1));
+      TEST_ASSERT(labelWithBlobs(imIn, imOut, blobTable, sSE())==300);
+      TEST_ASSERT(blobTable.getBlobNbr()==300);
+      TEST_ASSERT(imOut.getPixel(0, 0)==1 && imOut.getPixel(56, 32)==1);
+      TEST_ASSERT(blobTable.blobOffsets[1]!=blobTable.blobOffsets[255]);
+      TEST_ASSERT(blobTable.areas[1]==2 && blobTable.areas[255]==2);
+      TEST_ASSERT(blobTable.sequences[blobTable.blobOffsets[1]].offset==0);
+      TEST_ASSERT(blobTable.sequences[blobTable.blobOffsets[255]].offset==32*60+56);
+      TEST_ASSERT(blobTable.areas[300]==2);
+      TEST_ASSERT(blobTable.sequences[blobTable.blobOffsets[300]].offset==38*60+56);
+      TEST_ASSERT(imOut.getPixel(56, 38)==UINT8((300-1)%254+1));
+  }
+};
+
 
 int main()
 {
@@ -249,6 +399,17 @@ int main()
       ADD_TEST(ts, Test_LabelWithArea);
       ADD_TEST(ts, Test_LabelNeighbors);
       
+      typedef Test_LabelUnionFind<UINT8,UINT16> Test_LabelUnionFind_UINT8_UINT16;
+      typedef Test_LabelUnionFind<UINT8,UINT32> Test_LabelUnionFind_UINT8_UINT32;
+      typedef Test_LabelUnionFind<UINT16,UINT32> Test_LabelUnionFind_UINT16_UINT32;
+      typedef Test_LabelUnionFind<UINT32,UINT32> Test_LabelUnionFind_UINT32_UINT32;
+      ADD_TEST(ts, Test_LabelUnionFind_UINT8_UINT16);
+      ADD_TEST(ts, Test_LabelUnionFind_UINT8_UINT32);
+      ADD_TEST(ts, Test_LabelUnionFind_UINT16_UINT32);
+      ADD_TEST(ts, Test_LabelUnionFind_UINT32_UINT32);
+      ADD_TEST(ts, Test_LabelUnionFindOverflow);
+      ADD_TEST(ts, Test_LabelWithBlobs);
+      
       return ts.run();
   
 }
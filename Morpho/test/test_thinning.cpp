@@ -30,6 +30,7 @@
 #include "Core/include/DCore.h"
 #include "DCompositeSE.h"
 #include "DHitOrMiss.hpp"
+#include "DSkeleton.hpp"
 
 using namespace smil;
 
@@ -227,12 +228,86 @@ class Test_LineJunc : public TestCase
   }
 };
 
+class Test_LblVoronoi : public TestCase
+{
+  virtual void run()
+  {
+      Image<UINT16> imLbl(9, 5);
+      Image<UINT16> imOut(imLbl);
+      Image<UINT16> imTruth(imLbl);
+
+      UINT16 vecLbl[] =
+      {
+        0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 1, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 2, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0,
+      };
+      imLbl << vecLbl;
+
+      UINT16 vecTruth[] =
+      {
+        1, 1, 1, 1, 1, 2, 2, 2, 2,
+        1, 1, 1, 1, 1, 2, 2, 2, 2,
+        1, 1, 1, 1, 2, 2, 2, 2, 2,
+        1, 1, 1, 1, 2, 2, 2, 2, 2,
+        1, 1, 1, 1, 2, 2, 2, 2, 2,
+      };
+      imTruth << vecTruth;
+
+      lblVoronoi(imLbl, imOut);
+      TEST_ASSERT(imOut==imTruth);
+      if (retVal!=RES_OK)
+        imOut.printSelf(1);
+
+      // In place
+      lblVoronoi(imLbl, imLbl);
+      TEST_ASSERT(imLbl==imTruth);
+  }
+};
+
+class Test_SkizEuclidean : public TestCase
+{
+  virtual void run()
+  {
+      Image<UINT8> im1(10, 4);
+      Image<UINT8> im2(im1);
+      Image<UINT8> imTruth(im1);
+
+      UINT8 vec1[] =
+      {
+        255, 255,   0,   0,   0,   0,   0,   0, 255, 255,
+        255, 255,   0,   0,   0,   0,   0,   0, 255, 255,
+        255, 255,   0,   0,   0,   0,   0,   0, 255, 255,
+        255, 255,   0,   0,   0,   0,   0,   0, 255, 255,
+      };
+      im1 << vec1;
+
+      UINT8 vecTruth[] =
+      {
+          0,   0,   0,   0, 255,   0,   0,   0,   0,   0,
+          0,   0,   0,   0, 255,   0,   0,   0,   0,   0,
+          0,   0,   0,   0, 255,   0,   0,   0,   0,   0,
+          0,   0,   0,   0, 255,   0,   0,   0,   0,   0,
+      };
+      imTruth << vecTruth;
+
+      skizEuclidean(im1, im2);
+      TEST_ASSERT(im2==imTruth);
+      if (retVal!=RES_OK)
+        im2.printSelf(1);
+  }
+};
+
 int main()
 {
       TestSuite ts;
       ADD_TEST(ts, Test_Thin);
       ADD_TEST(ts, Test_FullThin);
       ADD_TEST(ts, Test_LineJunc);
+      ADD_TEST(ts, Test_LblVoronoi);
+      ADD_TEST(ts, Test_SkizEuclidean);
       
       return ts.run();
 }
@@ -479,6 +479,92 @@ class Test_Watershed_Indempotence : public TestCase
 };
 
 
+// Sequence of frames with a persistent flooding object, including size and
+// SE changes between frames
+template <class dtType=UINT8>
+class Test_Reflood : public TestCase
+{
+  virtual void run()
+  {
+      WatershedFlooding<dtType,UINT16> flooding;
+      size_t sizes[] = { 40, 30, 40, 30, 25, 20, 25, 20 };
+      
+      for (int f=0;f<8;f++)
+      {
+          Image<dtType> imIn(sizes[(f/2)*2], sizes[(f/2)*2+1]);
+          Image<dtType> imTmp(imIn);
+          Image<dtType> imWs(imIn);
+          Image<dtType> imWsTruth(imIn);
+          Image<UINT16> imMark(imIn);
+          Image<UINT16> imBasinsTruth(imIn);
+          StrElt se = f%3==2 ? StrElt(sSE()) : StrElt(hSE());
+          
+          randFill(imIn);
+          open(imIn, imTmp, se);
+          minima(imTmp, imWs, se);
+          label(imWs, imMark, se);
+          
+          watershed(imTmp, imMark, imWsTruth, imBasinsTruth, se);
+          TEST_ASSERT(flooding.reflood(imTmp, imMark, imWs, se)==RES_OK);
+          
+          TEST_ASSERT(imWs==imWsTruth);
+          TEST_ASSERT(flooding.getBasins()==imBasinsTruth);
+      }
+  }
+};
+
+
+// Watersheds of UINT32 and float images, flooded with the bucketed queue,
+// against the watershed of the UINT16 image they are scaled from, flooded
+// with HierarchicalQueue
+class Test_Watershed_BucketQueue : public TestCase
+{
+  template <class T>
+  bool sameWatershed(const Image<UINT16> &im16, const Image<UINT16> &imMark,
+                     T scale, T offset, const StrElt &se)
+  {
+      Image<UINT16> imWsTruth(im16);
+      Image<UINT16> imBasinsTruth(im16);
+      WatershedFlooding<UINT16, UINT16, HierarchicalQueue<UINT16> > refFlooding;
+      refFlooding.flood(im16, imMark, imWsTruth, imBasinsTruth, se);
+      
+      Image<T> imIn(im16);
+      Image<T> imWs(imIn);
+      Image<UINT16> imBasins(im16);
+      for (size_t i=0;i<im16.getPixelCount();i++)
+        imIn.getPixels()[i] = T(im16.getPixels()[i]) * scale + offset;
+      WatershedFlooding<T, UINT16, BucketHierarchicalQueue<T> > flooding;
+      flooding.flood(imIn, imMark, imWs, imBasins, se);
+      
+      if (!(imBasins==imBasinsTruth))
+        return false;
+      for (size_t i=0;i<im16.getPixelCount();i++)
+        if ((imWs.getPixels()[i]!=0) != (imWsTruth.getPixels()[i]!=0))
+          return false;
+      return true;
+  }
+  
+  virtual void run()
+  {
+      Image<UINT16> imIn(120, 90);
+      Image<UINT16> imTmp(imIn);
+      Image<UINT16> imMin(imIn);
+      Image<UINT16> imMark(imIn);
+      
+      randFill(imIn);
+      open(imIn, imTmp, hSE());
+      minima(imTmp, imMin, hSE());
+      label(imMin, imMark, hSE());
+      
+      // Values spread over the whole UINT32 range, several per bucket
+      TEST_ASSERT(sameWatershed(imTmp, imMark, UINT32(65537), UINT32(0), hSE()));
+      TEST_ASSERT(sameWatershed(imTmp, imMark, UINT32(65537), UINT32(0), sSE()));
+      // Negative and fractional values (exact in float)
+      TEST_ASSERT(sameWatershed(imTmp, imMark, 0.125f, -1000.f, hSE()));
+      TEST_ASSERT(sameWatershed(imTmp, imMark, 0.125f, -1000.f, sSE()));
+  }
+};
+
 
 int main()
 {
@@ -496,6 +582,13 @@ int main()
       ADD_TEST(ts, Test_Watershed_Plateaus);
 
       ADD_TEST(ts, Test_Watershed_Indempotence);
+
+      typedef Test_Reflood<UINT8> Test_Reflood_UINT8;
+      typedef Test_Reflood<UINT16> Test_Reflood_UINT16;
+      ADD_TEST(ts, Test_Reflood_UINT8);
+      ADD_TEST(ts, Test_Reflood_UINT16);
+      
+      ADD_TEST(ts, Test_Watershed_BucketQueue);
       
       return ts.run();
       